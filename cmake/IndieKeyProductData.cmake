@@ -0,0 +1,223 @@
+#
+# Generates a header with the product data of an IndieKey product, so that the product data doesn't have to be decoded
+# and parsed at runtime.
+#
+# indiekey_add_product_data(<target>
+#         PRODUCT_DATA <base64 encoded product data>
+#         [NAMESPACE <namespace>]
+#         [HEADER <header name>])
+#
+# The header is generated at configure time into the binary dir and its directory is added to the include directories
+# of <target>. The header defines the product data fields as constexpr values (including the raw key bytes) inside
+# <namespace> (default: indiekey_product_data) and a getProductData() function which returns an indiekey::ProductData
+# ready to be passed to ActivationClient::setProductData.
+#
+
+# Decodes a base64 (standard alphabet, optionally padded) string into a list of byte values.
+function(_indiekey_base64_decode input out_var)
+    set(alphabet "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/")
+    string(REGEX REPLACE "[^A-Za-z0-9+/]" "" input "${input}")
+    string(LENGTH "${input}" length)
+
+    set(bytes "")
+    set(buffer 0)
+    set(bits 0)
+
+    if (length GREATER 0)
+        math(EXPR last "${length} - 1")
+        foreach (i RANGE 0 ${last})
+            string(SUBSTRING "${input}" ${i} 1 char)
+            string(FIND "${alphabet}" "${char}" value)
+            math(EXPR buffer "((${buffer} << 6) | ${value}) & 0xFFFFFF")
+            math(EXPR bits "${bits} + 6")
+            if (bits GREATER_EQUAL 8)
+                math(EXPR bits "${bits} - 8")
+                math(EXPR byte "(${buffer} >> ${bits}) & 0xFF")
+                list(APPEND bytes ${byte})
+            endif ()
+        endforeach ()
+    endif ()
+
+    set(${out_var} "${bytes}" PARENT_SCOPE)
+endfunction()
+
+# Formats a code point as a JSON \u escape, as a surrogate pair when it lies outside the basic multilingual plane.
+function(_indiekey_json_unicode_escape code_point out_var)
+    if (code_point GREATER_EQUAL 0x10000)
+        math(EXPR high "0xD800 | ((${code_point} - 0x10000) >> 10)")
+        math(EXPR low "0xDC00 | ((${code_point} - 0x10000) & 0x3FF)")
+        _indiekey_json_unicode_escape(${high} high_escape)
+        _indiekey_json_unicode_escape(${low} low_escape)
+        set(${out_var} "${high_escape}${low_escape}" PARENT_SCOPE)
+        return()
+    endif ()
+
+    math(EXPR hex "${code_point}" OUTPUT_FORMAT HEXADECIMAL)
+    string(SUBSTRING "${hex}" 2 -1 hex)
+    string(LENGTH "${hex}" length)
+    while (length LESS 4)
+        string(PREPEND hex "0")
+        math(EXPR length "${length} + 1")
+    endwhile ()
+    set(${out_var} "\\u${hex}" PARENT_SCOPE)
+endfunction()
+
+# Decodes a base64 encoded JSON document into a string. CMake can't hold arbitrary bytes in a string, so multibyte UTF-8
+# sequences (which in valid JSON only occur inside strings) are turned into \u escapes, which string(JSON) decodes.
+function(_indiekey_base64_decode_to_string input out_var)
+    _indiekey_base64_decode("${input}" bytes)
+    set(text "")
+    set(code_point 0)
+    set(remaining 0)
+    foreach (byte IN LISTS bytes)
+        if (byte LESS 0x80)
+            string(ASCII ${byte} char)
+            string(APPEND text "${char}")
+        elseif (byte LESS 0xC0)
+            math(EXPR code_point "(${code_point} << 6) | (${byte} & 0x3F)")
+            math(EXPR remaining "${remaining} - 1")
+            if (remaining EQUAL 0)
+                _indiekey_json_unicode_escape(${code_point} escape)
+                string(APPEND text "${escape}")
+            endif ()
+        elseif (byte LESS 0xE0)
+            math(EXPR code_point "${byte} & 0x1F")
+            set(remaining 1)
+        elseif (byte LESS 0xF0)
+            math(EXPR code_point "${byte} & 0x0F")
+            set(remaining 2)
+        else ()
+            math(EXPR code_point "${byte} & 0x07")
+            set(remaining 3)
+        endif ()
+    endforeach ()
+    set(${out_var} "${text}" PARENT_SCOPE)
+endfunction()
+
+# Decodes a base64 string into a C++ initializer list of hex bytes, and returns the number of bytes.
+function(_indiekey_base64_to_cpp_bytes input out_var out_size_var)
+    _indiekey_base64_decode("${input}" bytes)
+    set(hex_bytes "")
+    foreach (byte IN LISTS bytes)
+        math(EXPR hex "${byte}" OUTPUT_FORMAT HEXADECIMAL)
+        list(APPEND hex_bytes "${hex}")
+    endforeach ()
+    list(LENGTH bytes size)
+    list(JOIN hex_bytes ", " cpp_bytes)
+    set(${out_var} "${cpp_bytes}" PARENT_SCOPE)
+    set(${out_size_var} "${size}" PARENT_SCOPE)
+endfunction()
+
+# Escapes given string so it can be used inside a C++ string literal. Every byte which isn't printable ASCII (including
+# the bytes of UTF-8 sequences), and quotes and backslashes, are written as \xNN. A hex escape consumes all hex digits
+# which follow it, so the literal is split when a hex digit follows an escape.
+function(_indiekey_escape_cpp_string input out_var)
+    string(HEX "${input}" hex)
+    string(LENGTH "${hex}" length)
+    set(output "")
+    set(after_escape FALSE)
+
+    if (length GREATER 0)
+        math(EXPR last "${length} - 2")
+        foreach (i RANGE 0 ${last} 2)
+            string(SUBSTRING "${hex}" ${i} 2 byte_hex)
+            math(EXPR byte "0x${byte_hex}")
+            if (byte LESS 0x20 OR byte GREATER 0x7E OR byte EQUAL 0x22 OR byte EQUAL 0x5C)
+                string(APPEND output "\\x${byte_hex}")
+                set(after_escape TRUE)
+            else ()
+                string(ASCII ${byte} char)
+                if (after_escape AND char MATCHES "[0-9A-Fa-f]")
+                    string(APPEND output "\" \"")
+                endif ()
+                string(APPEND output "${char}")
+                set(after_escape FALSE)
+            endif ()
+        endforeach ()
+    endif ()
+
+    set(${out_var} "${output}" PARENT_SCOPE)
+endfunction()
+
+function(indiekey_add_product_data target)
+    cmake_parse_arguments(ARG "" "PRODUCT_DATA;NAMESPACE;HEADER" "" ${ARGN})
+
+    if (NOT ARG_PRODUCT_DATA)
+        message(FATAL_ERROR "indiekey_add_product_data: PRODUCT_DATA is required")
+    endif ()
+
+    if (NOT ARG_NAMESPACE)
+        set(ARG_NAMESPACE "indiekey_product_data")
+    endif ()
+
+    if (NOT ARG_HEADER)
+        set(ARG_HEADER "IndieKeyProductData.h")
+    endif ()
+
+    _indiekey_base64_decode_to_string("${ARG_PRODUCT_DATA}" json)
+
+    foreach (field organisation_name product_name product_uid primary_public_server_address
+            secondary_public_server_address)
+        string(JSON value ERROR_VARIABLE error GET "${json}" ${field})
+        if (error)
+            message(FATAL_ERROR "indiekey_add_product_data: invalid product data (${field}): ${error}")
+        endif ()
+        _indiekey_escape_cpp_string("${value}" INDIEKEY_${field})
+    endforeach ()
+
+    foreach (field verifying_key crypto_public_key)
+        string(JSON value ERROR_VARIABLE error GET "${json}" ${field})
+        if (error)
+            message(FATAL_ERROR "indiekey_add_product_data: invalid product data (${field}): ${error}")
+        endif ()
+        _indiekey_base64_to_cpp_bytes("${value}" INDIEKEY_${field} INDIEKEY_${field}_size)
+    endforeach ()
+
+    set(INDIEKEY_NAMESPACE "${ARG_NAMESPACE}")
+
+    set(output_dir "${CMAKE_CURRENT_BINARY_DIR}/indiekey_generated/${target}")
+    file(CONFIGURE
+            OUTPUT "${output_dir}/${ARG_HEADER}"
+            CONTENT [==[//
+// Generated by indiekey_add_product_data(). Do not edit.
+//
+
+#pragma once
+
+#include <indiekey/ProductData.h>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace @INDIEKEY_NAMESPACE@
+{
+
+inline constexpr std::string_view organisationName = "@INDIEKEY_organisation_name@";
+inline constexpr std::string_view productName = "@INDIEKEY_product_name@";
+inline constexpr std::string_view productUid = "@INDIEKEY_product_uid@";
+inline constexpr std::array<uint8_t, @INDIEKEY_verifying_key_size@> verifyingKey { @INDIEKEY_verifying_key@ };
+inline constexpr std::array<uint8_t, @INDIEKEY_crypto_public_key_size@> cryptoPublicKey { @INDIEKEY_crypto_public_key@ };
+inline constexpr std::string_view primaryPublicServerAddress = "@INDIEKEY_primary_public_server_address@";
+inline constexpr std::string_view secondaryPublicServerAddress = "@INDIEKEY_secondary_public_server_address@";
+
+/**
+ * @returns The product data, ready to be passed to ActivationClient::setProductData.
+ */
+inline indiekey::ProductData getProductData()
+{
+    return { std::string (organisationName),
+             std::string (productName),
+             std::string (productUid),
+             { verifyingKey.begin(), verifyingKey.end() },
+             { cryptoPublicKey.begin(), cryptoPublicKey.end() },
+             std::string (primaryPublicServerAddress),
+             std::string (secondaryPublicServerAddress) };
+}
+
+} // namespace @INDIEKEY_NAMESPACE@
+]==]
+            @ONLY)
+
+    target_include_directories(${target} PRIVATE "${output_dir}")
+endfunction()
@@ -7,6 +7,7 @@
 
 #include <vector>
 
+#include "Clock.h"
 #include "License.h"
 #include <juce_core/juce_core.h>
 #include <nlohmann/json.hpp>
@@ -39,7 +40,8 @@ public:
         std::optional<juce::Time> expiresAt,
         std::optional<juce::Time> licenseExpiresAt,
         License::Type licenseType,
-        std::vector<uint8_t> signature);
+        std::vector<uint8_t> signature,
+        std::optional<juce::RelativeTime> refreshInterval = std::nullopt);
 
     /**
      * Restores this object from given json object.
@@ -54,7 +56,7 @@ public:
     [[nodiscard]] nlohmann::json toJson() const;
 
     /**
-     * Verifies signature of this activation.
+     * Verifies signature of this activation. Requires crypto::init to have been called, which ActivationClient does.
      * @param verifyingKey The verifying key.
      * @return True if signature is valid, or false if not.
      */
@@ -72,6 +74,20 @@ public:
         const std::vector<uint8_t>& machineUid,
         const std::vector<uint8_t>& verifyingKey);
 
+    /**
+     * Validates this activation at given time. Also updates the internal status for later retrieval using getStatus().
+     * @param productUid The product uid to verify.
+     * @param machineUid The machine uid to verify.
+     * @param verifyingKey The verifying key.
+     * @param now The time to validate against.
+     * @return The activation status.
+     */
+    [[nodiscard]] Status validate (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        const std::vector<uint8_t>& verifyingKey,
+        juce::Time now);
+
     /**
      * @param status The status to get the string for.
      * @returns A string for given status.
@@ -119,17 +135,38 @@ public:
      */
     [[nodiscard]] const std::vector<uint8_t>& getSignature() const;
 
+    /**
+     * @returns The interval at which the server wants this activation to be refreshed, or nullopt if the server didn't
+     * specify one, in which case the default interval applies. Not covered by the signature.
+     */
+    [[nodiscard]] const std::optional<juce::RelativeTime>& getRefreshInterval() const;
+
     /**
      * @param other The other activation to compare against.
      * @return True if this activation is more valuable than other.
      */
     [[nodiscard]] bool isMoreValuableThan (const Activation& other) const;
 
+    /**
+     * Compares the value of two activations. Activations which are not expired are more valuable than expired ones,
+     * after that a later (or no) license expiry wins, then a later activation expiry, then the license type.
+     * @param other The other activation to compare against.
+     * @param now The time to compare at.
+     * @return True if this activation is more valuable than other at given time.
+     */
+    [[nodiscard]] bool isMoreValuableThan (const Activation& other, juce::Time now) const;
+
     /**
      * @returns True if either the activation or the license expired, or false if both are not expired.
      */
     [[nodiscard]] bool isExpired() const;
 
+    /**
+     * @param now The time to check against.
+     * @returns True if either the activation or the license expired at given time, or false if both are not expired.
+     */
+    [[nodiscard]] bool isExpired (juce::Time now) const;
+
     /**
      * @returns The most recent status after validation. If not validated the status will be Status::Undefined.
      */
@@ -145,6 +182,17 @@ public:
      */
     [[nodiscard]] std::string getSummary() const;
 
+    /**
+     * @param now The time to describe the expiry dates relative to.
+     * @returns A string with a summary of this activation.
+     */
+    [[nodiscard]] std::string getSummary (juce::Time now) const;
+
+    /**
+     * @returns An estimate of the memory in bytes held by this activation, including its own size.
+     */
+    [[nodiscard]] size_t getMemoryUsage() const;
+
 private:
     Hash hash_;
     std::string productUid_;
@@ -153,9 +201,10 @@ private:
     std::optional<juce::Time> licenseExpiresAt_;
     License::Type licenseType_ = License::Type::Undefined;
     std::vector<uint8_t> signature_;
+    std::optional<juce::RelativeTime> refreshInterval_;
     Status status_ = Status::Undefined;
 
-    static std::string expiryDateAsString (std::optional<juce::Time> expiryTime);
+    static std::string expiryDateAsString (std::optional<juce::Time> expiryTime, juce::Time now);
 };
 
 /**
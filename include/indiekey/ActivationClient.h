@@ -7,15 +7,37 @@
 
 #include "Activation.h"
 #include "ActivationsDatabase.h"
+#include "CancellationToken.h"
+#include "CircuitBreaker.h"
+#include "Clock.h"
 #include "ProductData.h"
+#include "RefreshScheduler.h"
+#include "RequestBudget.h"
 #include "RestClient.h"
+#include "SerialQueue.h"
+#include "SharedStatusCache.h"
+#include "Transport.h"
 
 #include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <condition_variable>
+#include <mutex>
 
 namespace indiekey
 {
 
-class ActivationClient
+struct OfflineRequest;
+
+/**
+ * Validates and manages the activations of a product on this machine.
+ *
+ * All functions can be called from any thread. Work which touches the network or the local activations database runs
+ * one call at a time on an internal serial queue, and identical validations which are waiting in that queue are merged.
+ * The loaded activation, its status and the product data are published as immutable snapshots, so reading them never
+ * waits for the queue.
+ */
+class ActivationClient : private RefreshScheduler::Client, private juce::AsyncUpdater
 {
 public:
     enum class ValidationStrategy
@@ -30,7 +52,13 @@ public:
         Online,
 
         /// Validate by contacting the server and update all activations.
-        ForceOnline
+        ForceOnline,
+
+        /// Validate with the locally stored activations and refresh the activations which require an update in the
+        /// background. When the locally stored activation is not valid (for example because a subscription expired
+        /// which might have been renewed in the meantime) the background refresh is awaited up to the deadline given
+        /// to validate.
+        StaleWhileRevalidate,
     };
 
     enum class TrialStatus
@@ -48,6 +76,35 @@ public:
         TrialExpired,
     };
 
+    /**
+     * Estimated memory in bytes held by a client, see getMemoryFootprint. Memory shared with other clients in the
+     * process (like the connections to the activations database) is divided over the clients sharing it.
+     */
+    struct MemoryFootprint
+    {
+        size_t database = 0;
+        size_t queryCache = 0;
+        size_t restClient = 0;
+        size_t productData = 0;
+        size_t loadedActivation = 0;
+
+        [[nodiscard]] size_t getTotal() const
+        {
+            return database + queryCache + restClient + productData + loadedActivation;
+        }
+    };
+
+    /**
+     * A request for a single product in an activation request bundle, see saveActivationRequestBundle.
+     */
+    struct BundleRequest
+    {
+        ProductData productData;
+        std::string emailAddress;
+        std::string licenseKey; // Not used for trial requests.
+        bool trial = false;
+    };
+
     /**
      * Base class for other classes that are interested in updates from an ActivationClient.
      */
@@ -57,46 +114,116 @@ public:
         virtual ~Subscriber() = default;
 
         /**
-         * Called in response to calling subscribeToActivationClient and validate and contains the currently loaded
-         * activation, or nullptr if no activation is loaded. If the latter is the case then no activations were
-         * available.
+         * Called once after the subscriber was added, and after that whenever the loaded activation changed (its
+         * hash, status, expiry or type). Validations don't notify by themselves: changes are coalesced through an
+         * AsyncUpdater and delivered on the message thread, so a burst of validations from any thread results in a
+         * single call with the state at the time of delivery. Validations which didn't change the result don't
+         * result in a call at all.
          *
-         * This function will always be called on the message thread.
-         *
-         * @param mostValuableActivation The loaded most valuable activation or nullptr of no activation is available.
-         * @package trialActivationExists True if a trial activation exists, false otherwise.
+         * @param mostValuableActivation The loaded most valuable activation, or nullptr if no activation is available.
+         * Only valid for the duration of the call, use getLoadedActivation to keep it.
          */
         virtual void onActivationsUpdated ([[maybe_unused]] const Activation* mostValuableActivation) {}
     };
 
     explicit ActivationClient();
+    ~ActivationClient() override;
 
     /**
      * Provides the product data to the activation client. This data is used to validate activations.
+     * The local activations database is not opened by this call. By default it is opened on first use, which keeps
+     * constructing plugin instances cheap (for example during plugin scans).
      * @param encodedProductData ProductData encoded as bade64 standard padded.
+     * @param openDatabaseInBackground True to start opening the local activations database on a background thread
+     * right away, so that it is likely ready by the time the first validation happens.
      */
-    void setProductData (const char* encodedProductData);
+    void setProductData (const char* encodedProductData, bool openDatabaseInBackground = false);
 
     /**
-     * @returns The currently set product data, or nullptr if no data is set/
+     * Provides already decoded product data to the activation client, for example the product data generated at build
+     * time by the indiekey_add_product_data CMake function. No decoding or parsing takes place.
+     * @param productData The product data.
+     * @param openDatabaseInBackground True to start opening the local activations database on a background thread
+     * right away.
+     */
+    void setProductData (const ProductData& productData, bool openDatabaseInBackground = false);
+
+    /**
+     * Provides already decoded product data to the activation client, and opens the local activations database with
+     * given options instead of at the default location, see getLocalActivationsDatabaseFile.
+     * @param productData The product data.
+     * @param databaseOptions The options to open the local activations database with.
+     */
+    void setProductData (const ProductData& productData, const ActivationsDatabase::Options& databaseOptions);
+
+    /**
+     * @returns The currently set product data, or nullptr if no data is set. The product data is not modified while
+     * the client exists, setProductData publishes a new copy instead.
      */
     [[nodiscard]] const ProductData* getProductData() const;
 
     /**
      * Sets device info which will be attached to activations for easier identification. This is optional and not used
      * by IndieKey itself. The result from getDefaultDeviceInfo is set as default. For offline requests this data will
-     * be encrypted.
+     * be encrypted. Online requests only carry the device info when this process didn't send the same device info to
+     * the server for the same product and machine before.
      * @param deviceInfo The device info to set.
      */
     [[maybe_unused]] void setDeviceInfo (std::optional<std::string>&& deviceInfo);
 
+    /**
+     * Sets the clock which is used for all expiry and refresh decisions, and for releasing the database when idle.
+     * Defaults to the system clock.
+     * @param clock The clock to use. Must outlive this object.
+     */
+    void setClock (const Clock& clock);
+
+    /**
+     * Sets the transport which sends the requests to the server, for example a CassetteTransport or a
+     * FaultInjectingTransport in tests. Defaults to a WebTransport.
+     * @param transport The transport to use, or nullptr to use the default.
+     */
+    void setTransport (std::shared_ptr<Transport> transport);
+
+    /**
+     * Sets the shared memory in which validation results are shared with other processes, see SharedStatusCache. Only
+     * clients using the same region take over each other's results. Defaults to the region of the current user.
+     * @param regionName The name of the region.
+     */
+    void setSharedStatusRegion (const std::string& regionName);
+
     /**
      * Invokes a validation of the most valuable activation.
+     *
+     * After the first validation the client is registered with the process wide RefreshScheduler, which refreshes the
+     * activations in the background exactly when they need an update or when the loaded activation expires.
+     * Subscribers are notified asynchronously on the message thread when such a background refresh changed the result.
+     *
+     * Update requests are limited by the process wide RequestBudget. When it is exhausted the activations are validated
+     * locally instead, see getNumThrottledRequests. The same happens when the server couldn't be reached recently, in
+     * which case the server is probed in the background until it is reachable again, see CircuitBreaker.
+     *
      * @param validationStrategy The validation strategy to use.
      * @throws std::runtime_error If an error occurs during validation.
      */
     void validate (ValidationStrategy validationStrategy);
 
+    /**
+     * Invokes a validation of the most valuable activation, spending at most the given deadline on waiting for the
+     * server. Only ValidationStrategy::StaleWhileRevalidate makes use of the deadline, other strategies behave as if
+     * validate (ValidationStrategy) was called.
+     *
+     * With ValidationStrategy::StaleWhileRevalidate this returns right away when a valid activation is stored locally.
+     * Otherwise it waits for a refresh when the activation expired or needs an update, as the server might have
+     * renewed it. The refresh keeps running in the background after the deadline passed, and subscribers are notified
+     * again only when it changes the result.
+     *
+     * @param validationStrategy The validation strategy to use.
+     * @param deadline The maximum time to wait for the server.
+     * @throws std::runtime_error If an error occurs during validation.
+     */
+    void validate (ValidationStrategy validationStrategy, juce::RelativeTime deadline);
+
     /**
      * Tries to activate the product with given email address and serial key.
      * @param emailAddress The email address.
@@ -123,15 +250,41 @@ public:
         const juce::File& fileToSaveTo,
         bool trial);
 
+    /**
+     * Saves a single request file for multiple products, so that a suite of products can be activated on another
+     * machine with one round-trip. The server answers with an activation bundle, see installActivationBundle.
+     * @param requests The requests to save, one per product.
+     * @param fileToSaveTo The file to save to. Will overwrite the file if it already exists.
+     * @param deviceInfo The device info to attach to every request, see setDeviceInfo.
+     */
+    static void saveActivationRequestBundle (
+        const std::vector<BundleRequest>& requests,
+        const juce::File& fileToSaveTo,
+        const std::optional<std::string>& deviceInfo = getDefaultDeviceInfo());
+
+    /**
+     * Installs the activations from an activation bundle, which is a file with a json array of activations. The file
+     * is parsed in a single streaming pass and the signatures are verified in parallel. The activations are saved in a
+     * single transaction: when any of them is not valid, none are installed.
+     * @param fileToLoad The file to load.
+     * @param otherProducts The product data of other products than the product of this client, of which activations
+     * should be installed as well. Activations of unknown products are skipped.
+     * @returns The number of activations installed.
+     * @throws std::runtime_error If the file can't be read or parsed, or when an activation is not valid.
+     */
+    int installActivationBundle (const juce::File& fileToLoad, const std::vector<ProductData>& otherProducts = {});
+
     /**
      * Tries to activate the software from given file. File must have been generated on the same server as the product
-     * data.
+     * data. Doesn't contact the server, see installActivation.
      * @param fileToLoad The file to load.
+     * @throws std::runtime_error If the file can't be read, is a request file, or contains an invalid activation.
      */
     void installActivationFile (const juce::File& fileToLoad);
 
     /**
-     * Tries to activate the software from given activation.
+     * Tries to activate the software from given activation. The activation is validated locally, so this works without
+     * network. Activations which need an update are refreshed later in the background.
      * @param activation The activation to install
      */
     void installActivation (indiekey::Activation&& activation);
@@ -142,6 +295,13 @@ public:
      */
     int destroyAllLocalActivations();
 
+    /**
+     * Prunes long expired activations from the local database and compacts it, see ActivationsDatabase::runMaintenance.
+     * This also happens automatically, rate limited, after background refreshes.
+     * @returns A report of the rows and bytes which were reclaimed.
+     */
+    ActivationsDatabase::MaintenanceReport runDatabaseMaintenance();
+
     /**
      * @returns The status of the trial on this machine.
      */
@@ -160,9 +320,17 @@ public:
     static const std::string& getDefaultDeviceInfo();
 
     /**
-     * @returns The currently loaded activation, or nullptr if no activation is loaded.
+     * @returns The currently loaded activation, or nullptr if no activation is loaded. The activation stays valid until
+     * the next call of this function, even when a validation on another thread replaces it.
+     * @deprecated Use getLoadedActivation, which keeps the activation alive for as long as it is used.
      */
-    [[nodiscard]] const Activation* getCurrentLoadedActivation() const;
+    [[deprecated ("Use getLoadedActivation")]] [[nodiscard]] const Activation* getCurrentLoadedActivation() const;
+
+    /**
+     * @returns A snapshot of the currently loaded activation, or nullptr if no activation is loaded. The snapshot stays
+     * valid and unchanged for as long as it is held, and can be used from any thread.
+     */
+    [[nodiscard]] std::shared_ptr<const Activation> getLoadedActivation() const;
 
     /**
      * This function returns the activation status of the client.
@@ -178,7 +346,7 @@ public:
 
     /**
      * Adds given subscriber to the list of subscribers. The subscriber will be notified when the activation client
-     * changes. Initially the subscriber will be notified with the current state.
+     * changes. Initially the subscriber will be notified asynchronously with the current state.
      * @param subscriber The Listener to add.
      */
     void addListener (Subscriber* subscriber);
@@ -189,6 +357,19 @@ public:
      */
     void removeListener (Subscriber* subscriber);
 
+    /**
+     * Estimates the memory held by this client, which is useful to check that many instances in one process (for
+     * example plugins) stay within budget. See ActivationsDatabase::MemoryBudget to limit it.
+     * @returns The memory footprint of this client, excluding the size of this object itself.
+     */
+    [[nodiscard]] MemoryFootprint getMemoryFootprint();
+
+    /**
+     * @returns The number of update requests of this client which were skipped because the RequestBudget was
+     * exhausted. See RequestBudget::getCounters for the numbers of the whole process.
+     */
+    [[nodiscard]] juce::int64 getNumThrottledRequests() const;
+
     /**
      * @param status The status to get a string for.
      * @returns A string representation of the given trial status.
@@ -196,28 +377,118 @@ public:
     static const char* trialStatusToString (TrialStatus status);
 
 private:
+    // Owned by the work queue: only accessed from tasks running on workQueue_.
     std::unique_ptr<RestClient> restClient_;
-    std::unique_ptr<ProductData> productData_;
-    juce::ListenerList<Subscriber> listeners_;
-    std::unique_ptr<Activation> mostValuableActivation_;
+    std::shared_ptr<Transport> transport_;
     ActivationsDatabase activationsDatabase_;
+    std::unique_ptr<SharedStatusCache> statusCache_; // Nullptr when the database isn't stored in a file.
+    std::string sharedStatusRegion_;                 // Empty for the region of the current user.
     std::optional<std::string> deviceInfo_ { getDefaultDeviceInfo() };
+    std::optional<bool> useFullUpdateRequests_; // Read from the database on first use, see updateActivations.
+    std::vector<std::shared_ptr<const ProductData>> replacedProductData_; // Keeps getProductData results alive.
+    mutable SerialQueue workQueue_; // Mutable so that const members can run their work on it too.
+
+    // Published by the work queue, read from anywhere through std::atomic_load.
+    std::shared_ptr<const Activation> mostValuableActivation_;
+    std::shared_ptr<const ProductData> productData_;
+    std::atomic<const Clock*> clock_ { &Clock::getSystemClock() };
+
+    // Keeps the result of the deprecated getCurrentLoadedActivation alive until its next call.
+    mutable std::mutex currentLoadedActivationMutex_;
+    mutable std::shared_ptr<const Activation> currentLoadedActivation_;
+
+    // Notification state. The listener list has its own lock, the rest is guarded by lock_.
+    juce::ListenerList<Subscriber, juce::Array<Subscriber*, juce::CriticalSection>> listeners_;
+    std::shared_ptr<const Activation> notifiedActivation_; // The activation subscribers were last notified with.
+    std::vector<Subscriber*> newSubscribers_;              // Subscribers which didn't receive the current state yet.
+    juce::CriticalSection lock_;
+    juce::SharedResourcePointer<RefreshScheduler> refreshScheduler_;
+    juce::SharedResourcePointer<RequestBudget> requestBudget_;
+    juce::SharedResourcePointer<CircuitBreaker> circuitBreaker_;
+    std::atomic<juce::int64> numThrottledRequests_ { 0 };
+    bool registeredForRefresh_ = false; // Only accessed from the work queue.
+    std::atomic<juce::int64> nextRefreshAt_ { 0 }; // In milliseconds since epoch, 0 when nothing is scheduled.
+    std::atomic<juce::int64> nextUpdateAt_ { 0 };  // Like nextRefreshAt_, but when an activation needs an update.
+    int numFailedRefreshes_ = 0;                   // Only accessed from the work queue.
+    juce::int64 lastRefreshAt_ = 0;                // Only accessed from the work queue, 0 before the first refresh.
+    std::mutex refreshMutex_;
+    std::condition_variable refreshCompleted_;
+    juce::int64 numCompletedRefreshes_ = 0;       // Guarded by refreshMutex_.
+    mutable CancellationToken cancellationToken_; // Cancelled by the destructor.
+
+    static constexpr int kMaxRefreshBackoffMinutes = 60;
+    static constexpr int kMinRefreshIntervalSeconds = 60; // Between two background refreshes of a client.
+
+    /// After a server didn't support update requests by hash, they are tried again after this time.
+    static constexpr int kUpdateByHashRetryDays = 30;
+
+    /// When the database was locked by another process, it is read again after this time.
+    static constexpr int kBusyRetrySeconds = 1;
+    static constexpr size_t kMaxBundleVerificationThreads = 8;
+
+    static const std::vector<uint8_t>& getUniqueMachineId();
+    static const std::string& getUniqueMachineIdAsBase64();
+    static OfflineRequest createOfflineRequest (
+        const BundleRequest& request,
+        const std::optional<std::string>& deviceInfo);
 
-    // TODO: Reuse the machine id in some way.
-    static std::vector<uint8_t> getUniqueMachineId();
-    // TODO: Reuse the machine id in some way.
-    static std::string getUniqueMachineIdAsBase64();
+    /**
+     * @returns The device info to include in an online request, or nullopt if the server already received it.
+     */
+    [[nodiscard]] std::optional<std::string> getDeviceInfoToSend() const;
 
-    void updateActivations (ValidationStrategy validationStrategy);
-    std::vector<Activation> getAllActivationsWhichNeedToBeUpdated (bool forceUpdate);
+    /**
+     * Remembers that the server received given device info for the product of this client, for all clients in this
+     * process.
+     */
+    void setDeviceInfoSent (const std::optional<std::string>& deviceInfo) const;
 
     /**
-     * @returns Runs through given vector and returns iterator to the most valuable activation, or a past-the-end
-     * iterator if no activation is available.
+     * @returns The key under which the device info sent for this client is remembered.
      */
-    std::vector<Activation>::const_iterator findMostValuableActivation (const std::vector<Activation>& activations);
+    [[nodiscard]] std::string getSentDeviceInfoKey() const;
+
+    /**
+     * Posts to the server and reports to the circuit breaker whether the server could be reached.
+     * @param isNotFoundReported False to report nothing when the server answers 404, for endpoints the server might
+     * not support yet.
+     */
+    RestClient::Response postToServer (
+        juce::StringRef path,
+        const nlohmann::json& postData,
+        bool isNotFoundReported = true);
+
+    /**
+     * Sends a ping to the server when the circuit breaker asks for a probe.
+     */
+    void probeServerIfDue (juce::Time now);
+
+    void validateWithoutNotifying (ValidationStrategy validationStrategy);
+    void updateActivations (ValidationStrategy validationStrategy, juce::Time now);
+    void scheduleNextRefresh (juce::Time now, std::optional<juce::Time> nextUpdateTime);
+
+    /**
+     * Removes the result other processes took over from this client, which must be done after changing activations.
+     * @param productUid The product of which the activations changed.
+     */
+    void invalidateSharedStatus (const std::string& productUid);
+    void notifySubscribersIfChanged();
+    void refreshInBackground (juce::Time now, std::optional<juce::RelativeTime> deadline);
+    static bool isSameResult (const Activation* a, const Activation* b);
+    std::vector<Activation> getAllActivationsWhichNeedToBeUpdated (bool forceUpdate, juce::Time now);
 
     void throwIfProductDataIsNotSet() const;
+    [[nodiscard]] const Clock& getClock() const;
+    static juce::File getLocalActivationsDatabaseFile (const ProductData& productData);
+
+    // RefreshScheduler::Client
+    std::optional<juce::RelativeTime> getTimeUntilNextRefresh() override;
+    void refresh() override;
+    std::optional<juce::RelativeTime> getTimeUntilIdle() override;
+    void releaseIdleResources() override;
+
+    // juce::AsyncUpdater
+    void handleAsyncUpdate() override;
 };
 
 } // namespace indiekey
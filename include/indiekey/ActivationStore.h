@@ -0,0 +1,214 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "Activation.h"
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace indiekey
+{
+
+/**
+ * Interface for the storage behind ActivationsDatabase. All implementations must behave identically, which is verified
+ * by the conformance tests in ActivationStore.test.cpp.
+ */
+class ActivationStore
+{
+public:
+    /// The maximum fraction by which the refresh interval is shortened for a machine.
+    static constexpr double kMaxRefreshJitter = 0.5;
+
+    /// Refresh interval for activations for which the server didn't specify one.
+    static constexpr int kDefaultRefreshIntervalHours = 24;
+
+    /// The time after expiry at which activations are removed by runMaintenance.
+    static constexpr int kPruneRetentionDays = 90;
+
+    /// The minimum time between two maintenance runs.
+    static constexpr int kMaintenanceIntervalDays = 7;
+
+    /**
+     * Thrown by queries when the storage is locked by a writer for longer than a reader may wait, so that callers can
+     * fall back to state they already have instead of blocking.
+     */
+    class BusyError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * Summary of the trial activations for a product on a machine.
+     */
+    struct TrialSummary
+    {
+        int numTrials = 0;
+        int numActiveTrials = 0;
+    };
+
+    /**
+     * The outcome of runMaintenance.
+     */
+    struct MaintenanceReport
+    {
+        /// False when maintenance was skipped because it ran recently.
+        bool ran = false;
+
+        /// The number of expired activations which were removed.
+        int numRowsPruned = 0;
+
+        /// The number of bytes by which the storage shrunk.
+        juce::int64 numBytesReclaimed = 0;
+    };
+
+    /// Values which don't belong to an activation, by key.
+    using Metadata = std::map<std::string, juce::int64>;
+
+    /**
+     * A stored activation together with the moment it was last saved.
+     */
+    struct Record
+    {
+        Activation activation;
+        juce::int64 lastUpdatedAt = 0; // In milliseconds since epoch.
+    };
+
+    virtual ~ActivationStore() = default;
+
+    /**
+     * Saves given activation, replacing an existing activation with the same hash.
+     * @param activation Activation to save.
+     * @param now The current time, stored as the moment the activation was last updated.
+     */
+    virtual void saveActivation (const Activation& activation, juce::Time now);
+
+    /**
+     * Saves given activations atomically: either all activations are saved or none.
+     * @param activations The activations to save.
+     * @param now The current time, stored as the moment the activations were last updated.
+     */
+    virtual void saveActivations (const std::vector<Activation>& activations, juce::Time now) = 0;
+
+    /**
+     * Deletes the activation with given hash.
+     * @param activationHash The hash of the activation to delete.
+     */
+    virtual void deleteActivation (const Activation::Hash& activationHash) = 0;
+
+    /**
+     * Deletes all activations for given product uid and machine uid.
+     * @returns The number of deleted activations.
+     */
+    virtual int deleteAllActivations (const std::string& productUid, const std::vector<uint8_t>& machineUid) = 0;
+
+    /**
+     * @returns The records for given product uid and machine uid, in the order in which they were (last) saved.
+     */
+    virtual std::vector<Record> getRecords (const std::string& productUid, const std::vector<uint8_t>& machineUid) = 0;
+
+    /**
+     * @returns A number which changes whenever the stored data changed, including changes made by other processes.
+     * Meant to be cheap, so that cached results can be validated on every use.
+     */
+    virtual juce::int64 getDataVersion() = 0;
+
+    /**
+     * @returns All activations for given product uid and machine uid, in the order in which they were (last) saved.
+     */
+    virtual std::vector<Activation> getActivations (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) = 0;
+
+    /**
+     * @returns The most valuable activation according to Activation::isMoreValuableThan. Of equally valuable
+     * activations the one saved first wins. Nullopt if no activation exists.
+     */
+    virtual std::optional<Activation> getMostValuableActivation (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now) = 0;
+
+    /**
+     * @returns All trial activations for given product uid and machine uid, in the order in which they were saved.
+     */
+    virtual std::vector<Activation> getTrialActivations (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) = 0;
+
+    /**
+     * @returns The number of trial activations, and how many of those are not expired at given time.
+     */
+    virtual TrialSummary getTrialSummary (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now) = 0;
+
+    /**
+     * @returns The activations which need an update, see ActivationsDatabase::getActivationsWhichNeedUpdate.
+     */
+    virtual std::vector<Activation> getActivationsWhichNeedUpdate (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        bool getAllActivations,
+        juce::Time now) = 0;
+
+    /**
+     * @returns The time at which the next activation needs an update, see ActivationsDatabase::getNextUpdateTime.
+     */
+    virtual std::optional<juce::Time> getNextUpdateTime (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) = 0;
+
+    /**
+     * Prunes long expired activations and compacts the storage, see ActivationsDatabase::runMaintenance.
+     */
+    virtual MaintenanceReport runMaintenance (juce::Time now, bool force) = 0;
+
+    /**
+     * @returns The value stored under given key by setMetadata, or nullopt if no value was stored.
+     */
+    virtual std::optional<juce::int64> getMetadata (const std::string& key) = 0;
+
+    /**
+     * Stores a value which doesn't belong to an activation, replacing the value stored under the same key.
+     * @param key The key to store the value under.
+     * @param value The value to store.
+     */
+    virtual void setMetadata (const std::string& key, juce::int64 value) = 0;
+
+    /**
+     * Reads the values stored under given keys and stores the values given function derives from them, in a single
+     * transaction which no other process sharing the storage can interleave with.
+     * @param keys The keys to read. Keys without a value are left out of what the function receives.
+     * @param update Called once with the stored values, returns the values to store. Nothing is stored when it returns
+     * no values.
+     */
+    virtual void updateMetadata (
+        const std::vector<std::string>& keys,
+        const std::function<Metadata (const Metadata&)>& update) = 0;
+
+    /**
+     * @returns An estimate of the memory in bytes held by this store, including caches of the underlying storage.
+     */
+    virtual size_t getMemoryUsage() = 0;
+
+    /**
+     * Derives a deterministic factor from given machine uid by which refresh intervals are multiplied, so that machines
+     * which were updated at the same moment (for example after an outage) spread their next updates over the interval.
+     * @param machineUid The (hashed) machine uid.
+     * @returns A factor in the range (1 - kMaxRefreshJitter, 1].
+     */
+    static double getRefreshJitterFactor (const std::vector<uint8_t>& machineUid);
+};
+
+} // namespace indiekey
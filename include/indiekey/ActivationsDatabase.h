@@ -6,8 +6,13 @@
 #pragma once
 
 #include "Activation.h"
-#include <SQLiteCpp/Database.h>
+#include "ActivationStore.h"
+#include "Clock.h"
 #include <juce_core/juce_core.h>
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
 #include <string>
 
 namespace indiekey
@@ -16,6 +21,47 @@ namespace indiekey
 class ActivationsDatabase
 {
 public:
+    using TrialSummary = ActivationStore::TrialSummary;
+    using MaintenanceReport = ActivationStore::MaintenanceReport;
+    using Metadata = ActivationStore::Metadata;
+
+    static constexpr double kMaxRefreshJitter = ActivationStore::kMaxRefreshJitter;
+    static constexpr int kPruneRetentionDays = ActivationStore::kPruneRetentionDays;
+    static constexpr int kMaintenanceIntervalDays = ActivationStore::kMaintenanceIntervalDays;
+
+    /**
+     * The storage backend which holds the activations.
+     */
+    enum class Backend
+    {
+        /// An SQLite database, see SqliteActivationStore.
+        Sqlite,
+        /// Memory only, databaseFile is ignored. See MemoryActivationStore.
+        Memory,
+        /// An append-only flat file, see FileActivationStore.
+        File,
+    };
+
+    /**
+     * Limits the memory the database uses, which adds up when many instances (for example plugins) run in one process.
+     */
+    struct MemoryBudget
+    {
+        /// The page cache of each SQLite connection in KiB. SQLite's default of 2000 KiB is far more than the few rows
+        /// of the activations table need. Zero keeps SQLite's default.
+        int sqliteCacheSizeKiB = 128;
+
+        /// When true, all instances in this process which open the same file share one store and its connections. The
+        /// budget of the instance which opened it first applies.
+        bool shareConnections = true;
+
+        /// The store is closed after it wasn't used for this long, and reopened on next use. Zero keeps it open.
+        juce::RelativeTime idleTimeout = juce::RelativeTime::minutes (5);
+
+        bool operator== (const MemoryBudget& rhs) const;
+        bool operator!= (const MemoryBudget& rhs) const;
+    };
+
     /**
      * Specify different options which influence the location and name of the database.
      */
@@ -23,17 +69,38 @@ public:
     {
         juce::File databaseFile;
 
+        /// When true the database is opened (and migrated) on a background thread right away, otherwise the database
+        /// is opened lazily on first use. Either way the first query waits until the database is ready.
+        bool openInBackground = false;
+
+        /// When true the database only lives in memory and databaseFile is ignored. Intended for tests and simulations.
+        bool inMemory = false;
+
+        /// The backend to store the activations in.
+        Backend backend = Backend::Sqlite;
+
+        MemoryBudget memoryBudget;
+
         bool operator== (const Options& rhs) const;
         bool operator!= (const Options& rhs) const;
     };
 
     /**
      * Sets the options for the database. If the options are different from the current options, the database will be
-     * (re)opened.
+     * (re)opened. The database file is not touched by this call: it is either opened on first use or on a background
+     * thread, depending on Options::openInBackground. Errors which occur while opening are thrown from the first
+     * call which needs the database.
      * @param options The options to use for opening the database.
      */
     void openDatabase (const Options& options);
 
+    /**
+     * Sets the clock which decides when the store becomes idle, see MemoryBudget::idleTimeout. Defaults to the system
+     * clock.
+     * @param clock The clock to use. Must outlive this object.
+     */
+    void setClock (const Clock& clock);
+
     /**
      * Brings the database in a state which is compatible with the current version of the application.
      */
@@ -42,8 +109,16 @@ public:
     /**
      * Save given activation to the database.
      * @param activation Activation to save.
+     * @param now The current time, stored as the moment the activation was last updated.
+     */
+    void saveActivation (const Activation& activation, juce::Time now);
+
+    /**
+     * Saves given activations to the database in a single transaction: either all activations are saved or none.
+     * @param activations The activations to save.
+     * @param now The current time, stored as the moment the activations were last updated.
      */
-    void saveActivation (const Activation& activation);
+    void saveActivations (const std::vector<Activation>& activations, juce::Time now);
 
     /**
      * Delete activation for given hash from the database.
@@ -65,6 +140,19 @@ public:
      */
     std::vector<Activation> getActivations (const std::string& productUid, const std::vector<uint8_t>& machineUid);
 
+    /**
+     * Finds the most valuable activation for given product uid and machine uid, using the same ordering as
+     * Activation::isMoreValuableThan. Only the winning row is read from the database.
+     * @param productUid The product uid to search for.
+     * @param machineUid The machine uid to search for.
+     * @param now The time to rank the activations at.
+     * @returns The most valuable activation, or nullopt if no activation exists.
+     */
+    std::optional<Activation> getMostValuableActivation (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now);
+
     /**
      * Find all trial activations for given product uid and machine uid.
      * @param productUid
@@ -73,24 +161,193 @@ public:
      */
     std::vector<Activation> getTrialActivations (const std::string& productUid, const std::vector<uint8_t>& machineUid);
 
+    /**
+     * Counts the trial activations for given product uid and machine uid.
+     * @param productUid The product uid to search for.
+     * @param machineUid The machine uid to search for.
+     * @param now The time to check expiry against.
+     * @returns The number of trial activations, and how many of those are not expired.
+     */
+    TrialSummary getTrialSummary (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now);
+
     /**
      * Finds all activations for given product uid and machine uid which need to be updated. Activations are considered
-     * for updating when the expiration date is within a day from now or when it was last updated more than a day ago.
+     * for updating when the expiration date is within the refresh interval from now or when it was last updated more
+     * than the refresh interval ago. The refresh interval is given by the server per activation (a day by default) and
+     * the latter is shortened by a per-machine jitter, see getRefreshJitterFactor.
      * @param productUid The product uid to search for.
      * @param machineUid The machine uid to search for.
      * @param getAllActivations If true, all activations will be returned, otherwise only activations which need to be updated
      * will be returned.
+     * @param now The current time.
      * @return A vector of activations which need to be updated.
      */
     std::vector<indiekey::Activation> getActivationsWhichNeedUpdate (
         const std::string& productUid,
         const std::vector<uint8_t>& machineUid,
-        bool getAllActivations);
+        bool getAllActivations,
+        juce::Time now);
+
+    /**
+     * Determines when the next activation for given product uid and machine uid needs to be updated, using the same
+     * rules as getActivationsWhichNeedUpdate. An activation which is about to expire, but which the last update didn't
+     * extend, is due once more when it expires and then at its refresh interval, so that it's not due right away again.
+     * @param productUid The product uid to search for.
+     * @param machineUid The machine uid to search for.
+     * @returns The time at which the next activation needs to be updated (which might be in the past), or nullopt if
+     * there are no activations.
+     */
+    std::optional<juce::Time> getNextUpdateTime (const std::string& productUid, const std::vector<uint8_t>& machineUid);
+
+    /**
+     * Removes activations which expired more than kPruneRetentionDays ago (except for the latest trial of every product
+     * and machine) and compacts the storage, for SQLite by returning free pages to the file system and optimising its
+     * query planning. Does nothing when maintenance ran less than kMaintenanceIntervalDays ago, unless forced, so it
+     * can be called often.
+     * @param now The current time.
+     * @param force True to run even when maintenance ran recently.
+     * @returns A report of what was reclaimed.
+     */
+    MaintenanceReport runMaintenance (juce::Time now, bool force = false);
+
+    /**
+     * @param key The key to look up.
+     * @returns The value stored under given key by setMetadata, or nullopt if no value was stored.
+     */
+    std::optional<juce::int64> getMetadata (const std::string& key);
+
+    /**
+     * Stores a value which doesn't belong to an activation, like the state of the RequestBudget. Metadata is shared by
+     * all products using this database.
+     * @param key The key to store the value under.
+     * @param value The value to store.
+     */
+    void setMetadata (const std::string& key, juce::int64 value);
+
+    /**
+     * Updates several metadata values in a single transaction, see ActivationStore::updateMetadata.
+     * @param keys The keys to read.
+     * @param update Called with the stored values, returns the values to store.
+     */
+    void updateMetadata (
+        const std::vector<std::string>& keys,
+        const std::function<Metadata (const Metadata&)>& update);
+
+    /**
+     * @returns A number which changes whenever the stored data changed, including changes made by other processes. See
+     * ActivationStore::getDataVersion.
+     */
+    juce::int64 getDataVersion();
+
+    /**
+     * @returns The options the database was last opened with.
+     */
+    [[nodiscard]] const Options& getOptions() const;
+
+    /**
+     * @returns The memory used by the store, divided by the number of instances sharing it. Zero when it isn't open.
+     */
+    [[nodiscard]] size_t getStoreMemoryUsage();
+
+    /**
+     * @returns The memory used by the cached query results.
+     */
+    [[nodiscard]] size_t getCacheMemoryUsage();
+
+    /**
+     * @returns The number of cached queries which had to be answered by the store since construction.
+     */
+    [[nodiscard]] juce::int64 getNumCacheMisses() const;
+
+    /**
+     * Doesn't block, so it can be called from the refresh scheduler while it is locked.
+     * @returns The time until the store becomes idle, see MemoryBudget::idleTimeout, or nullopt if the store isn't
+     * open or is never released.
+     */
+    [[nodiscard]] std::optional<juce::RelativeTime> getTimeUntilIdle() const;
+
+    /**
+     * Closes the store and drops cached results when the store wasn't used for MemoryBudget::idleTimeout. The store is
+     * reopened on next use.
+     * @returns True if the store was released.
+     */
+    bool releaseIfIdle();
+
+    /**
+     * See ActivationStore::getRefreshJitterFactor.
+     */
+    static double getRefreshJitterFactor (const std::vector<uint8_t>& machineUid);
 
 private:
-    static constexpr int kBusyTimeoutMs = 1000;
+    /**
+     * The result of getMostValuableActivation, with the period in which it stays the same.
+     */
+    struct CachedMostValuableActivation
+    {
+        std::optional<Activation> activation;
+        juce::Time computedAt;
+        std::optional<juce::Time> validUntil; // Nullopt when the result doesn't change over time.
+    };
+
+    /**
+     * The query results of a product and machine, each filled on first use. Queries which depend on the time in other
+     * ways are not cached, they are answered by the store.
+     */
+    struct CacheEntry
+    {
+        juce::uint64 generation = 0;
+        juce::int64 dataVersion = 0;
+        std::optional<std::vector<Activation>> activations;
+        std::optional<std::vector<Activation>> trialActivations;
+        std::optional<std::optional<juce::Time>> nextUpdateTime;
+        std::optional<CachedMostValuableActivation> mostValuableActivation;
+    };
+
     Options options_;
-    std::unique_ptr<SQLite::Database> database_;
+    std::mutex databaseMutex_;
+    std::shared_ptr<ActivationStore> store_;
+    std::future<std::shared_ptr<ActivationStore>> pendingStore_;
+    std::atomic<const Clock*> clock_ { &Clock::getSystemClock() };
+    std::atomic<juce::int64> lastUsedAt_ { 0 };  // In milliseconds since epoch, 0 when the store isn't open.
+    std::atomic<juce::int64> idleTimeoutMs_ { 0 }; // Copy of MemoryBudget::idleTimeout for getTimeUntilIdle.
+
+    std::mutex cacheMutex_;
+    std::map<std::pair<std::string, std::vector<uint8_t>>, CacheEntry> cache_; // Guarded by cacheMutex_.
+    std::atomic<juce::uint64> generation_ { 0 }; // Incremented after every modification through this object.
+    std::atomic<juce::int64> numCacheMisses_ { 0 };
+
+    /**
+     * @returns The open store. Opens the store when this didn't happen yet, or waits for the background thread to
+     * finish opening it. The store stays alive while the returned pointer is held, even if it gets released.
+     * @throws std::runtime_error If the database is not configured or could not be opened.
+     */
+    std::shared_ptr<ActivationStore> getStore();
+
+    static std::shared_ptr<ActivationStore> createStore (const Options& options);
+    static std::shared_ptr<ActivationStore> createOrShareStore (const Options& options);
+
+    /**
+     * @returns The cache entry of given product and machine, emptied when this object modified the store since, or
+     * when the data version of the store changed because another process did. Requires cacheMutex_ to be locked.
+     */
+    CacheEntry& getCacheEntry (
+        ActivationStore& store,
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid);
+
+    /**
+     * Answers a query which doesn't depend on the time from the cache entry of given product and machine, or from the
+     * store when the result isn't cached yet.
+     */
+    template <typename Result, typename Query>
+    Result readThroughCache (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        std::optional<Result> CacheEntry::*result,
+        Query&& query);
 };
 
 } // namespace indiekey
@@ -0,0 +1,96 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace indiekey
+{
+
+/**
+ * Signals cancellation to operations running on other threads. Operations which block (like network transfers)
+ * register a callback which aborts them, and check isCancelled before starting new work. Once cancelled, a token stays
+ * cancelled.
+ */
+class CancellationToken
+{
+public:
+    /**
+     * Thrown by operations which were cancelled.
+     */
+    class Cancelled : public std::runtime_error
+    {
+    public:
+        Cancelled() : std::runtime_error ("Operation cancelled") {}
+    };
+
+    /**
+     * Keeps a callback registered with onCancel until destroyed. After destruction the callback is guaranteed to not
+     * be running and to not be called anymore.
+     */
+    class Registration
+    {
+    public:
+        Registration() = default;
+        Registration (CancellationToken* token, size_t id);
+        ~Registration();
+
+        Registration (Registration&& other) noexcept;
+        Registration& operator= (Registration&& other) noexcept;
+
+        Registration (const Registration&) = delete;
+        Registration& operator= (const Registration&) = delete;
+
+    private:
+        CancellationToken* token_ = nullptr;
+        size_t id_ = 0;
+
+        void reset();
+    };
+
+    CancellationToken() = default;
+    ~CancellationToken();
+
+    CancellationToken (const CancellationToken&) = delete;
+    CancellationToken& operator= (const CancellationToken&) = delete;
+
+    /**
+     * Cancels all operations using this token, by calling the registered callbacks on the calling thread.
+     */
+    void cancel();
+
+    /**
+     * @returns True if cancel was called.
+     */
+    [[nodiscard]] bool isCancelled() const;
+
+    /**
+     * @throws Cancelled If cancel was called.
+     */
+    void throwIfCancelled() const;
+
+    /**
+     * Registers a callback which is called when this token gets cancelled, or right away when it already is. The
+     * callback must not call back into this token.
+     * @param callback The callback which aborts the operation.
+     * @returns A registration which unregisters the callback when destroyed.
+     */
+    [[nodiscard]] Registration onCancel (std::function<void()> callback);
+
+private:
+    std::mutex mutex_;
+    std::atomic<bool> cancelled_ { false };
+    std::map<size_t, std::function<void()>> callbacks_; // Guarded by mutex_.
+    size_t nextId_ = 1;                                  // Guarded by mutex_.
+
+    void unregister (size_t id);
+};
+
+} // namespace indiekey
@@ -0,0 +1,74 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "Transport.h"
+
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+namespace indiekey
+{
+
+/**
+ * Records conversations with the server to a cassette file, and replays them later without a server. Meant to
+ * reproduce bugs and tail latencies of real conversations in tests.
+ *
+ * A cassette is a json file holding the interactions in the order in which they happened. During replay each request
+ * is answered by the first interaction which wasn't replayed yet and has the same method and path.
+ */
+class CassetteTransport : public Transport
+{
+public:
+    enum class Mode
+    {
+        /// Forwards requests to another transport and appends every interaction to the cassette.
+        Record,
+        /// Answers requests from the cassette, without contacting the server.
+        Replay,
+    };
+
+    /**
+     * @param mode Whether to record or to replay.
+     * @param cassetteFile The cassette. Recording overwrites it.
+     * @param transport The transport to record from, ignored when replaying.
+     * @param replayRecordedLatency When true, replayed responses take as long as they took when they were recorded.
+     * @throws std::runtime_error If the cassette to replay could not be read.
+     */
+    CassetteTransport (
+        Mode mode,
+        juce::File cassetteFile,
+        std::shared_ptr<Transport> transport = nullptr,
+        bool replayRecordedLatency = false);
+
+    /**
+     * @throws std::runtime_error When replaying and no (more) matching interaction was recorded, or when the recorded
+     * request failed to reach the server.
+     */
+    RestClient::Response send (const RestClient::Request& request, CancellationToken* cancellationToken) override;
+
+    /**
+     * @returns When recording the number of recorded interactions, when replaying the number of interactions which
+     * weren't replayed yet.
+     */
+    [[nodiscard]] size_t getNumRemainingInteractions() const;
+
+private:
+    Mode mode_;
+    juce::File cassetteFile_;
+    std::shared_ptr<Transport> transport_;
+    bool replayRecordedLatency_ = false;
+
+    mutable std::mutex mutex_;
+    nlohmann::json interactions_ = nlohmann::json::array(); // Guarded by mutex_.
+    std::vector<bool> replayed_;                            // Guarded by mutex_.
+
+    static juce::String getMethod (const RestClient::Request& request);
+    void record (nlohmann::json interaction);
+};
+
+} // namespace indiekey
@@ -0,0 +1,159 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "ActivationsDatabase.h"
+
+#include <juce_core/juce_core.h>
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace indiekey
+{
+
+/**
+ * Process wide record of which activation servers can be reached, so that clients don't all wait for a connection
+ * timeout when the machine is offline. After several requests to a server failed in a row the circuit for that server
+ * opens, and requests to it are skipped (clients validate locally instead) until a background probe or a forced
+ * validation reaches the server again. Probes are spaced exponentially while they keep failing.
+ *
+ * The state of open circuits is persisted in the activations database, so that the next launch doesn't wait for a
+ * timeout either. It is read again whenever the database changed, so that a circuit which another process opened or
+ * closed is picked up. The database is never accessed while the circuit breaker is locked.
+ * Use through juce::SharedResourcePointer so that all clients in a process share one instance.
+ */
+class CircuitBreaker
+{
+public:
+    enum class State
+    {
+        /// Requests are sent.
+        Closed,
+        /// Requests are skipped until the next probe.
+        Open,
+        /// Requests are skipped, and a probe is due.
+        HalfOpen,
+    };
+
+    /**
+     * When circuits open and how often they are probed.
+     */
+    struct Policy
+    {
+        /// The number of failed requests in a row after which the circuit opens. More than one, so that a single
+        /// transient timeout or server error doesn't take the server out of use.
+        int failureThreshold = 3;
+
+        /// The time until the first probe. Every probe which fails doubles the time until the next.
+        juce::RelativeTime initialProbeInterval = juce::RelativeTime::seconds (30);
+
+        /// The maximum time between two probes.
+        juce::RelativeTime maxProbeInterval = juce::RelativeTime::minutes (15);
+
+        bool operator== (const Policy& rhs) const;
+        bool operator!= (const Policy& rhs) const;
+    };
+
+    /**
+     * What happened since this circuit breaker was created.
+     */
+    struct Counters
+    {
+        juce::int64 numOpened = 0;
+        juce::int64 numShortCircuited = 0;
+        juce::int64 numProbes = 0;
+    };
+
+    /**
+     * Sets the policy for all clients in this process.
+     * @param policy The policy to apply.
+     * @throws std::runtime_error If the policy is invalid.
+     */
+    void setPolicy (const Policy& policy);
+
+    /**
+     * @returns The current policy.
+     */
+    [[nodiscard]] Policy getPolicy() const;
+
+    /**
+     * @param database The database to read the state of the circuit from, if it changed since it was last read.
+     * @param serverAddress The address of the server.
+     * @returns True if a request to given server may be sent, false if it must be skipped. Skipped requests are
+     * counted.
+     */
+    bool allowRequest (ActivationsDatabase& database, const std::string& serverAddress);
+
+    /**
+     * Claims the probe of an open circuit which is due, so that only one client in the process sends it. The time
+     * until the next probe starts right away, so that other clients wait for it.
+     * @param database The database to persist the state of the circuit in.
+     * @param serverAddress The address of the server.
+     * @param now The current time.
+     * @returns True if the caller must probe the server and report the outcome.
+     */
+    bool tryStartProbe (ActivationsDatabase& database, const std::string& serverAddress, juce::Time now);
+
+    /**
+     * Reports that given server answered, which closes its circuit.
+     * @param database The database to persist the state of the circuit in.
+     * @param serverAddress The address of the server.
+     */
+    void recordSuccess (ActivationsDatabase& database, const std::string& serverAddress);
+
+    /**
+     * Reports that given server couldn't be reached or failed with a server error.
+     * @param database The database to persist the state of the circuit in.
+     * @param serverAddress The address of the server.
+     * @param now The current time.
+     */
+    void recordFailure (ActivationsDatabase& database, const std::string& serverAddress, juce::Time now);
+
+    /**
+     * @param serverAddress The address of the server.
+     * @param now The current time.
+     * @returns The state of the circuit of given server.
+     */
+    [[nodiscard]] State getState (const std::string& serverAddress, juce::Time now) const;
+
+    /**
+     * @param serverAddress The address of the server.
+     * @returns The time at which the next probe is due, which might be in the past, or nullopt if the circuit is
+     * closed.
+     */
+    [[nodiscard]] std::optional<juce::Time> getNextProbeTime (const std::string& serverAddress) const;
+
+    /**
+     * @returns What happened since this circuit breaker was created.
+     */
+    [[nodiscard]] Counters getCounters() const;
+
+private:
+    struct Circuit
+    {
+        int numFailures = 0;         // Failed requests in a row while closed.
+        int numProbes = 0;           // Probes since the circuit opened, determines the interval until the next one.
+        juce::int64 nextProbeAt = 0; // In milliseconds since epoch, 0 while closed.
+        int numUnsavedChanges = 0;   // Changes which save didn't finish with yet.
+
+        /// The version of the database when the state was last read, nullopt before.
+        std::optional<juce::int64> dataVersion;
+    };
+
+    mutable std::mutex mutex_;
+    Policy policy_;
+    std::map<std::string, Circuit> circuits_; // By server address.
+    Counters counters_;
+
+    void synchronise (ActivationsDatabase& database, const std::string& serverAddress);
+    void save (ActivationsDatabase& database, const std::string& serverAddress);
+    [[nodiscard]] juce::RelativeTime getProbeInterval (int numProbes) const;
+};
+
+} // namespace indiekey
@@ -0,0 +1,61 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include <atomic>
+
+#include <juce_core/juce_core.h>
+
+namespace indiekey
+{
+
+/**
+ * Source of the current time for expiry and refresh logic. Code which needs the current time reads it once per
+ * operation and passes the result along, so that a single operation always sees a consistent time.
+ */
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * @returns The current time.
+     */
+    [[nodiscard]] virtual juce::Time now() const = 0;
+
+    /**
+     * @returns A clock which returns the system time.
+     */
+    static const Clock& getSystemClock();
+};
+
+/**
+ * Clock which only moves when told to. Useful for tests and simulations which need to run against a virtual time.
+ */
+class ManualClock : public Clock
+{
+public:
+    explicit ManualClock (juce::Time startTime = juce::Time::getCurrentTime());
+
+    [[nodiscard]] juce::Time now() const override;
+
+    /**
+     * Sets the current time of this clock.
+     * @param time The new time.
+     */
+    void setTime (juce::Time time);
+
+    /**
+     * Moves the current time of this clock.
+     * @param amount The amount to move the time with.
+     */
+    void advance (juce::RelativeTime amount);
+
+private:
+    std::atomic<juce::int64> milliseconds_;
+};
+
+} // namespace indiekey
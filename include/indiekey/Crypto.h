@@ -5,17 +5,41 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace indiekey::crypto
 {
 
+/// The size of a hash produced by genericHash.
+constexpr size_t kGenericHashBytes = 32;
+
+/// The size of the key for keyedHash.
+constexpr size_t kKeyedHashKeyBytes = 32;
+
+/// The size of a public key for boxSeal.
+constexpr size_t kBoxPublicKeyBytes = 32;
+
+/// The number of bytes boxSeal adds to the data.
+constexpr size_t kBoxSealOverheadBytes = 48;
+
 /**
- * Initialises sodium and throws an exception if the initialisation fails.
+ * Initialises sodium and throws an exception if the initialisation fails. Sodium is initialised only once per process,
+ * subsequent calls return right away. Must be called before any other function in this namespace is used, and before
+ * signatures are verified.
  */
 void init();
 
+/**
+ * Hashes given data into given buffer, without allocating.
+ * @param data The data to hash.
+ * @param dataLength The length of the data.
+ * @param hash The buffer to write the hash to, must be kGenericHashBytes long.
+ */
+void genericHash (const uint8_t* data, size_t dataLength, uint8_t* hash);
+
 /**
  * @param data The data to hash.
  * @returns A secure hash of given data.
@@ -29,6 +53,71 @@ void init();
  */
 [[maybe_unused]] std::vector<uint8_t> genericHash (const std::string& text);
 
+/**
+ * Hashes given data with a secret key into given buffer, without allocating. The hash serves as message authentication
+ * code: it can't be computed without the key.
+ * @param data The data to hash.
+ * @param dataLength The length of the data.
+ * @param key The secret key, must be kKeyedHashKeyBytes long.
+ * @param hash The buffer to write the hash to, must be kGenericHashBytes long.
+ */
+void keyedHash (const uint8_t* data, size_t dataLength, const uint8_t* key, uint8_t* hash);
+
+/**
+ * Fills given buffer with random bytes which are suitable for keys.
+ * @param buffer The buffer to fill.
+ * @param size The size of the buffer.
+ */
+void randomBytes (uint8_t* buffer, size_t size);
+
+/**
+ * Computes the same hash as genericHash, over data which is provided in parts.
+ */
+class GenericHash
+{
+public:
+    GenericHash();
+
+    /**
+     * Adds given data to the hash.
+     * @param data The data to add.
+     * @param dataLength The length of the data.
+     */
+    void update (const uint8_t* data, size_t dataLength);
+
+    /**
+     * Adds given text to the hash.
+     * @param text The text to add.
+     */
+    void update (const std::string& text);
+
+    /**
+     * Finishes the hash and writes it to given buffer. The object can't be updated afterward.
+     * @param hash The buffer to write the hash to, must be kGenericHashBytes long.
+     */
+    void finish (uint8_t* hash);
+
+    /**
+     * Finishes the hash. The object can't be updated afterward.
+     * @returns The hash.
+     */
+    std::vector<uint8_t> finish();
+
+private:
+    // Storage for crypto_generichash_state, which is kept out of this header.
+    alignas (64) unsigned char state_[384] {};
+};
+
+/**
+ * Encrypts given data with given key into given buffer, without allocating.
+ * @param data The data to encrypt.
+ * @param dataLength The length of the data to encrypt.
+ * @param key The key to use for encryption, must be kBoxPublicKeyBytes long.
+ * @param cipherText The buffer to write the encrypted data to, must be dataLength + kBoxSealOverheadBytes long.
+ * @return The number of bytes written to cipherText.
+ */
+size_t boxSeal (const uint8_t* data, size_t dataLength, const uint8_t* key, uint8_t* cipherText);
+
 /**
  * Encrypts given data with given key.
  * @param data The data to encrypt.
@@ -52,6 +141,7 @@ void init();
  * @param key The key to use for encryption.
  * @return The encrypted data.
  */
-[[maybe_unused]] std::vector<uint8_t> boxSeal (const unsigned char* data, size_t dataLength, const std::vector<uint8_t>& key);
+[[maybe_unused]] std::vector<uint8_t>
+boxSeal (const unsigned char* data, size_t dataLength, const std::vector<uint8_t>& key);
 
 } // namespace indiekey::crypto
@@ -8,3 +8,4 @@
 #define ENDPOINT_ACTIVATE "/activate"
 #define ENDPOINT_ACTIVATE_TRIAL "/activate_trial"
 #define ENDPOINT_UPDATE_ACTIVATIONS "/update_activations"
+#define ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH "/update_activations_by_hash"
@@ -0,0 +1,80 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "Transport.h"
+
+#include <memory>
+#include <mutex>
+
+namespace indiekey
+{
+
+/**
+ * Decorates a transport with faults which are drawn from a seeded random generator, so that a run with the same seed
+ * and the same sequence of requests injects the same faults. Meant to test error handling and tail latency.
+ */
+class FaultInjectingTransport : public Transport
+{
+public:
+    /**
+     * The probability of each fault per request. Faults are drawn independently, a request can be both delayed and
+     * fail.
+     */
+    struct Faults
+    {
+        juce::int64 seed = 1;
+
+        /// Delays the request by a random time between minLatency and maxLatency.
+        double latencyProbability = 0.0;
+        juce::RelativeTime minLatency = juce::RelativeTime::milliseconds (100);
+        juce::RelativeTime maxLatency = juce::RelativeTime::seconds (1.0);
+
+        /// Fails the request as if the server refused the connection, without sending it.
+        double refusalProbability = 0.0;
+
+        /// Cuts the response body off at a random position.
+        double truncationProbability = 0.0;
+
+        /// Answers with 503 Service Unavailable, without sending the request.
+        double serverErrorProbability = 0.0;
+    };
+
+    /**
+     * The number of requests and injected faults so far.
+     */
+    struct Counters
+    {
+        int numRequests = 0;
+        int numDelayed = 0;
+        int numRefused = 0;
+        int numTruncated = 0;
+        int numServerErrors = 0;
+    };
+
+    /**
+     * @param transport The transport to send requests with which are not refused.
+     * @param faults The faults to inject.
+     */
+    FaultInjectingTransport (std::shared_ptr<Transport> transport, Faults faults);
+
+    RestClient::Response send (const RestClient::Request& request, CancellationToken* cancellationToken) override;
+
+    /**
+     * @returns The number of requests and injected faults so far.
+     */
+    [[nodiscard]] Counters getCounters() const;
+
+private:
+    std::shared_ptr<Transport> transport_;
+    Faults faults_;
+
+    mutable std::mutex mutex_;
+    juce::Random random_; // Guarded by mutex_.
+    Counters counters_;   // Guarded by mutex_.
+};
+
+} // namespace indiekey
@@ -0,0 +1,54 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "MemoryActivationStore.h"
+
+namespace indiekey
+{
+
+/**
+ * Stores activations in a flat file, for hosts where SQLite is not available or not wanted. The file is an append-only
+ * log of checksummed changes which is replayed into memory on open. Each change is flushed to disk before it is
+ * applied, and a torn or corrupt tail (left behind by a crash) is ignored and overwritten by the next change. Multiple
+ * processes can share the file: writers serialise through an inter-process lock and readers pick up the tail appended
+ * by others. runMaintenance compacts the log by atomically replacing the file.
+ */
+class FileActivationStore : public MemoryActivationStore
+{
+public:
+    /**
+     * Opens given file and replays it. The file is created on the first change.
+     * @param file The file to store the activations in.
+     * @throws std::runtime_error If the file exists but is not a valid activations file.
+     */
+    explicit FileActivationStore (juce::File file);
+
+    MaintenanceReport runMaintenance (juce::Time now, bool force) override;
+
+    void updateMetadata (
+        const std::vector<std::string>& keys,
+        const std::function<Metadata (const Metadata&)>& update) override;
+
+protected:
+    int commit (const Change& change) override;
+    void synchronise() override;
+
+private:
+    juce::File file_;
+    juce::InterProcessLock processLock_;
+    std::string generation_;       // Identifies the file, changes on every compaction.
+    juce::int64 readPosition_ = 0; // The end of the last complete record which was applied.
+
+    static nlohmann::json changeToJson (const Change& change);
+    static Change changeFromJson (const nlohmann::json& json);
+
+    void reset();
+    void append (const std::string& record);
+    void compact();
+};
+
+} // namespace indiekey
@@ -0,0 +1,134 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "ActivationStore.h"
+
+#include <map>
+#include <mutex>
+
+namespace indiekey
+{
+
+/**
+ * Keeps activations in memory only. Useful for tests, simulations and hosts which don't allow writing to disk. Every
+ * modification is expressed as a Change which subclasses can intercept to persist it, see FileActivationStore.
+ */
+class MemoryActivationStore : public ActivationStore
+{
+public:
+    MemoryActivationStore() = default;
+
+    /**
+     * Creates a store holding given records.
+     * @param records The records, in the order in which they were saved.
+     */
+    explicit MemoryActivationStore (std::vector<Record> records);
+
+    void saveActivations (const std::vector<Activation>& activations, juce::Time now) override;
+    void deleteActivation (const Activation::Hash& activationHash) override;
+    int deleteAllActivations (const std::string& productUid, const std::vector<uint8_t>& machineUid) override;
+
+    std::vector<Record> getRecords (const std::string& productUid, const std::vector<uint8_t>& machineUid) override;
+    juce::int64 getDataVersion() override;
+
+    std::vector<Activation> getActivations (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) override;
+
+    std::optional<Activation> getMostValuableActivation (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now) override;
+
+    std::vector<Activation> getTrialActivations (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) override;
+
+    TrialSummary getTrialSummary (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now) override;
+
+    std::vector<Activation> getActivationsWhichNeedUpdate (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        bool getAllActivations,
+        juce::Time now) override;
+
+    std::optional<juce::Time> getNextUpdateTime (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) override;
+
+    MaintenanceReport runMaintenance (juce::Time now, bool force) override;
+    std::optional<juce::int64> getMetadata (const std::string& key) override;
+    void setMetadata (const std::string& key, juce::int64 value) override;
+
+    void updateMetadata (
+        const std::vector<std::string>& keys,
+        const std::function<Metadata (const Metadata&)>& update) override;
+
+    size_t getMemoryUsage() override;
+
+protected:
+    /**
+     * A single modification of the store.
+     */
+    struct Change
+    {
+        enum class Type
+        {
+            Save,
+            Delete,
+            DeleteAll,
+            Prune,
+            SetMetadata,
+        };
+
+        Type type = Type::Save;
+        std::vector<Activation> activations; // Save
+        juce::int64 time = 0;                // Save: last updated at, Prune: cutoff.
+        Activation::Hash hash;               // Delete
+        std::string productUid;              // DeleteAll
+        std::vector<uint8_t> machineUid;     // DeleteAll
+        Metadata metadata;                   // SetMetadata, all values are stored at once.
+    };
+
+    /// Rows in the order in which they were (last) saved, which matches the row ids of SqliteActivationStore.
+    std::vector<Record> rows_;
+    Metadata metadata_;
+    juce::int64 numChanges_ = 0; // The number of changes applied, used as data version.
+
+    /**
+     * Applies given change to the rows in memory.
+     * @param change The change to apply.
+     * @returns The number of rows affected.
+     */
+    int apply (const Change& change);
+
+    /// Guards all members, recursive so that subclasses can extend operations which hold it.
+    std::recursive_mutex mutex_;
+
+    /**
+     * Called for every modification, with mutex_ held. The default implementation applies the change right away.
+     * @param change The change to commit.
+     * @returns The number of rows affected.
+     */
+    virtual int commit (const Change& change);
+
+    /**
+     * Called before every operation, with mutex_ held, to pick up modifications made elsewhere.
+     */
+    virtual void synchronise() {}
+
+private:
+    [[nodiscard]] static bool matches (
+        const Record& row,
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid);
+};
+
+} // namespace indiekey
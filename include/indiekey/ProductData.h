@@ -28,6 +28,13 @@ struct ProductData
                primaryPublicServerAddress + "'" + ", secondaryPublicServerAddress='" + secondaryPublicServerAddress +
                "'" + " }";
     }
+
+    [[nodiscard]] size_t getMemoryUsage() const
+    {
+        return sizeof (*this) + organisationName.capacity() + productName.capacity() + productUid.capacity() +
+               verifyingKey.capacity() + cryptoPublicKey.capacity() + primaryPublicServerAddress.capacity() +
+               secondaryPublicServerAddress.capacity();
+    }
 };
 
 [[maybe_unused]] static void from_json (const nlohmann::json& json, ProductData& productData)
@@ -0,0 +1,95 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+namespace indiekey
+{
+
+/**
+ * Process wide scheduler which refreshes activations exactly when needed. A single background thread sleeps until the
+ * earliest moment any of the registered clients needs a refresh or re-validation, so no polling takes place. The same
+ * thread tells clients when they became idle, so that they can release memory.
+ * Use through juce::SharedResourcePointer so that all clients in a process share one instance.
+ */
+class RefreshScheduler : private juce::Thread
+{
+public:
+    /**
+     * Interface for objects which want to be refreshed by the scheduler.
+     */
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /**
+         * Called on the scheduler thread while the scheduler is locked, so this must return quickly without blocking.
+         * @returns The time until this client needs to be refreshed, or nullopt if no refresh is needed.
+         */
+        virtual std::optional<juce::RelativeTime> getTimeUntilNextRefresh() = 0;
+
+        /**
+         * Called on the scheduler thread when the time returned by getTimeUntilNextRefresh passed.
+         */
+        virtual void refresh() = 0;
+
+        /**
+         * Called on the scheduler thread while the scheduler is locked, so this must return quickly without blocking.
+         * @returns The time until this client can release resources it isn't using, or nullopt if there's nothing to
+         * release.
+         */
+        virtual std::optional<juce::RelativeTime> getTimeUntilIdle()
+        {
+            return std::nullopt;
+        }
+
+        /**
+         * Called on the scheduler thread when the time returned by getTimeUntilIdle passed.
+         */
+        virtual void releaseIdleResources() {}
+    };
+
+    RefreshScheduler();
+    ~RefreshScheduler() override;
+
+    /**
+     * Adds given client to the scheduler. Starts the scheduler thread if it isn't running yet.
+     * @param client The client to add.
+     */
+    void addClient (Client* client);
+
+    /**
+     * Removes given client from the scheduler. If the client is being refreshed at this moment, this call blocks until
+     * the refresh finished, so that the client can safely be destroyed afterward.
+     * @param client The client to remove.
+     */
+    void removeClient (Client* client);
+
+    /**
+     * Tells the scheduler that the next refresh time of one of its clients changed.
+     */
+    void reschedule();
+
+private:
+    /// Upper bound for a single wait, which guards against missed wake-ups after system sleep or clock changes.
+    static constexpr int kMaxWaitMs = 60 * 60 * 1000;
+
+    std::mutex mutex_;
+    std::condition_variable refreshFinished_;
+    std::vector<Client*> clients_;
+    Client* refreshingClient_ = nullptr;
+
+    void run() override;
+};
+
+} // namespace indiekey
@@ -0,0 +1,118 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "ActivationsDatabase.h"
+
+#include <juce_core/juce_core.h>
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace indiekey
+{
+
+/**
+ * Process wide token bucket which limits the update requests ActivationClient sends to the server, so that a host which
+ * validates online on every instance or every editor open doesn't flood the server. Every update request takes a
+ * token, and tokens are earned back at a fixed rate up to a maximum. Calls which find the bucket empty validate
+ * locally instead.
+ *
+ * There is a bucket per database file, persisted in that database so that restarting the host doesn't refill it.
+ * Granted requests merge the bucket with the stored one in a single transaction, so that processes sharing the file
+ * spend one budget. The stored bucket is only read again when the database changed since, and never while the budget
+ * is locked, so that clients don't wait for each other's database.
+ * Use through juce::SharedResourcePointer so that all clients in a process share one instance.
+ */
+class RequestBudget
+{
+public:
+    /**
+     * How many requests may be sent.
+     */
+    struct Policy
+    {
+        /// The maximum number of requests which can be sent in a burst.
+        int capacity = 30;
+
+        /// The time it takes to earn back a single request.
+        juce::RelativeTime refillInterval = juce::RelativeTime::minutes (2);
+
+        bool operator== (const Policy& rhs) const;
+        bool operator!= (const Policy& rhs) const;
+    };
+
+    /**
+     * The number of requests which were allowed and throttled by this budget since it was created.
+     */
+    struct Counters
+    {
+        juce::int64 numGranted = 0;
+        juce::int64 numThrottled = 0;
+    };
+
+    /**
+     * Sets the policy for all clients in this process. Tokens above the new capacity are dropped.
+     * @param policy The policy to apply.
+     * @throws std::runtime_error If the policy is invalid.
+     */
+    void setPolicy (const Policy& policy);
+
+    /**
+     * @returns The current policy.
+     */
+    [[nodiscard]] Policy getPolicy() const;
+
+    /**
+     * Takes a token from the bucket of given database if there is one.
+     * @param database The database of the caller, in which the bucket is persisted. Errors of the database are
+     * ignored, in which case the bucket is kept in memory only.
+     * @param now The current time.
+     * @returns True if the request may be sent, false if it must be skipped.
+     */
+    bool tryAcquire (ActivationsDatabase& database, juce::Time now);
+
+    /**
+     * Doesn't access the database, so it can be called often.
+     * @param database The database of the caller.
+     * @param now The current time.
+     * @returns The time at which the next token is available, which is now when the bucket isn't empty.
+     */
+    [[nodiscard]] juce::Time getNextAvailableTime (const ActivationsDatabase& database, juce::Time now) const;
+
+    /**
+     * @returns The number of requests which were allowed and throttled.
+     */
+    [[nodiscard]] Counters getCounters() const;
+
+private:
+    static constexpr auto kTokensKey = "request_budget_tokens"; // Stored in thousandths of a token.
+    static constexpr auto kUpdatedAtKey = "request_budget_updated_at";
+
+    struct Bucket
+    {
+        double tokens = 0.0;
+        juce::Time updatedAt;
+        std::optional<juce::int64> dataVersion; // Of the database when the stored bucket was read, nullopt before.
+    };
+
+    mutable std::mutex mutex_;
+    Policy policy_;
+    std::map<std::string, Bucket> buckets_; // By database file, see getBucketKey.
+    Counters counters_;
+
+    Bucket& getBucket (const std::string& key);
+    bool take (Bucket& bucket, juce::Time now);
+    void refill (Bucket& bucket, juce::Time now) const;
+    void merge (Bucket& bucket, const ActivationsDatabase::Metadata& stored, juce::Time now) const;
+    [[nodiscard]] double getTokensAt (const Bucket& bucket, juce::Time now) const;
+    [[nodiscard]] double getTokensAt (double tokens, juce::Time since, juce::Time now) const;
+    static std::string getBucketKey (const ActivationsDatabase& database);
+};
+
+} // namespace indiekey
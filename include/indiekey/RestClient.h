@@ -5,15 +5,31 @@
 
 #pragma once
 
+#include "CancellationToken.h"
+
 #include <juce_core/juce_core.h>
+#include <memory>
 #include <nlohmann/json.hpp>
 
 namespace indiekey
 {
 
+class Transport;
+
 class RestClient
 {
 public:
+    /**
+     * A request as it is handed to a Transport.
+     */
+    struct Request
+    {
+        juce::URL url; // Includes the POST data, if any.
+        bool usePost = false;
+        juce::String extraHeaders;
+        int connectionTimeoutMs = 0;
+    };
+
     struct Response
     {
         int statusCode { 0 };
@@ -42,15 +58,40 @@ public:
         std::string mMessage;
     };
 
-    explicit RestClient (juce::URL address);
+    /**
+     * @param address The address of the server.
+     * @param transport The transport which sends the requests, or nullptr to use a WebTransport.
+     */
+    explicit RestClient (juce::URL address, std::shared_ptr<Transport> transport = nullptr);
+
+    /**
+     * Sends a GET request.
+     * @param path The path relative to the server address.
+     * @param cancellationToken Optional token which aborts the request, also while it is waiting for the server.
+     * @throws CancellationToken::Cancelled If the request was cancelled.
+     */
+    Response get (juce::StringRef path, CancellationToken* cancellationToken = nullptr);
 
-    Response get (juce::StringRef path);
-    Response post (juce::StringRef path, const nlohmann::json& postData);
+    /**
+     * Sends a POST request with a json body.
+     * @param path The path relative to the server address.
+     * @param postData The body of the request.
+     * @param cancellationToken Optional token which aborts the request, also while it is waiting for the server.
+     * @throws CancellationToken::Cancelled If the request was cancelled.
+     */
+    Response post (
+        juce::StringRef path,
+        const nlohmann::json& postData,
+        CancellationToken* cancellationToken = nullptr);
+
+    /**
+     * @returns An estimate of the memory in bytes held by this client, including its own size.
+     */
+    [[nodiscard]] size_t getMemoryUsage() const;
 
 private:
     juce::URL mAddress;
-
-    static const juce::URL::InputStreamOptions& getDefaultInputStreamOptions();
+    std::shared_ptr<Transport> mTransport;
 };
 
 } // namespace indiekey
@@ -0,0 +1,73 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace indiekey
+{
+
+/**
+ * Runs tasks one at a time, in the order in which they were added, from any number of threads. No thread is owned by
+ * the queue: the calling threads take turns running the tasks at the front of the queue until their own task ran.
+ * Waiting tasks with the same merge key are merged into one, so a burst of identical requests results in a single run.
+ */
+class SerialQueue
+{
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * Runs given task after all tasks which were added before, and blocks until it ran. When called from within a task
+     * of this queue, the task runs right away.
+     * @param task The task to run.
+     * @throws Any exception thrown by the task.
+     */
+    void run (const Task& task);
+
+    /**
+     * Like run (const Task&), but if a task with the same merge key is waiting to be run, given task is dropped and
+     * this call waits for the waiting task instead, including its outcome.
+     * @param mergeKey The key which identifies identical tasks. An empty key never merges.
+     * @param task The task to run.
+     * @throws Any exception thrown by the task which ran.
+     */
+    void run (const std::string& mergeKey, const Task& task);
+
+    /**
+     * @returns The number of tasks which were merged into a waiting task since construction.
+     */
+    [[nodiscard]] size_t getNumMergedTasks() const;
+
+    /**
+     * Waits until no task is running or waiting to be run. Must not be called from within a task of this queue.
+     */
+    void waitUntilIdle();
+
+private:
+    struct Entry
+    {
+        std::string mergeKey;
+        Task task;
+        bool done = false;
+        std::exception_ptr exception;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable taskFinished_;
+    std::deque<std::shared_ptr<Entry>> pending_;
+    std::thread::id runningThread_; // Default constructed when no task is running.
+    size_t numMergedTasks_ = 0;
+};
+
+} // namespace indiekey
@@ -0,0 +1,153 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "Activation.h"
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace indiekey
+{
+
+/**
+ * Shares the outcome of validations between the processes on a machine, so that a process (for example a plugin scanner
+ * or sandbox) can take over the result another process validated, without opening the activations database or
+ * verifying the signature.
+ *
+ * The results live in a small memory mapped file (in /dev/shm where available), one slot per product, machine and
+ * database. Slots are guarded by a sequence lock, so readers never block writers, and carry a keyed hash (MAC) which
+ * only processes that can read the key file next to the database can compute. Only valid activations, and the absence
+ * of any activation, are published. Readers verify the signature and expiry of an activation themselves, so that a
+ * forged slot can't turn into a license.
+ *
+ * When the shared memory or the key is not available the cache is disabled: nothing is published and every lookup
+ * misses, so that callers fall back to the database. The same happens when the shared memory is accessible by other
+ * users, or was created by one.
+ */
+class SharedStatusCache
+{
+public:
+    /// Identifies the state of a slot, see lookup and publish.
+    using Version = uint32_t;
+
+    /**
+     * A result published by a process.
+     */
+    struct Entry
+    {
+        /// The most valuable activation, validated at the time of the lookup. Nullopt when there was no activation.
+        std::optional<Activation> activation;
+
+        /// When the next activation needs an update, see ActivationsDatabase::getNextUpdateTime.
+        std::optional<juce::Time> nextUpdateTime;
+    };
+
+    /**
+     * The outcome of lookup.
+     */
+    struct Lookup
+    {
+        /// The published result, or nullopt when there is none (or it can't be used anymore).
+        std::optional<Entry> entry;
+
+        /// The version of the slot, to pass to publish.
+        Version version = 0;
+    };
+
+    /**
+     * @param databaseFile The activations database of which results are shared. Its key file is created when it
+     * doesn't exist yet.
+     * @param regionName The name of the shared memory, or empty for the region of the current user. Only caches with
+     * the same region share results.
+     */
+    explicit SharedStatusCache (const juce::File& databaseFile, const std::string& regionName = {});
+    ~SharedStatusCache();
+
+    /**
+     * @returns The name of the region which is shared by all processes of the current user.
+     */
+    static std::string getDefaultRegionName();
+
+    /**
+     * Removes the shared memory with given name, for example after a test. Processes which use it keep their mapping.
+     * @param regionName The name of the region.
+     */
+    static void deleteRegion (const std::string& regionName);
+
+    /**
+     * @returns True if results are shared, false if the cache is disabled.
+     */
+    [[nodiscard]] bool isAvailable() const;
+
+    /**
+     * Looks up the result for given product and machine. Never waits for other processes. The signature of a published
+     * activation is verified once per process, later lookups of the same activation only check its expiry. Requires
+     * crypto::init to have been called.
+     * @param productUid The product uid.
+     * @param machineUid The machine uid.
+     * @param verifyingKey The key to verify the signature of the published activation with.
+     * @param now The time at which the activation is validated. Activations which are not valid are ignored.
+     * @returns The result, if one was published and can be used, and the version of the slot.
+     */
+    [[nodiscard]] Lookup lookup (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        const std::vector<uint8_t>& verifyingKey,
+        juce::Time now);
+
+    /**
+     * Publishes the result of a validation, unless the slot changed since given version. Pass the version from a
+     * lookup made before reading the database, so that a result which another process invalidated in the meantime
+     * isn't published.
+     * @param productUid The product uid.
+     * @param machineUid The machine uid.
+     * @param version The version of the slot from lookup.
+     * @param activation The validated activation, or nullptr if there is none. Activations which are not valid are not
+     * published, in that case the slot is invalidated.
+     * @param nextUpdateTime When the next activation needs an update.
+     * @param now The current time.
+     * @returns True if the result was published.
+     */
+    bool publish (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        Version version,
+        const Activation* activation,
+        std::optional<juce::Time> nextUpdateTime,
+        juce::Time now);
+
+    /**
+     * Removes the result for given product and machine, which must be done after changing their activations.
+     * @param productUid The product uid.
+     * @param machineUid The machine uid.
+     */
+    void invalidate (const std::string& productUid, const std::vector<uint8_t>& machineUid);
+
+private:
+    struct Region;
+    struct Slot;
+
+    std::shared_ptr<Region> region_;
+    std::string databasePath_;
+    std::array<uint8_t, 32> key_ {};
+
+    [[nodiscard]] Slot* getSlot (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        std::array<uint8_t, 32>& slotKey) const;
+
+    static juce::File getRegionFile (const std::string& regionName);
+    static std::shared_ptr<Region> openRegion (const std::string& regionName);
+    static bool loadOrCreateKey (const juce::File& databaseFile, std::array<uint8_t, 32>& key);
+};
+
+} // namespace indiekey
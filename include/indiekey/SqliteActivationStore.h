@@ -0,0 +1,113 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "ActivationStore.h"
+
+#include <SQLiteCpp/Database.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace indiekey
+{
+
+/**
+ * Stores activations in an SQLite database. This is the default backend, which can be shared by multiple processes.
+ * The database is used in WAL mode, with a read-write connection for modifications and a read-only connection for
+ * queries. Queries throw BusyError instead of blocking when the database is locked. Writes are serialised, so that one
+ * store can be shared by multiple threads.
+ */
+class SqliteActivationStore : public ActivationStore
+{
+public:
+    /**
+     * Creates a store backed by a database which only lives in memory.
+     */
+    SqliteActivationStore();
+
+    /**
+     * Opens (or creates) the database in given file and migrates it to the current schema.
+     * @param databaseFile The database file. The parent directory is created when it doesn't exist.
+     * @param cacheSizeKiB The size of the page cache of each connection in KiB, or 0 to use SQLite's default.
+     * @throws std::runtime_error If the database could not be opened.
+     */
+    explicit SqliteActivationStore (const juce::File& databaseFile, int cacheSizeKiB = 0);
+
+    void saveActivation (const Activation& activation, juce::Time now) override;
+    void saveActivations (const std::vector<Activation>& activations, juce::Time now) override;
+    void deleteActivation (const Activation::Hash& activationHash) override;
+    int deleteAllActivations (const std::string& productUid, const std::vector<uint8_t>& machineUid) override;
+
+    std::vector<Record> getRecords (const std::string& productUid, const std::vector<uint8_t>& machineUid) override;
+    juce::int64 getDataVersion() override;
+
+    std::vector<Activation> getActivations (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) override;
+
+    std::optional<Activation> getMostValuableActivation (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now) override;
+
+    std::vector<Activation> getTrialActivations (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) override;
+
+    TrialSummary getTrialSummary (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        juce::Time now) override;
+
+    std::vector<Activation> getActivationsWhichNeedUpdate (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid,
+        bool getAllActivations,
+        juce::Time now) override;
+
+    std::optional<juce::Time> getNextUpdateTime (
+        const std::string& productUid,
+        const std::vector<uint8_t>& machineUid) override;
+
+    MaintenanceReport runMaintenance (juce::Time now, bool force) override;
+    std::optional<juce::int64> getMetadata (const std::string& key) override;
+    void setMetadata (const std::string& key, juce::int64 value) override;
+
+    void updateMetadata (
+        const std::vector<std::string>& keys,
+        const std::function<Metadata (const Metadata&)>& update) override;
+
+    size_t getMemoryUsage() override;
+
+    /**
+     * @returns The number of queries in this process which failed with BusyError because the database was locked.
+     */
+    static juce::int64 getNumBusyErrors();
+
+private:
+    static constexpr int kBusyTimeoutMs = 1000;
+    static constexpr int kReadBusyTimeoutMs = 20;
+
+    std::unique_ptr<SQLite::Database> database_;
+    std::unique_ptr<SQLite::Database> readOnlyDatabase_; // Nullptr when the database lives in memory.
+    std::atomic<juce::int64> numWrites_ { 0 };
+    std::mutex writeMutex_; // Serialises transactions on database_.
+
+    static std::atomic<juce::int64> numBusyErrors_;
+
+    void initialise (int cacheSizeKiB);
+
+    /**
+     * Runs given query on the read-only connection.
+     * @throws BusyError If the database is locked for longer than kReadBusyTimeoutMs.
+     */
+    template <typename Function>
+    auto read (Function&& function);
+    static void migrate (SQLite::Database& database);
+};
+
+} // namespace indiekey
@@ -0,0 +1,35 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "CancellationToken.h"
+#include "RestClient.h"
+
+namespace indiekey
+{
+
+/**
+ * Sends the requests of a RestClient. WebTransport talks to the server, other implementations decorate a transport to
+ * record, replay or inject faults, see CassetteTransport and FaultInjectingTransport. Implementations must be safe to
+ * use from multiple threads at once, as one transport can be shared by many clients.
+ */
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    /**
+     * Sends given request and waits for the response.
+     * @param request The request to send.
+     * @param cancellationToken Optional token which aborts the request, also while it is waiting for the server.
+     * @returns The response of the server, also when it indicates an error.
+     * @throws std::runtime_error If the server could not be reached.
+     * @throws CancellationToken::Cancelled If the request was cancelled.
+     */
+    virtual RestClient::Response send (const RestClient::Request& request, CancellationToken* cancellationToken) = 0;
+};
+
+} // namespace indiekey
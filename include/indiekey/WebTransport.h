@@ -0,0 +1,22 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "Transport.h"
+
+namespace indiekey
+{
+
+/**
+ * Sends requests to the server over HTTP(S). This is the default transport of RestClient.
+ */
+class WebTransport : public Transport
+{
+public:
+    RestClient::Response send (const RestClient::Request& request, CancellationToken* cancellationToken) override;
+};
+
+} // namespace indiekey
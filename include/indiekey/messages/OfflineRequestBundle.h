@@ -0,0 +1,39 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "OfflineRequest.h"
+
+namespace indiekey
+{
+
+/**
+ * Multiple offline requests, possibly for different products, which are saved to a single file.
+ */
+struct OfflineRequestBundle
+{
+    std::vector<OfflineRequest> requests;
+};
+
+[[maybe_unused]] static void from_json (const nlohmann::json& json, OfflineRequestBundle& bundle)
+{
+    bundle.requests.clear();
+
+    for (const auto& request : json.at ("OfflineRequestBundle"))
+        bundle.requests.push_back (request.get<OfflineRequest>());
+}
+
+[[maybe_unused]] static void to_json (nlohmann::json& json, const OfflineRequestBundle& bundle)
+{
+    auto requests = nlohmann::json::array();
+
+    for (const auto& request : bundle.requests)
+        requests.push_back (request);
+
+    json = { { "OfflineRequestBundle", std::move (requests) } };
+}
+
+} // namespace indiekey
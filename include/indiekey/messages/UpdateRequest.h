@@ -0,0 +1,50 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace indiekey
+{
+
+/**
+ * Asks the server to update activations, identified by their hash only. The server looks up everything else, which
+ * keeps the request a fraction of the size of sending the activations themselves.
+ */
+struct UpdateRequest
+{
+public:
+    UpdateRequest (std::string productUid, std::string machineUid, std::vector<std::string> activationHashes) :
+        productUid_ (std::move (productUid)),
+        machineUid_ (std::move (machineUid)),
+        activationHashes_ (std::move (activationHashes))
+    {
+    }
+
+    [[nodiscard]] nlohmann::json toJson() const
+    {
+        nlohmann::json json;
+        json["product_uid"] = productUid_;
+        json["machine_uid"] = machineUid_;
+        json["activation_hashes"] = activationHashes_;
+        return json;
+    }
+
+private:
+    std::string productUid_;
+    std::string machineUid_;
+    std::vector<std::string> activationHashes_; // Base64 encoded.
+};
+
+static void to_json (nlohmann::json& j, const UpdateRequest& request)
+{
+    j = request.toJson();
+}
+
+} // namespace indiekey
@@ -5,6 +5,20 @@
 
 #include "src/Activation.cpp"
 #include "src/ActivationClient.cpp"
+#include "src/ActivationStore.cpp"
 #include "src/ActivationsDatabase.cpp"
+#include "src/CancellationToken.cpp"
+#include "src/CassetteTransport.cpp"
+#include "src/CircuitBreaker.cpp"
+#include "src/Clock.cpp"
 #include "src/Crypto.cpp"
+#include "src/FaultInjectingTransport.cpp"
+#include "src/FileActivationStore.cpp"
+#include "src/MemoryActivationStore.cpp"
+#include "src/RefreshScheduler.cpp"
+#include "src/RequestBudget.cpp"
 #include "src/RestClient.cpp"
+#include "src/SerialQueue.cpp"
+#include "src/SharedStatusCache.cpp"
+#include "src/SqliteActivationStore.cpp"
+#include "src/WebTransport.cpp"
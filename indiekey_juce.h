@@ -9,7 +9,7 @@
     website:              https://indiekey.io
     license:              AGPLv3/Commercial
     searchpaths:          include
-    dependencies:         juce_core
+    dependencies:         juce_core juce_events
     minimumCppStandard:   17
     OSXLibs:              sodium sqlite3 SQLiteCpp
     linuxLibs:            sodium sqlite3 SQLiteCpp
@@ -6,7 +6,6 @@
 #include "indiekey/Activation.h"
 #include "indiekey/Encoding.h"
 
-#include <sodium/core.h>
 #include <sodium/crypto_sign.h>
 
 #include <utility>
@@ -25,6 +24,10 @@ void indiekey::Activation::fromJson (const nlohmann::json& json)
 
     licenseType_ = License::typeFromString (json.at ("license_type").get<std::string>());
     signature_ = decodeFromBase64 (json.at ("signature").get<std::string>());
+
+    // Optional, in milliseconds like all other times.
+    if (auto it = json.find ("refresh_interval"); it != json.end() && !it->is_null())
+        refreshInterval_ = juce::RelativeTime::milliseconds (it->get<int64_t>());
 }
 
 nlohmann::json indiekey::Activation::toJson() const
@@ -40,6 +43,9 @@ nlohmann::json indiekey::Activation::toJson() const
     json["license_type"] = License::typeToString (licenseType_);
     json["signature"] = encodeToBase64 (signature_);
 
+    if (refreshInterval_.has_value())
+        json["refresh_interval"] = refreshInterval_->inMilliseconds();
+
     return json;
 }
 
@@ -48,8 +54,15 @@ indiekey::Activation::Status indiekey::Activation::validate (
     const std::vector<uint8_t>& machineUid,
     const std::vector<uint8_t>& verifyingKey)
 {
-    auto now = juce::Time::getCurrentTime();
+    return validate (productUid, machineUid, verifyingKey, Clock::getSystemClock().now());
+}
 
+indiekey::Activation::Status indiekey::Activation::validate (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    const std::vector<uint8_t>& verifyingKey,
+    juce::Time now)
+{
     if (productUid != productUid_)
         status_ = indiekey::Activation::Status::InvalidProductUid;
     else if (machineUid != machineUid_)
@@ -68,9 +81,6 @@ indiekey::Activation::Status indiekey::Activation::validate (
 
 bool indiekey::Activation::verifySignature (const std::vector<uint8_t>& verifyingKey) const
 {
-    if (sodium_init() == -1)
-        throw std::runtime_error ("Initialisation failure");
-
     if (verifyingKey.size() != crypto_sign_PUBLICKEYBYTES)
         return false;
 
@@ -184,57 +194,60 @@ indiekey::Activation::Activation (
     std::optional<juce::Time> expiresAt,
     std::optional<juce::Time> licenseExpiresAt,
     License::Type licenseType,
-    std::vector<uint8_t> signature) :
+    std::vector<uint8_t> signature,
+    std::optional<juce::RelativeTime> refreshInterval) :
     hash_ (std::move (hash)),
     productUid_ (std::move (productUid)),
     machineUid_ (std::move (machineUid)),
     expiresAt_ (expiresAt),
     licenseExpiresAt_ (licenseExpiresAt),
     licenseType_ (licenseType),
-    signature_ (std::move (signature))
+    signature_ (std::move (signature)),
+    refreshInterval_ (refreshInterval)
 {
 }
 
+const std::optional<juce::RelativeTime>& indiekey::Activation::getRefreshInterval() const
+{
+    return refreshInterval_;
+}
+
 bool indiekey::Activation::isMoreValuableThan (const indiekey::Activation& other) const
 {
-    if (isExpired() && !other.isExpired())
-        return false;
+    return isMoreValuableThan (other, Clock::getSystemClock().now());
+}
 
-    if (other.isExpired())
-        return true;
+bool indiekey::Activation::isMoreValuableThan (const indiekey::Activation& other, juce::Time now) const
+{
+    // Note: ActivationsDatabase::getMostValuableActivation implements the same ordering in SQL, keep both in sync.
+
+    if (const auto expired = isExpired (now), otherExpired = other.isExpired (now); expired != otherExpired)
+        return otherExpired;
 
     if (licenseExpiresAt_ != other.licenseExpiresAt_)
     {
-        if (licenseExpiresAt_.has_value())
-        {
-            if (other.licenseExpiresAt_.has_value())
-            {
-                if (licenseExpiresAt_.value() > other.licenseExpiresAt_.value())
-                    return true;
-            }
-            else
-            {
-                return false; // Other is more valuable because it doesn't expire whereas this does.
-            }
-        }
-        else
-        {
-            return true; // Only this or both don't expire in which case we consider this to be more valuable
-        }
-    }
+        if (!licenseExpiresAt_.has_value())
+            return true; // This license doesn't expire whereas the other does.
 
-    if (expiresAt_ > other.expiresAt_)
-        return true;
+        if (!other.licenseExpiresAt_.has_value())
+            return false; // Other is more valuable because it doesn't expire whereas this does.
 
-    if (expiresAt_ < other.expiresAt_)
-        return false;
+        return licenseExpiresAt_.value() > other.licenseExpiresAt_.value();
+    }
+
+    if (expiresAt_ != other.expiresAt_)
+        return expiresAt_ > other.expiresAt_;
 
     return License::compareTypeValue (licenseType_, other.licenseType_) > 0;
 }
 
 bool indiekey::Activation::isExpired() const
 {
-    auto now = juce::Time::getCurrentTime();
+    return isExpired (Clock::getSystemClock().now());
+}
+
+bool indiekey::Activation::isExpired (juce::Time now) const
+{
     if (expiresAt_.has_value() && now > expiresAt_.value())
         return true;
     if (licenseExpiresAt_.has_value() && now > licenseExpiresAt_.value())
@@ -278,16 +291,25 @@ const char* indiekey::Activation::getStatusUserMessage (bool hideDetails) const
 }
 
 std::string indiekey::Activation::getSummary() const
+{
+    return getSummary (Clock::getSystemClock().now());
+}
+
+std::string indiekey::Activation::getSummary (juce::Time now) const
 {
     auto text = std::string (License::typeToString (licenseType_)) + " license is " + getStatusAsString();
-    text += std::string (", activation expires on ") + expiryDateAsString (expiresAt_);
-    text += std::string (" and the license itself expires on ") + expiryDateAsString (licenseExpiresAt_);
+    text += std::string (", activation expires on ") + expiryDateAsString (expiresAt_, now);
+    text += std::string (" and the license itself expires on ") + expiryDateAsString (licenseExpiresAt_, now);
     return text;
 }
 
-std::string indiekey::Activation::expiryDateAsString (std::optional<juce::Time> expiryTime)
+size_t indiekey::Activation::getMemoryUsage() const
+{
+    return sizeof (*this) + hash_.capacity() + productUid_.capacity() + machineUid_.capacity() + signature_.capacity();
+}
+
+std::string indiekey::Activation::expiryDateAsString (std::optional<juce::Time> expiryTime, juce::Time now)
 {
-    auto now = juce::Time::getCurrentTime();
     if (expiryTime.has_value())
     {
         return expiryTime->toString (true, true, false).toStdString() + " (which is " +
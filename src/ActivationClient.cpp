@@ -8,8 +8,14 @@
 #include "indiekey/Endpoints.h"
 #include "indiekey/ProductData.h"
 #include "indiekey/messages/ActivationRequest.h"
-#include "indiekey/messages/OfflineRequest.h"
+#include "indiekey/messages/OfflineRequestBundle.h"
 #include "indiekey/messages/TrialRequest.h"
+#include "indiekey/messages/UpdateRequest.h"
+
+#include <fstream>
+#include <future>
+#include <map>
+#include <thread>
 
 const char* indiekey::ActivationClient::trialStatusToString (const TrialStatus status)
 {
@@ -33,15 +39,43 @@ indiekey::ActivationClient::ActivationClient()
     crypto::init();
 }
 
+indiekey::ActivationClient::~ActivationClient()
+{
+    // A notification which is still pending must not be delivered by a client which is being destroyed.
+    cancelPendingUpdate();
+
+    // Aborts requests which are in flight, so that the waits below are short. Requests which didn't start yet fail
+    // right away.
+    cancellationToken_.cancel();
+
+    {
+        std::lock_guard refreshLock (refreshMutex_);
+        refreshCompleted_.notify_all();
+    }
+
+    // Blocks until a refresh which might be running on the scheduler thread finished.
+    refreshScheduler_->removeClient (this);
+
+    // Calls from other threads which are still running use the members, so they must finish before the members go
+    // away. Without a timeout: they were cancelled, and giving up would leave them running against destroyed members.
+    workQueue_.waitUntilIdle();
+}
+
 int indiekey::ActivationClient::ping (const int value) const
 {
-    auto response = restClient_->get ("/ping?timestamp=" + juce::String (value));
-    response.throwIfNotSuccessful();
-    const auto jsonResponse = nlohmann::json::parse (response.body.toRawUTF8());
-    return jsonResponse["timestamp"].get<int>();
+    int timestamp = 0;
+
+    workQueue_.run ([&] {
+        auto response = restClient_->get ("/ping?timestamp=" + juce::String (value), &cancellationToken_);
+        response.throwIfNotSuccessful();
+        const auto jsonResponse = nlohmann::json::parse (response.body.toRawUTF8());
+        timestamp = jsonResponse["timestamp"].get<int>();
+    });
+
+    return timestamp;
 }
 
-void indiekey::ActivationClient::setProductData (const char* encodedProductData)
+void indiekey::ActivationClient::setProductData (const char* encodedProductData, bool openDatabaseInBackground)
 {
     if (encodedProductData == nullptr)
         throw std::runtime_error ("Product data is invalid");
@@ -51,106 +85,542 @@ void indiekey::ActivationClient::setProductData (const char* encodedProductData)
 
     nlohmann::json const jsonData = nlohmann::json::parse (decodeFromBase64 (encodedProductData));
 
-    if (productData_ == nullptr)
-        productData_ = std::make_unique<ProductData>();
+    setProductData (jsonData.get<ProductData>(), openDatabaseInBackground);
+}
+
+void indiekey::ActivationClient::setProductData (const ProductData& productData, bool openDatabaseInBackground)
+{
+    setProductData (
+        productData,
+        ActivationsDatabase::Options { getLocalActivationsDatabaseFile (productData), openDatabaseInBackground });
+}
+
+void indiekey::ActivationClient::setProductData (
+    const ProductData& productData,
+    const ActivationsDatabase::Options& databaseOptions)
+{
+    if (productData.productUid.empty())
+        throw std::runtime_error ("Product data is invalid");
+
+    workQueue_.run ([&] {
+        // Published as a new copy, so that readers on other threads never see a partially updated one.
+        auto previous = std::atomic_exchange (&productData_, std::make_shared<const ProductData> (productData));
 
-    *productData_ = jsonData.get<ProductData>();
+        if (previous != nullptr)
+            replacedProductData_.push_back (std::move (previous));
 
-    restClient_ = std::make_unique<RestClient> (juce::URL (productData_->primaryPublicServerAddress));
+        restClient_ = std::make_unique<RestClient> (juce::URL (productData_->primaryPublicServerAddress), transport_);
+        useFullUpdateRequests_.reset(); // The server might be a different one.
 
-    activationsDatabase_.openDatabase (ActivationsDatabase::Options { getLocalActivationsDatabaseFile() });
+        activationsDatabase_.openDatabase (databaseOptions);
+
+        // Other processes can only read the same activations when they are stored in a file.
+        auto isStoredInFile = !databaseOptions.inMemory &&
+                              databaseOptions.backend != ActivationsDatabase::Backend::Memory &&
+                              databaseOptions.databaseFile != juce::File();
+        statusCache_ = isStoredInFile
+                           ? std::make_unique<SharedStatusCache> (databaseOptions.databaseFile, sharedStatusRegion_)
+                           : nullptr;
+    });
 }
 
 void indiekey::ActivationClient::validate (const ValidationStrategy validationStrategy)
+{
+    validate (validationStrategy, {});
+}
+
+void indiekey::ActivationClient::validate (const ValidationStrategy validationStrategy, juce::RelativeTime deadline)
 {
     juce::ErasedScopeGuard callListeners ([this] {
-        listeners_.call ([this] (Subscriber& s) {
-            s.onActivationsUpdated (mostValuableActivation_.get());
-        });
+        notifySubscribersIfChanged();
     });
 
+    // Identical validations which are waiting in the queue are merged, as they would have the same outcome.
+    workQueue_.run ("validate " + std::to_string (static_cast<int> (validationStrategy)), [this, validationStrategy] {
+        validateWithoutNotifying (validationStrategy);
+    });
+
+    if (validationStrategy != ValidationStrategy::StaleWhileRevalidate)
+        return;
+
+    auto loadedActivation = getLoadedActivation();
+
+    // A valid activation is served right away, the scheduler refreshes it in the background when it's due.
+    if (loadedActivation == nullptr || loadedActivation->getStatus() == Activation::Status::Valid)
+        return;
+
+    // Only an update might turn up a renewed activation. This deliberately ignores when the scheduler will refresh,
+    // which can be later because of the minimum refresh interval or the request budget.
+    auto now = getClock().now();
+    auto nextUpdateAt = nextUpdateAt_.load();
+    auto isExpired = loadedActivation->getStatus() == Activation::Status::ActivationExpired ||
+                     loadedActivation->getStatus() == Activation::Status::LicenseExpired;
+
+    if (isExpired || (nextUpdateAt != 0 && nextUpdateAt <= now.toMilliseconds()))
+        refreshInBackground (now, deadline);
+}
+
+void indiekey::ActivationClient::refreshInBackground (juce::Time now, std::optional<juce::RelativeTime> deadline)
+{
+    std::unique_lock refreshLock (refreshMutex_);
+    auto numCompletedRefreshes = numCompletedRefreshes_;
+
+    // Let the scheduler thread pick this client up right away. The refresh updates the loaded activation and notifies
+    // subscribers when the result changed.
+    nextRefreshAt_ = std::max<juce::int64> (now.toMilliseconds(), 1);
+    refreshScheduler_->reschedule();
+
+    if (!deadline.has_value() || deadline->inMilliseconds() <= 0)
+        return;
+
+    refreshCompleted_.wait_for (refreshLock, std::chrono::milliseconds (deadline->inMilliseconds()), [&] {
+        return numCompletedRefreshes_ != numCompletedRefreshes;
+    });
+}
+
+void indiekey::ActivationClient::validateWithoutNotifying (const ValidationStrategy validationStrategy)
+{
     throwIfProductDataIsNotSet();
 
-    updateActivations (validationStrategy);
+    auto now = getClock().now();
+
+    updateActivations (validationStrategy, now);
+
+    const auto& productUid = productData_->productUid;
+    const auto& machineUid = getUniqueMachineId();
+
+    // Local validations take over the result another process published, without reading the database. Lookups which
+    // miss fall through to the database. Online validations only need the version of the slot, so that their result
+    // is published as well.
+    auto isLocal = validationStrategy == ValidationStrategy::LocalOnly ||
+                   validationStrategy == ValidationStrategy::LocalValidOnly ||
+                   validationStrategy == ValidationStrategy::StaleWhileRevalidate;
 
-    auto activations = activationsDatabase_.getActivations (productData_->productUid, getUniqueMachineId());
+    SharedStatusCache::Lookup sharedStatus;
 
-    auto mostValuableActivation = findMostValuableActivation (activations);
+    if (statusCache_ != nullptr)
+        sharedStatus = statusCache_->lookup (productUid, machineUid, productData_->verifyingKey, now);
 
-    if (mostValuableActivation != activations.end())
+    if (isLocal && sharedStatus.entry.has_value())
     {
-        auto activation = std::make_unique<Activation> (*mostValuableActivation);
-        auto status = activation->validate (productData_->productUid, getUniqueMachineId(), productData_->verifyingKey);
+        std::shared_ptr<Activation> loadedActivation;
+        if (sharedStatus.entry->activation.has_value())
+            loadedActivation = std::make_shared<Activation> (std::move (*sharedStatus.entry->activation));
+
+        std::atomic_store (&mostValuableActivation_, std::shared_ptr<const Activation> (std::move (loadedActivation)));
+        scheduleNextRefresh (now, sharedStatus.entry->nextUpdateTime);
+        return;
+    }
+
+    std::optional<Activation> mostValuableActivation;
+    std::optional<juce::Time> nextUpdateTime;
+    auto isBusy = false;
+
+    try
+    {
+        mostValuableActivation = activationsDatabase_.getMostValuableActivation (productUid, machineUid, now);
+        nextUpdateTime = activationsDatabase_.getNextUpdateTime (productUid, machineUid);
+    }
+    catch (const ActivationStore::BusyError&)
+    {
+        // Another process is writing. Rather than waiting, re-validate the activation which is already loaded. The
+        // database is read again on the retry scheduled by scheduleNextRefresh.
+        if (auto loaded = getLoadedActivation())
+            mostValuableActivation = *loaded;
+
+        nextUpdateTime = now + juce::RelativeTime::seconds (kBusyRetrySeconds);
+        isBusy = true;
+    }
+
+    std::shared_ptr<Activation> validatedActivation;
+    std::shared_ptr<Activation> loadedActivation;
+
+    if (mostValuableActivation.has_value())
+    {
+        validatedActivation = std::make_shared<Activation> (std::move (*mostValuableActivation));
+        auto status = validatedActivation->validate (productUid, machineUid, productData_->verifyingKey, now);
 
         // When the strategy is ValidationStrategy::LocalValidOnly we only store the activation when it is valid in
         // order to allow a first, quick check without triggering warnings when an activation is not valid.
         if (validationStrategy != ValidationStrategy::LocalValidOnly || status == Activation::Status::Valid)
+            loadedActivation = validatedActivation;
+    }
+
+    // When no activation is available this resets the loaded activation. The activation is not modified after it has
+    // been published, so that readers can use it without locking.
+    std::atomic_store (&mostValuableActivation_, std::shared_ptr<const Activation> (std::move (loadedActivation)));
+
+    // What was read while another process was writing might already be outdated, so it's not shared. Activations which
+    // are not valid empty the slot, see SharedStatusCache::publish.
+    if (statusCache_ != nullptr && !isBusy)
+    {
+        auto version = sharedStatus.version;
+        statusCache_->publish (productUid, machineUid, version, validatedActivation.get(), nextUpdateTime, now);
+    }
+
+    scheduleNextRefresh (now, nextUpdateTime);
+}
+
+void indiekey::ActivationClient::scheduleNextRefresh (juce::Time now, std::optional<juce::Time> nextUpdateTime)
+{
+    nextUpdateAt_ = nextUpdateTime.has_value() ? nextUpdateTime->toMilliseconds() : 0;
+
+    auto nextRefreshTime = nextUpdateTime;
+
+    // While the server is unreachable the next refresh probes it, updates are skipped until then anyway.
+    if (nextRefreshTime.has_value())
+    {
+        if (auto nextProbeTime = circuitBreaker_->getNextProbeTime (productData_->primaryPublicServerAddress))
+            nextRefreshTime = *nextProbeTime;
+    }
+
+    // Refreshing before the budget allows another request would only validate locally again.
+    if (nextRefreshTime.has_value())
+        nextRefreshTime = std::max (*nextRefreshTime, requestBudget_->getNextAvailableTime (activationsDatabase_, now));
+
+    // Re-validate right after the loaded activation expires, so that the status also changes without network.
+    if (auto loadedActivation = getLoadedActivation())
+    {
+        for (const auto& expiry : { loadedActivation->getExpiresAt(), loadedActivation->getLicenseExpiresAt() })
         {
-            mostValuableActivation_ = std::move (activation);
-            return;
+            if (!expiry.has_value() || *expiry < now)
+                continue;
+
+            auto expiredAt = *expiry + juce::RelativeTime::milliseconds (1);
+
+            if (!nextRefreshTime.has_value() || expiredAt < *nextRefreshTime)
+                nextRefreshTime = expiredAt;
         }
     }
 
-    // At this point no activation is available, so let's reset.
-    mostValuableActivation_.reset();
+    // Whatever the activations ask for, a refresh never immediately follows the previous one.
+    if (nextRefreshTime.has_value() && lastRefreshAt_ != 0)
+    {
+        auto earliest = juce::Time (lastRefreshAt_) + juce::RelativeTime::seconds (kMinRefreshIntervalSeconds);
+        nextRefreshTime = std::max (*nextRefreshTime, earliest);
+    }
+
+    nextRefreshAt_ = nextRefreshTime.has_value() ? nextRefreshTime->toMilliseconds() : 0;
+
+    if (!registeredForRefresh_)
+    {
+        registeredForRefresh_ = true;
+        refreshScheduler_->addClient (this);
+    }
+    else
+    {
+        refreshScheduler_->reschedule();
+    }
+}
+
+void indiekey::ActivationClient::invalidateSharedStatus (const std::string& productUid)
+{
+    if (statusCache_ != nullptr)
+        statusCache_->invalidate (productUid, getUniqueMachineId());
 }
 
-void indiekey::ActivationClient::activate (const std::string& emailAddress, const std::string& licenseKey)
+void indiekey::ActivationClient::notifySubscribersIfChanged()
 {
-    throwIfProductDataIsNotSet();
+    const juce::ScopedLock lock (lock_);
 
+    // Bursts of calls result in a single notification, because the AsyncUpdater coalesces pending updates.
+    if (!newSubscribers_.empty() || !isSameResult (getLoadedActivation().get(), notifiedActivation_.get()))
+        triggerAsyncUpdate();
+}
+
+std::optional<juce::RelativeTime> indiekey::ActivationClient::getTimeUntilNextRefresh()
+{
+    auto nextRefreshAt = nextRefreshAt_.load();
+
+    if (nextRefreshAt == 0)
+        return std::nullopt;
+
+    return juce::Time (nextRefreshAt) - getClock().now();
+}
+
+std::optional<juce::RelativeTime> indiekey::ActivationClient::getTimeUntilIdle()
+{
+    return activationsDatabase_.getTimeUntilIdle();
+}
+
+void indiekey::ActivationClient::releaseIdleResources()
+{
+    workQueue_.run ("release", [this] {
+        activationsDatabase_.releaseIfIdle();
+    });
+}
+
+void indiekey::ActivationClient::refresh()
+{
+    workQueue_.run ("refresh", [this] {
+        try
+        {
+            lastRefreshAt_ = getClock().now().toMilliseconds();
+            probeServerIfDue (getClock().now());
+            validateWithoutNotifying (ValidationStrategy::Online);
+            numFailedRefreshes_ = 0;
+        }
+        catch (const std::exception&)
+        {
+            // Most likely the server couldn't be reached. Re-validate locally so that expiry is still picked up, and
+            // try again later with an exponential backoff.
+            try
+            {
+                validateWithoutNotifying (ValidationStrategy::LocalOnly);
+            }
+            catch (const std::exception&)
+            {
+            }
+
+            numFailedRefreshes_ = std::min (numFailedRefreshes_ + 1, 8);
+            auto backoffMinutes = std::min (kMaxRefreshBackoffMinutes, 1 << (numFailedRefreshes_ - 1));
+            auto backoff = juce::RelativeTime::minutes (
+                backoffMinutes * ActivationsDatabase::getRefreshJitterFactor (getUniqueMachineId()));
+            nextRefreshAt_ = (getClock().now() + backoff).toMilliseconds();
+        }
+
+        // Rate limited by the database itself, so usually this returns right away.
+        try
+        {
+            auto report = activationsDatabase_.runMaintenance (getClock().now());
+
+            if (report.ran)
+                DBG ("Activations database maintenance: pruned " << report.numRowsPruned << " rows, reclaimed "
+                                                                 << report.numBytesReclaimed << " bytes");
+        }
+        catch (const std::exception& e)
+        {
+            juce::ignoreUnused (e);
+            DBG ("Activations database maintenance failed: " << e.what());
+        }
+    });
+
+    {
+        std::lock_guard refreshLock (refreshMutex_);
+        numCompletedRefreshes_++;
+    }
+
+    refreshCompleted_.notify_all();
+
+    notifySubscribersIfChanged();
+}
+
+bool indiekey::ActivationClient::isSameResult (const Activation* a, const Activation* b)
+{
+    if (a == nullptr || b == nullptr)
+        return a == b;
+
+    return a->getHash() == b->getHash() && a->getStatus() == b->getStatus() &&
+           a->getExpiresAt() == b->getExpiresAt() && a->getLicenseExpiresAt() == b->getLicenseExpiresAt() &&
+           a->getLicenseType() == b->getLicenseType();
+}
+
+void indiekey::ActivationClient::handleAsyncUpdate()
+{
+    auto loadedActivation = getLoadedActivation();
+    std::vector<Subscriber*> newSubscribers;
+    bool changed;
+
+    // Subscribers are called without holding lock_, so that they can call back into this client.
+    {
+        const juce::ScopedLock lock (lock_);
+
+        newSubscribers = std::exchange (newSubscribers_, {});
+        changed = !isSameResult (loadedActivation.get(), notifiedActivation_.get());
+
+        if (changed)
+            notifiedActivation_ = loadedActivation;
+    }
+
+    if (changed)
+    {
+        listeners_.call ([&loadedActivation] (Subscriber& s) {
+            s.onActivationsUpdated (loadedActivation.get());
+        });
+
+        return;
+    }
+
+    // Nothing changed, only subscribers which were added since the last notification need the current state.
+    for (auto* subscriber : newSubscribers)
+        if (listeners_.contains (subscriber))
+            subscriber->onActivationsUpdated (loadedActivation.get());
+}
+
+void indiekey::ActivationClient::activate (const std::string& emailAddress, const std::string& licenseKey)
+{
     if (emailAddress.empty())
         throw std::runtime_error ("Email address is empty");
 
     if (licenseKey.empty())
         throw std::runtime_error ("License key is empty");
 
-    ActivationRequest const activationRequest (
-        productData_->productUid,
-        getUniqueMachineIdAsBase64(),
-        emailAddress,
-        licenseKey,
-        deviceInfo_);
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
 
-    auto response = restClient_->post (ENDPOINT_ACTIVATE, activationRequest);
-    response.throwIfNotSuccessful();
-    installActivation (nlohmann::json::parse (response.body.toRawUTF8()).get<Activation>());
+        auto deviceInfo = getDeviceInfoToSend();
+
+        ActivationRequest const activationRequest (
+            productData_->productUid,
+            getUniqueMachineIdAsBase64(),
+            emailAddress,
+            licenseKey,
+            deviceInfo);
+
+        auto response = postToServer (ENDPOINT_ACTIVATE, activationRequest);
+        response.throwIfNotSuccessful();
+        setDeviceInfoSent (deviceInfo);
+        installActivation (nlohmann::json::parse (response.body.toRawUTF8()).get<Activation>());
+    });
 }
 
-std::vector<uint8_t> indiekey::ActivationClient::getUniqueMachineId()
+const std::vector<uint8_t>& indiekey::ActivationClient::getUniqueMachineId()
 {
-    auto uniqueId = juce::SystemStats::getUniqueDeviceID().toStdString();
+    // The machine id doesn't change while the process runs, and querying it is relatively expensive.
+    static const auto machineId = [] {
+        auto uniqueId = juce::SystemStats::getUniqueDeviceID().toStdString();
+
+        if (uniqueId.empty())
+            throw std::runtime_error ("Failed to get unique machine id");
 
-    if (uniqueId.empty())
-        throw std::runtime_error ("Failed to get unique machine id");
+        return crypto::genericHash (uniqueId);
+    }();
 
-    return crypto::genericHash (uniqueId);
+    return machineId;
 }
 
-std::string indiekey::ActivationClient::getUniqueMachineIdAsBase64()
+const std::string& indiekey::ActivationClient::getUniqueMachineIdAsBase64()
 {
-    return encodeToBase64 (getUniqueMachineId());
+    static const auto machineId = encodeToBase64 (getUniqueMachineId());
+    return machineId;
 }
 
-void indiekey::ActivationClient::updateActivations (ValidationStrategy validationStrategy)
+indiekey::RestClient::Response indiekey::ActivationClient::postToServer (
+    juce::StringRef path,
+    const nlohmann::json& postData,
+    bool isNotFoundReported)
+{
+    const auto& serverAddress = productData_->primaryPublicServerAddress;
+    RestClient::Response response;
+
+    try
+    {
+        response = restClient_->post (path, postData, &cancellationToken_);
+    }
+    catch (const CancellationToken::Cancelled&)
+    {
+        throw;
+    }
+    catch (const std::exception&)
+    {
+        circuitBreaker_->recordFailure (activationsDatabase_, serverAddress, getClock().now());
+        throw;
+    }
+
+    if (response.isServerError())
+        circuitBreaker_->recordFailure (activationsDatabase_, serverAddress, getClock().now());
+    else if (isNotFoundReported || response.statusCode != 404)
+        circuitBreaker_->recordSuccess (activationsDatabase_, serverAddress);
+
+    return response;
+}
+
+void indiekey::ActivationClient::probeServerIfDue (juce::Time now)
+{
+    throwIfProductDataIsNotSet();
+
+    const auto& serverAddress = productData_->primaryPublicServerAddress;
+
+    if (!circuitBreaker_->tryStartProbe (activationsDatabase_, serverAddress, now))
+        return;
+
+    try
+    {
+        auto response = restClient_->get ("/ping?timestamp=0", &cancellationToken_);
+
+        // A failed probe already postponed the next one, see CircuitBreaker::tryStartProbe.
+        if (!response.isServerError())
+            circuitBreaker_->recordSuccess (activationsDatabase_, serverAddress);
+    }
+    catch (const CancellationToken::Cancelled&)
+    {
+        throw;
+    }
+    catch (const std::exception&)
+    {
+    }
+}
+
+void indiekey::ActivationClient::updateActivations (ValidationStrategy validationStrategy, juce::Time now)
 {
     throwIfProductDataIsNotSet();
 
-    if (validationStrategy == ValidationStrategy::LocalOnly || validationStrategy == ValidationStrategy::LocalValidOnly)
-        return; // Nothing to do here.
+    if (validationStrategy == ValidationStrategy::LocalOnly ||
+        validationStrategy == ValidationStrategy::LocalValidOnly ||
+        validationStrategy == ValidationStrategy::StaleWhileRevalidate)
+        return; // Nothing to do here, StaleWhileRevalidate refreshes in the background.
 
     auto requestActivations = getAllActivationsWhichNeedToBeUpdated (
-        validationStrategy == ValidationStrategy::ForceOnline);
+        validationStrategy == ValidationStrategy::ForceOnline,
+        now);
 
     if (requestActivations.empty())
         return; // Nothing to do at this moment.
 
-    auto response = restClient_->post (ENDPOINT_UPDATE_ACTIVATIONS, requestActivations);
+    // While the server is unreachable the request would only wait for a timeout. Like over budget, no request is sent
+    // and the caller continues with the locally stored activations. Forced validations always try, so that the host
+    // can find out the server is back without waiting for a background probe, and its outcome closes the circuit.
+    if (validationStrategy != ValidationStrategy::ForceOnline &&
+        !circuitBreaker_->allowRequest (activationsDatabase_, productData_->primaryPublicServerAddress))
+        return;
+
+    if (!requestBudget_->tryAcquire (activationsDatabase_, now))
+    {
+        numThrottledRequests_++;
+        return;
+    }
+
+    RestClient::Response response;
+
+    // Remembered per server in the database, so that a server which doesn't support update requests by hash costs a
+    // single extra request rather than one per session.
+    const auto byHashUnsupportedKey = "update_by_hash_unsupported_at " + productData_->primaryPublicServerAddress;
+
+    if (!useFullUpdateRequests_.has_value())
+    {
+        auto unsupportedAt = activationsDatabase_.getMetadata (byHashUnsupportedKey);
+        useFullUpdateRequests_ = unsupportedAt.has_value() &&
+                                 now - juce::Time (*unsupportedAt) < juce::RelativeTime::days (kUpdateByHashRetryDays);
+    }
+
+    if (!*useFullUpdateRequests_)
+    {
+        std::vector<std::string> hashes;
+        hashes.reserve (requestActivations.size());
+
+        for (const auto& activation : requestActivations)
+            hashes.push_back (encodeToBase64 (activation.getHash()));
+
+        UpdateRequest const updateRequest (productData_->productUid, getUniqueMachineIdAsBase64(), std::move (hashes));
+        // A 404 only tells the endpoint is missing, whether the server works is up to the request which follows.
+        response = postToServer (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH, updateRequest, false);
+
+        // Servers which predate update requests by hash need the activations themselves.
+        if (response.statusCode == 404)
+        {
+            useFullUpdateRequests_ = true;
+            activationsDatabase_.setMetadata (byHashUnsupportedKey, now.toMilliseconds());
+        }
+    }
+
+    if (*useFullUpdateRequests_)
+        response = postToServer (ENDPOINT_UPDATE_ACTIVATIONS, requestActivations);
+
     response.throwIfNotSuccessful();
     auto responseActivations = nlohmann::json::parse (response.body.toRawUTF8()).get<std::vector<Activation>>();
 
     for (auto& activation : responseActivations)
-        activationsDatabase_.saveActivation (activation);
+        activationsDatabase_.saveActivation (activation, now);
 
     // Delete all activations from local disk which are not in the response.
     for (auto& requestActivation : requestActivations)
@@ -169,54 +639,50 @@ void indiekey::ActivationClient::updateActivations (ValidationStrategy validatio
         if (!found)
             activationsDatabase_.deleteActivation (requestActivation.getHash());
     }
+
+    invalidateSharedStatus (productData_->productUid);
 }
 
-std::vector<indiekey::Activation> indiekey::ActivationClient::getAllActivationsWhichNeedToBeUpdated (bool forceUpdate)
+std::vector<indiekey::Activation> indiekey::ActivationClient::getAllActivationsWhichNeedToBeUpdated (
+    bool forceUpdate,
+    juce::Time now)
 {
     throwIfProductDataIsNotSet();
 
     return activationsDatabase_.getActivationsWhichNeedUpdate (
         productData_->productUid,
         getUniqueMachineId(),
-        forceUpdate);
-}
-
-std::vector<indiekey::Activation, std::allocator<indiekey::Activation>>::const_iterator indiekey::ActivationClient::
-    findMostValuableActivation (const std::vector<Activation>& activations)
-{
-    throwIfProductDataIsNotSet();
-
-    if (activations.empty())
-        return activations.cend();
-
-    auto mostValuableActivation = activations.cbegin();
-
-    for (auto it = activations.cbegin(); it != activations.cend(); ++it)
-    {
-        if (it->isMoreValuableThan (*mostValuableActivation))
-            mostValuableActivation = it;
-    }
-
-    return mostValuableActivation;
+        forceUpdate,
+        now);
 }
 
 int indiekey::ActivationClient::destroyAllLocalActivations()
 {
-    throwIfProductDataIsNotSet();
+    int numDeleted = 0;
 
-    return activationsDatabase_.deleteAllActivations (productData_->productUid, getUniqueMachineId());
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
+        numDeleted = activationsDatabase_.deleteAllActivations (productData_->productUid, getUniqueMachineId());
+        invalidateSharedStatus (productData_->productUid);
+    });
+
+    return numDeleted;
 }
 
 void indiekey::ActivationClient::startTrial (const std::string& emailAddress)
 {
-    throwIfProductDataIsNotSet();
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
 
-    TrialRequest trialRequest (productData_->productUid, getUniqueMachineIdAsBase64(), emailAddress, deviceInfo_);
+        auto deviceInfo = getDeviceInfoToSend();
+        TrialRequest trialRequest (productData_->productUid, getUniqueMachineIdAsBase64(), emailAddress, deviceInfo);
 
-    auto response = restClient_->post (ENDPOINT_ACTIVATE_TRIAL, trialRequest);
-    response.throwIfNotSuccessful();
+        auto response = postToServer (ENDPOINT_ACTIVATE_TRIAL, trialRequest);
+        response.throwIfNotSuccessful();
+        setDeviceInfoSent (deviceInfo);
 
-    installActivation (nlohmann::json::parse (response.body.toRawUTF8()).get<Activation>());
+        installActivation (nlohmann::json::parse (response.body.toRawUTF8()).get<Activation>());
+    });
 }
 
 void indiekey::ActivationClient::saveActivationRequest (
@@ -225,82 +691,250 @@ void indiekey::ActivationClient::saveActivationRequest (
     const juce::File& fileToSaveTo,
     bool trial)
 {
-    throwIfProductDataIsNotSet();
+    BundleRequest request { {}, emailAddress, licenseKey, trial };
+    std::optional<std::string> deviceInfo;
 
-    OfflineRequest offlineRequest;
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
+        request.productData = *productData_;
+        deviceInfo = deviceInfo_;
+    });
+
+    auto dump = nlohmann::json (createOfflineRequest (request, deviceInfo)).dump();
+
+    if (!fileToSaveTo.replaceWithData (dump.data(), dump.size()))
+        throw std::runtime_error ("Failed to save activation request");
+}
+
+void indiekey::ActivationClient::saveActivationRequestBundle (
+    const std::vector<BundleRequest>& requests,
+    const juce::File& fileToSaveTo,
+    const std::optional<std::string>& deviceInfo)
+{
+    if (requests.empty())
+        throw std::runtime_error ("No requests to save");
+
+    OfflineRequestBundle bundle;
+    bundle.requests.reserve (requests.size());
 
-    std::optional<std::string> deviceInfo = std::nullopt;
+    for (const auto& request : requests)
+        bundle.requests.push_back (createOfflineRequest (request, deviceInfo));
 
-    if (deviceInfo_)
-        deviceInfo = encodeToBase64 (crypto::boxSeal (deviceInfo_.value(), productData_->cryptoPublicKey));
+    auto dump = nlohmann::json (bundle).dump();
 
-    if (trial)
+    if (!fileToSaveTo.replaceWithData (dump.data(), dump.size()))
+        throw std::runtime_error ("Failed to save activation request bundle");
+}
+
+indiekey::OfflineRequest indiekey::ActivationClient::createOfflineRequest (
+    const BundleRequest& request,
+    const std::optional<std::string>& deviceInfo)
+{
+    const auto& productData = request.productData;
+
+    if (productData.productUid.empty())
+        throw std::runtime_error ("Product data is invalid");
+
+    std::optional<std::string> encryptedDeviceInfo = std::nullopt;
+
+    if (deviceInfo)
+        encryptedDeviceInfo = encodeToBase64 (crypto::boxSeal (deviceInfo.value(), productData.cryptoPublicKey));
+
+    OfflineRequest offlineRequest;
+
+    if (request.trial)
     {
         offlineRequest.trialRequest = OfflineRequest::TrialRequest (
-            productData_->productUid,
+            productData.productUid,
             getUniqueMachineIdAsBase64(),
-            encodeToBase64 (crypto::boxSeal (emailAddress, productData_->cryptoPublicKey)),
-            deviceInfo);
+            encodeToBase64 (crypto::boxSeal (request.emailAddress, productData.cryptoPublicKey)),
+            encryptedDeviceInfo);
     }
     else
     {
         offlineRequest.activationRequest = OfflineRequest::ActivationRequest (
-            productData_->productUid,
+            productData.productUid,
             getUniqueMachineIdAsBase64(),
-            encodeToBase64 (crypto::boxSeal (emailAddress, productData_->cryptoPublicKey)),
-            encodeToBase64 (crypto::boxSeal (licenseKey, productData_->cryptoPublicKey)),
-            deviceInfo);
+            encodeToBase64 (crypto::boxSeal (request.emailAddress, productData.cryptoPublicKey)),
+            encodeToBase64 (crypto::boxSeal (request.licenseKey, productData.cryptoPublicKey)),
+            encryptedDeviceInfo);
     }
 
-    auto dump = nlohmann::json (offlineRequest).dump();
-
-    if (!fileToSaveTo.replaceWithData (dump.data(), dump.size()))
-        throw std::runtime_error ("Failed to save activation request");
+    return offlineRequest;
 }
 
 void indiekey::ActivationClient::installActivationFile (const juce::File& fileToLoad)
 {
-    auto json = fileToLoad.loadFileAsString();
+    std::ifstream stream (fileToLoad.getFullPathName().toStdString(), std::ios::binary);
 
-    if (json.isEmpty())
+    if (!stream)
         throw std::runtime_error ("Failed to load activation file");
 
+    nlohmann::json document;
+
     try
     {
-        auto activation = nlohmann::json::parse (json.toRawUTF8()).get<Activation>();
-        installActivation (std::move (activation));
+        document = nlohmann::json::parse (stream);
     }
-    catch (const std::exception& originalException)
+    catch (const std::exception& e)
     {
-        // Before throwing the original exception, try to parse the file as an offline request to see if the user
-        // accidentally tries to load a request file instead of a response file.
-        try
-        {
-            (void)nlohmann::json::parse (json.toRawUTF8()).get<OfflineRequest>();
-        }
-        catch (const std::exception&)
-        {
-            // Parsing as OfflineRequest failed so something else is going on.
-            throw std::runtime_error (originalException.what());
-        }
+        throw std::runtime_error (e.what());
+    }
 
-        // Parsing as OfflineRequest succeeded so this is likely a request file.
+    // Users sometimes pick the request file they created instead of the response file they received.
+    if (document.is_object() && (document.contains ("ActivationRequest") || document.contains ("TrialRequest") ||
+                                 document.contains ("OfflineRequestBundle")))
         throw std::runtime_error ("This is a request file. Please install a response file.");
+
+    Activation activation;
+
+    try
+    {
+        activation = document.get<Activation>();
+    }
+    catch (const std::exception& e)
+    {
+        throw std::runtime_error (e.what());
     }
+
+    installActivation (std::move (activation));
 }
 
-indiekey::ActivationClient::TrialStatus indiekey::ActivationClient::getTrialStatus()
+int indiekey::ActivationClient::installActivationBundle (
+    const juce::File& fileToLoad,
+    const std::vector<ProductData>& otherProducts)
 {
-    throwIfProductDataIsNotSet();
+    std::map<std::string, ProductData> products;
+
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
+        products[productData_->productUid] = *productData_;
+    });
+
+    for (const auto& productData : otherProducts)
+        products.emplace (productData.productUid, productData);
 
-    auto trialActivations = activationsDatabase_.getTrialActivations (productData_->productUid, getUniqueMachineId());
+    std::ifstream stream (fileToLoad.getFullPathName().toStdString(), std::ios::binary);
+
+    if (!stream)
+        throw std::runtime_error ("Failed to load activation bundle");
+
+    // Parse the file in a single pass. Each activation is converted as soon as its object is complete and then dropped
+    // from the document, so the bundle is never held in memory as a whole. A bundle is an array of objects, which is
+    // checked as soon as the parser gets there, so that other files are rejected before anything is converted.
+    std::vector<Activation> activations;
+
+    try
+    {
+        nlohmann::json::parse (
+            stream,
+            [&activations] (int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed) {
+                using Event = nlohmann::json::parse_event_t;
+
+                if (depth == 0 && event != Event::array_start && event != Event::array_end)
+                    throw std::runtime_error ("This is not an activation bundle");
+
+                if (depth == 1 && (event == Event::array_start || event == Event::value))
+                    throw std::runtime_error ("This is not an activation bundle");
+
+                if (event != Event::object_end || depth != 1)
+                    return true;
+
+                activations.push_back (parsed.get<Activation>());
+                return false;
+            });
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        throw std::runtime_error (std::string ("Failed to read activation bundle: ") + e.what());
+    }
 
-    auto mostValuableTrialActivation = findMostValuableActivation (trialActivations);
+    // Only activations for known products can be verified, the others are left for another product to install.
+    activations.erase (
+        std::remove_if (
+            activations.begin(),
+            activations.end(),
+            [&products] (const Activation& activation) {
+                return products.find (activation.getProductUid()) == products.end();
+            }),
+        activations.end());
 
-    if (mostValuableTrialActivation == trialActivations.end())
+    if (activations.empty())
+        return 0;
+
+    auto now = getClock().now();
+
+    // Verifying signatures is the expensive part, spread it over multiple threads.
+    auto verify = [&] (size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            const auto& productData = products.at (activations[i].getProductUid());
+            (void)activations[i].validate (
+                productData.productUid,
+                getUniqueMachineId(),
+                productData.verifyingKey,
+                now);
+        }
+    };
+
+    auto numThreads = std::clamp<size_t> (std::thread::hardware_concurrency(), 1, kMaxBundleVerificationThreads);
+    auto chunkSize = (activations.size() + numThreads - 1) / numThreads;
+    std::vector<std::future<void>> verifications;
+
+    for (size_t begin = chunkSize; begin < activations.size(); begin += chunkSize)
+        verifications.push_back (
+            std::async (std::launch::async, verify, begin, std::min (begin + chunkSize, activations.size())));
+
+    verify (0, std::min (chunkSize, activations.size()));
+
+    for (auto& verification : verifications)
+        verification.get();
+
+    for (const auto& activation : activations)
+        if (activation.getStatus() != Activation::Status::Valid)
+            throw std::runtime_error (
+                std::string ("Activation failed: ") + Activation::statusToString (activation.getStatus()));
+
+    workQueue_.run ([&] {
+        activationsDatabase_.saveActivations (activations, now);
+
+        for (const auto& activation : activations)
+            invalidateSharedStatus (activation.getProductUid());
+
+        validate (ValidationStrategy::LocalOnly); // Like installActivation, updates are deferred to the scheduler.
+    });
+
+    return static_cast<int> (activations.size());
+}
+
+indiekey::ActivationsDatabase::MaintenanceReport indiekey::ActivationClient::runDatabaseMaintenance()
+{
+    ActivationsDatabase::MaintenanceReport report;
+
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
+        report = activationsDatabase_.runMaintenance (getClock().now(), true);
+    });
+
+    return report;
+}
+
+indiekey::ActivationClient::TrialStatus indiekey::ActivationClient::getTrialStatus()
+{
+    ActivationsDatabase::TrialSummary trialSummary;
+
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
+        trialSummary = activationsDatabase_.getTrialSummary (
+            productData_->productUid,
+            getUniqueMachineId(),
+            getClock().now());
+    });
+
+    if (trialSummary.numTrials == 0)
         return TrialStatus::TrialAvailable; // No trial yet exists which means it is still available.
 
-    if (mostValuableTrialActivation->isExpired())
+    if (trialSummary.numActiveTrials == 0)
         return TrialStatus::TrialExpired;
 
     return TrialStatus::TrialActive;
@@ -308,27 +942,38 @@ indiekey::ActivationClient::TrialStatus indiekey::ActivationClient::getTrialStat
 
 const indiekey::ProductData* indiekey::ActivationClient::getProductData() const
 {
-    return productData_.get();
+    return std::atomic_load (&productData_).get();
 }
 
 void indiekey::ActivationClient::throwIfProductDataIsNotSet() const
 {
-    if (productData_ == nullptr)
+    if (std::atomic_load (&productData_) == nullptr)
         throw std::runtime_error ("Product data not set");
 }
 
 void indiekey::ActivationClient::installActivation (indiekey::Activation&& activation)
 {
-    throwIfProductDataIsNotSet();
+    workQueue_.run ([&] {
+        throwIfProductDataIsNotSet();
+
+        auto now = getClock().now();
 
-    auto status = activation.validate (productData_->productUid, getUniqueMachineId(), productData_->verifyingKey);
+        auto status = activation.validate (
+            productData_->productUid,
+            getUniqueMachineId(),
+            productData_->verifyingKey,
+            now);
 
-    if (status != Activation::Status::Valid)
-        throw std::runtime_error (std::string ("Activation failed: ") + Activation::statusToString (status));
+        if (status != Activation::Status::Valid)
+            throw std::runtime_error (std::string ("Activation failed: ") + Activation::statusToString (status));
 
-    activationsDatabase_.saveActivation (activation);
+        activationsDatabase_.saveActivation (activation, now);
+        invalidateSharedStatus (activation.getProductUid());
 
-    validate (ValidationStrategy::Online);
+        // Works without network, for example on air-gapped machines. Activations which are due for an update are
+        // refreshed later by the scheduler, see scheduleNextRefresh. Runs right away because this runs on the queue.
+        validate (ValidationStrategy::LocalOnly);
+    });
 }
 
 const std::string& indiekey::ActivationClient::getDefaultDeviceInfo()
@@ -341,30 +986,162 @@ const std::string& indiekey::ActivationClient::getDefaultDeviceInfo()
     return stats;
 }
 
+void indiekey::ActivationClient::setClock (const Clock& clock)
+{
+    clock_ = &clock;
+    activationsDatabase_.setClock (clock);
+}
+
+void indiekey::ActivationClient::setTransport (std::shared_ptr<Transport> transport)
+{
+    workQueue_.run ([&] {
+        transport_ = std::move (transport);
+
+        if (productData_ != nullptr)
+        {
+            auto address = juce::URL (productData_->primaryPublicServerAddress);
+            restClient_ = std::make_unique<RestClient> (std::move (address), transport_);
+        }
+    });
+}
+
+void indiekey::ActivationClient::setSharedStatusRegion (const std::string& regionName)
+{
+    workQueue_.run ([&] {
+        sharedStatusRegion_ = regionName;
+
+        if (statusCache_ != nullptr)
+        {
+            const auto& databaseFile = activationsDatabase_.getOptions().databaseFile;
+            statusCache_ = std::make_unique<SharedStatusCache> (databaseFile, sharedStatusRegion_);
+        }
+    });
+}
+
+const indiekey::Clock& indiekey::ActivationClient::getClock() const
+{
+    return *clock_.load();
+}
+
+namespace
+{
+
+/**
+ * The device info which was last sent by this process, shared by all clients. Keyed by server address, product and
+ * machine, because the server attaches the device info to the activations of a product.
+ */
+struct SentDeviceInfo
+{
+    std::mutex mutex;
+    std::map<std::string, std::string> perProduct;
+};
+
+SentDeviceInfo& getSentDeviceInfo()
+{
+    static SentDeviceInfo sentDeviceInfo;
+    return sentDeviceInfo;
+}
+
+} // namespace
+
+std::optional<std::string> indiekey::ActivationClient::getDeviceInfoToSend() const
+{
+    if (!deviceInfo_.has_value())
+        return std::nullopt;
+
+    auto& sent = getSentDeviceInfo();
+    std::lock_guard lock (sent.mutex);
+
+    auto it = sent.perProduct.find (getSentDeviceInfoKey());
+    if (it != sent.perProduct.end() && it->second == *deviceInfo_)
+        return std::nullopt;
+
+    return deviceInfo_;
+}
+
+void indiekey::ActivationClient::setDeviceInfoSent (const std::optional<std::string>& deviceInfo) const
+{
+    if (!deviceInfo.has_value())
+        return;
+
+    auto& sent = getSentDeviceInfo();
+    std::lock_guard lock (sent.mutex);
+    sent.perProduct[getSentDeviceInfoKey()] = *deviceInfo;
+}
+
+std::string indiekey::ActivationClient::getSentDeviceInfoKey() const
+{
+    return productData_->primaryPublicServerAddress + '\n' + productData_->productUid + '\n' +
+           getUniqueMachineIdAsBase64();
+}
+
 void indiekey::ActivationClient::setDeviceInfo (std::optional<std::string>&& deviceInfo)
 {
-    deviceInfo_ = deviceInfo;
+    workQueue_.run ([&] {
+        deviceInfo_ = std::move (deviceInfo);
+    });
 }
 
 const indiekey::Activation* indiekey::ActivationClient::getCurrentLoadedActivation() const
 {
-    return mostValuableActivation_.get();
+    std::lock_guard lock (currentLoadedActivationMutex_);
+    currentLoadedActivation_ = getLoadedActivation();
+    return currentLoadedActivation_.get();
+}
+
+std::shared_ptr<const indiekey::Activation> indiekey::ActivationClient::getLoadedActivation() const
+{
+    return std::atomic_load (&mostValuableActivation_);
 }
 
 indiekey::Activation::Status indiekey::ActivationClient::getActivationStatus() const
 {
-    if (mostValuableActivation_ == nullptr)
+    auto loadedActivation = getLoadedActivation();
+
+    if (loadedActivation == nullptr)
         return indiekey::Activation::Status::NoActivationLoaded;
-    return mostValuableActivation_->getStatus();
+    return loadedActivation->getStatus();
+}
+
+indiekey::ActivationClient::MemoryFootprint indiekey::ActivationClient::getMemoryFootprint()
+{
+    MemoryFootprint footprint;
+
+    workQueue_.run ([&] {
+        footprint.database = activationsDatabase_.getStoreMemoryUsage();
+        footprint.queryCache = activationsDatabase_.getCacheMemoryUsage();
+        footprint.restClient = restClient_ != nullptr ? restClient_->getMemoryUsage() : 0;
+        footprint.productData = productData_ != nullptr ? productData_->getMemoryUsage() : 0;
+    });
+
+    if (auto loadedActivation = getLoadedActivation())
+        footprint.loadedActivation = loadedActivation->getMemoryUsage();
+
+    return footprint;
+}
+
+juce::int64 indiekey::ActivationClient::getNumThrottledRequests() const
+{
+    return numThrottledRequests_;
 }
 
 juce::File indiekey::ActivationClient::getLocalActivationsDatabaseFile() const
+{
+    auto productData = std::atomic_load (&productData_);
+
+    if (productData == nullptr)
+        throw std::runtime_error ("Product data not set");
+
+    return getLocalActivationsDatabaseFile (*productData);
+}
+
+juce::File indiekey::ActivationClient::getLocalActivationsDatabaseFile (const ProductData& productData)
 {
     return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
 #ifdef JUCE_MAC
         .getChildFile ("Application Support")
 #endif
-        .getChildFile (productData_->organisationName)
+        .getChildFile (productData.organisationName)
         .getChildFile ("activations.db");
 }
 
@@ -373,11 +1150,19 @@ void indiekey::ActivationClient::addListener (indiekey::ActivationClient::Subscr
     if (subscriber == nullptr)
         return;
 
-    subscriber->onActivationsUpdated (mostValuableActivation_.get());
     listeners_.add (subscriber);
+
+    const juce::ScopedLock lock (lock_);
+    newSubscribers_.push_back (subscriber);
+    triggerAsyncUpdate();
 }
 
 void indiekey::ActivationClient::removeListener (indiekey::ActivationClient::Subscriber* subscriber)
 {
     listeners_.remove (subscriber);
+
+    const juce::ScopedLock lock (lock_);
+    newSubscribers_.erase (
+        std::remove (newSubscribers_.begin(), newSubscribers_.end(), subscriber),
+        newSubscribers_.end());
 }
@@ -0,0 +1,22 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/ActivationStore.h"
+
+void indiekey::ActivationStore::saveActivation (const Activation& activation, juce::Time now)
+{
+    saveActivations ({ activation }, now);
+}
+
+double indiekey::ActivationStore::getRefreshJitterFactor (const std::vector<uint8_t>& machineUid)
+{
+    // The machine uid is a hash, so its leading bytes are uniformly distributed.
+    uint64_t value = 0;
+    for (size_t i = 0; i < std::min<size_t> (machineUid.size(), 8); ++i)
+        value = (value << 8) | machineUid[i];
+
+    auto fraction = static_cast<double> (value >> 11) / static_cast<double> (uint64_t (1) << 53); // [0, 1)
+    return 1.0 - kMaxRefreshJitter * fraction;
+}
@@ -4,10 +4,26 @@
 //
 
 #include "indiekey/ActivationsDatabase.h"
+#include "indiekey/FileActivationStore.h"
+#include "indiekey/MemoryActivationStore.h"
+#include "indiekey/SqliteActivationStore.h"
+
+bool indiekey::ActivationsDatabase::MemoryBudget::operator== (const MemoryBudget& rhs) const
+{
+    return sqliteCacheSizeKiB == rhs.sqliteCacheSizeKiB && shareConnections == rhs.shareConnections &&
+           idleTimeout == rhs.idleTimeout;
+}
+
+bool indiekey::ActivationsDatabase::MemoryBudget::operator!= (const MemoryBudget& rhs) const
+{
+    return !(rhs == *this);
+}
 
 bool indiekey::ActivationsDatabase::Options::operator== (const ActivationsDatabase::Options& rhs) const
 {
-    return databaseFile == rhs.databaseFile;
+    // openInBackground is left out: it only determines how a database is opened, not which one.
+    return databaseFile == rhs.databaseFile && inMemory == rhs.inMemory && backend == rhs.backend &&
+           memoryBudget == rhs.memoryBudget;
 }
 
 bool indiekey::ActivationsDatabase::Options::operator!= (const ActivationsDatabase::Options& rhs) const
@@ -17,235 +33,374 @@ bool indiekey::ActivationsDatabase::Options::operator!= (const ActivationsDataba
 
 void indiekey::ActivationsDatabase::openDatabase (const ActivationsDatabase::Options& options)
 {
+    std::lock_guard lock (databaseMutex_);
+
     if (options_ == options)
         return;
 
     // Open new database if necessary
-    if (options_.databaseFile != options.databaseFile)
+    if (options_.databaseFile != options.databaseFile || options_.inMemory != options.inMemory ||
+        options_.backend != options.backend || options_.memoryBudget != options.memoryBudget)
     {
         // Make sure the path is legal
         jassert (
             options.databaseFile.getFullPathName() ==
             juce::File::createLegalPathName (options.databaseFile.getFullPathName()));
 
-        auto result = options.databaseFile.getParentDirectory().createDirectory();
-        if (result.failed())
-            throw std::runtime_error (result.getErrorMessage().toStdString());
+        if (pendingStore_.valid())
+            pendingStore_.wait(); // Discard the result (and any error) of opening the previous database.
 
-        database_.reset();
+        pendingStore_ = {};
+        store_.reset();
+        lastUsedAt_ = 0;
+        generation_++;
 
-        options_.databaseFile = options.databaseFile;
+        if (options.openInBackground)
+        {
+            pendingStore_ = std::async (std::launch::async, [options] {
+                return createOrShareStore (options);
+            });
+        }
+    }
+
+    options_ = options;
+    idleTimeoutMs_ = options.memoryBudget.idleTimeout.inMilliseconds();
+}
+
+void indiekey::ActivationsDatabase::setClock (const Clock& clock)
+{
+    clock_ = &clock;
+}
 
-        database_ = std::make_unique<SQLite::Database> (
-            options_.databaseFile.getFullPathName().toRawUTF8(),
-            SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE,
-            kBusyTimeoutMs);
+std::shared_ptr<indiekey::ActivationStore> indiekey::ActivationsDatabase::getStore()
+{
+    std::lock_guard lock (databaseMutex_);
 
-        migrate();
+    if (store_ == nullptr)
+    {
+        if (pendingStore_.valid())
+            store_ = pendingStore_.get(); // Rethrows any error which occurred on the background thread.
+        else if (options_.inMemory || options_.backend == Backend::Memory || options_.databaseFile != juce::File())
+            store_ = createOrShareStore (options_);
+        else
+            throw std::runtime_error ("Database not open");
     }
 
-    options_ = options;
+    lastUsedAt_ = clock_.load()->now().toMilliseconds();
+    return store_;
 }
 
-void indiekey::ActivationsDatabase::migrate()
+std::shared_ptr<indiekey::ActivationStore> indiekey::ActivationsDatabase::createStore (const Options& options)
 {
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
-
-    SQLite::Statement statement (
-        *database_,
-        R"(create table if not exists activations(
-            id                 integer primary key autoincrement,
-            hash               blob unique not null,
-            product_uid        text        not null,
-            machine_uid        blob        not null,
-            expires_at         integer,
-            license_expires_at integer,
-            last_updated_at    integer     not null,
-            license_type       text        not null,
-            signature          blob        not null);
-        )");
-
-    statement.exec();
-}
-
-void indiekey::ActivationsDatabase::saveActivation (const indiekey::Activation& activation)
-{
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
-
-    auto now = juce::Time::getCurrentTime();
-
-    SQLite::Statement statement (
-        *database_,
-        R"(INSERT OR REPLACE INTO activations(
-            hash, product_uid, machine_uid, expires_at, license_expires_at, last_updated_at, license_type, signature)
-            VALUES (?, ?, ?, ?, ?, ?, ?, ?);
-        )");
-
-    const auto& activationHash = activation.getHash();
-    statement.bind (1, activationHash.data(), static_cast<int> (activationHash.size()));
-    statement.bind (2, activation.getProductUid());
-    const auto& machineUid = activation.getMachineUid();
-    statement.bind (3, machineUid.data(), static_cast<int> (machineUid.size()));
-    activation.getExpiresAt().has_value() ? statement.bind (4, activation.getExpiresAt()->toMilliseconds())
-                                          : statement.bind (4, nullptr);
-    activation.getLicenseExpiresAt().has_value()
-        ? statement.bind (5, activation.getLicenseExpiresAt()->toMilliseconds())
-        : statement.bind (5, nullptr);
-    statement.bind (6, now.toMilliseconds());
-    statement.bind (7, License::typeToString (activation.getLicenseType()));
-    const auto& signature = activation.getSignature();
-    statement.bind (8, signature.data(), static_cast<int> (signature.size()));
-
-    statement.exec();
+    if (options.inMemory && options.backend == Backend::Sqlite)
+        return std::make_shared<SqliteActivationStore>();
+
+    if (options.inMemory || options.backend == Backend::Memory)
+        return std::make_shared<MemoryActivationStore>();
+
+    if (options.backend == Backend::File)
+        return std::make_shared<FileActivationStore> (options.databaseFile);
+
+    return std::make_shared<SqliteActivationStore> (options.databaseFile, options.memoryBudget.sqliteCacheSizeKiB);
 }
 
-void indiekey::ActivationsDatabase::deleteActivation (const indiekey::Activation::Hash& activationHash)
+std::shared_ptr<indiekey::ActivationStore> indiekey::ActivationsDatabase::createOrShareStore (const Options& options)
 {
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
+    // Stores which only live in memory can't be shared, as each instance expects its own.
+    if (!options.memoryBudget.shareConnections || options.inMemory || options.backend == Backend::Memory)
+        return createStore (options);
 
-    SQLite::Statement statement (*database_, "DELETE FROM activations WHERE hash = ?");
-    statement.bind (1, activationHash.data(), static_cast<int> (activationHash.size()));
-    statement.exec();
+    static std::mutex mutex;
+    static std::map<std::pair<juce::String, Backend>, std::weak_ptr<ActivationStore>> stores;
+
+    std::lock_guard lock (mutex);
+
+    auto& sharedStore = stores[{ options.databaseFile.getFullPathName(), options.backend }];
+
+    if (auto store = sharedStore.lock())
+        return store;
+
+    auto store = createStore (options);
+    sharedStore = store;
+    return store;
 }
 
-static std::vector<uint8_t> toBlobVector (const SQLite::Column& column)
+size_t indiekey::ActivationsDatabase::getStoreMemoryUsage()
 {
-    if (!column.isBlob())
-        return {};
-    auto size = column.getBytes();
-    auto data = static_cast<const uint8_t*> (column.getBlob());
-    return { data, data + size };
+    std::shared_ptr<ActivationStore> store;
+
+    {
+        std::lock_guard lock (databaseMutex_);
+        store = store_;
+    }
+
+    if (store == nullptr)
+        return 0;
+
+    // Subtract the local copy. The registry of shared stores only holds weak references.
+    auto numSharers = static_cast<size_t> (std::max<long> (1, store.use_count() - 1));
+    return store->getMemoryUsage() / numSharers;
 }
 
-[[maybe_unused]] static juce::Time toTime (const SQLite::Column& column)
+size_t indiekey::ActivationsDatabase::getCacheMemoryUsage()
 {
-    return juce::Time (column);
+    std::lock_guard lock (cacheMutex_);
+
+    size_t usage = 0;
+
+    for (const auto& [key, entry] : cache_)
+    {
+        usage += sizeof (key) + sizeof (entry) + key.first.capacity() + key.second.capacity();
+
+        for (const auto* activations : { &entry.activations, &entry.trialActivations })
+        {
+            if (!activations->has_value())
+                continue;
+
+            for (const auto& activation : **activations)
+                usage += activation.getMemoryUsage();
+        }
+
+        if (entry.mostValuableActivation.has_value() && entry.mostValuableActivation->activation.has_value())
+            usage += entry.mostValuableActivation->activation->getMemoryUsage();
+    }
+
+    return usage;
 }
 
-static std::optional<juce::Time> toOptionalTime (const SQLite::Column& column)
+juce::int64 indiekey::ActivationsDatabase::getNumCacheMisses() const
 {
-    return column.isNull() ? std::optional<juce::Time> {} : std::optional<juce::Time> { column };
+    return numCacheMisses_;
 }
 
-namespace
+std::optional<juce::RelativeTime> indiekey::ActivationsDatabase::getTimeUntilIdle() const
 {
+    auto lastUsedAt = lastUsedAt_.load();
+    auto idleTimeoutMs = idleTimeoutMs_.load();
 
-indiekey::Activation getActivationFromQuery (SQLite::Statement& query)
+    if (lastUsedAt == 0 || idleTimeoutMs <= 0)
+        return std::nullopt;
+
+    return juce::RelativeTime::milliseconds (lastUsedAt + idleTimeoutMs - clock_.load()->now().toMilliseconds());
+}
+
+bool indiekey::ActivationsDatabase::releaseIfIdle()
 {
-    return { toBlobVector (query.getColumn ("hash")),
-             query.getColumn ("product_uid").getString(),
-             toBlobVector (query.getColumn ("machine_uid")),
-             toOptionalTime (query.getColumn ("expires_at")),
-             toOptionalTime (query.getColumn ("license_expires_at")),
-             indiekey::License::typeFromString (query.getColumn ("license_type")),
-             toBlobVector (query.getColumn ("signature")) };
+    {
+        std::lock_guard lock (databaseMutex_);
+
+        auto timeUntilIdle = getTimeUntilIdle();
+        if (!timeUntilIdle.has_value() || timeUntilIdle->inMilliseconds() > 0 || pendingStore_.valid())
+            return false;
+
+        store_.reset(); // Closes the connections, unless another instance still shares them.
+        lastUsedAt_ = 0;
+        generation_++;  // A reopened store starts counting data versions anew.
+    }
+
+    std::lock_guard lock (cacheMutex_);
+    cache_.clear();
+    return true;
 }
-} // namespace
 
-std::vector<indiekey::Activation> indiekey::ActivationsDatabase::getActivations (
+indiekey::ActivationsDatabase::CacheEntry& indiekey::ActivationsDatabase::getCacheEntry (
+    ActivationStore& store,
     const std::string& productUid,
     const std::vector<uint8_t>& machineUid)
 {
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
+    // Both are read before the results are, so that a modification which happens in between causes a reload next time.
+    auto generation = generation_.load();
+    auto dataVersion = store.getDataVersion();
+
+    auto& entry = cache_[{ productUid, machineUid }];
+
+    if (entry.generation != generation || entry.dataVersion != dataVersion)
+    {
+        entry = CacheEntry {};
+        entry.generation = generation;
+        entry.dataVersion = dataVersion;
+    }
+
+    return entry;
+}
+
+template <typename Result, typename Query>
+Result indiekey::ActivationsDatabase::readThroughCache (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    std::optional<Result> CacheEntry::*result,
+    Query&& query)
+{
+    auto store = getStore();
 
-    SQLite::Statement query (
-        *database_,
-        R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature
-             FROM activations
-            WHERE product_uid = ? AND machine_uid = ?
-        )");
+    std::lock_guard lock (cacheMutex_);
+    auto& cached = getCacheEntry (*store, productUid, machineUid).*result;
 
-    query.bind (1, productUid);
-    query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
+    if (!cached.has_value())
+    {
+        cached = query (*store);
+        numCacheMisses_++;
+    }
 
-    std::vector<Activation> activations;
+    return *cached;
+}
 
-    while (query.executeStep())
-        activations.emplace_back (getActivationFromQuery (query));
+void indiekey::ActivationsDatabase::migrate()
+{
+    (void)getStore(); // Stores migrate when they are opened.
+}
 
-    return activations;
+void indiekey::ActivationsDatabase::saveActivation (const indiekey::Activation& activation, juce::Time now)
+{
+    getStore()->saveActivation (activation, now);
+    generation_++;
 }
 
-std::vector<indiekey::Activation> indiekey::ActivationsDatabase::getTrialActivations (
+void indiekey::ActivationsDatabase::saveActivations (const std::vector<Activation>& activations, juce::Time now)
+{
+    getStore()->saveActivations (activations, now);
+    generation_++;
+}
+
+void indiekey::ActivationsDatabase::deleteActivation (const indiekey::Activation::Hash& activationHash)
+{
+    getStore()->deleteActivation (activationHash);
+    generation_++;
+}
+
+std::vector<indiekey::Activation> indiekey::ActivationsDatabase::getActivations (
     const std::string& productUid,
     const std::vector<uint8_t>& machineUid)
 {
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
+    return readThroughCache (productUid, machineUid, &CacheEntry::activations, [&] (ActivationStore& store) {
+        return store.getActivations (productUid, machineUid);
+    });
+}
+
+std::optional<indiekey::Activation> indiekey::ActivationsDatabase::getMostValuableActivation (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    juce::Time now)
+{
+    auto store = getStore();
 
-    SQLite::Statement query (
-        *database_,
-        R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature
-             FROM activations
-            WHERE product_uid = ? AND machine_uid = ? AND license_type = ?
-        )");
+    std::lock_guard lock (cacheMutex_);
+    auto& cached = getCacheEntry (*store, productUid, machineUid).mostValuableActivation;
 
-    query.bind (1, productUid);
-    query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
-    query.bind (3, License::typeToString (License::Type::Trial));
+    // As time passes activations only expire. The most valuable activation stays ahead of the others until it expires
+    // itself, because expired activations rank last and the rest of the ranking doesn't depend on the time.
+    if (cached.has_value() && now >= cached->computedAt &&
+        (!cached->validUntil.has_value() || now <= *cached->validUntil))
+        return cached->activation;
 
-    std::vector<Activation> activations;
+    cached = CachedMostValuableActivation { store->getMostValuableActivation (productUid, machineUid, now), now, {} };
+    numCacheMisses_++;
 
-    while (query.executeStep())
-        activations.emplace_back (getActivationFromQuery (query));
+    auto isExpired = [now] (const std::optional<juce::Time>& expiry) {
+        return expiry.has_value() && *expiry < now;
+    };
 
-    return activations;
+    const auto& activation = cached->activation;
+
+    if (activation.has_value() && !isExpired (activation->getExpiresAt()) &&
+        !isExpired (activation->getLicenseExpiresAt()))
+    {
+        for (const auto& expiry : { activation->getExpiresAt(), activation->getLicenseExpiresAt() })
+        {
+            if (expiry.has_value() && (!cached->validUntil.has_value() || *expiry < *cached->validUntil))
+                cached->validUntil = *expiry;
+        }
+    }
+
+    return cached->activation;
 }
 
-int indiekey::ActivationsDatabase::deleteAllActivations (
+indiekey::ActivationsDatabase::TrialSummary indiekey::ActivationsDatabase::getTrialSummary (
     const std::string& productUid,
-    const std::vector<uint8_t>& machineUid)
+    const std::vector<uint8_t>& machineUid,
+    juce::Time now)
 {
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
+    // Not cached, as it changes whenever any trial expires. Answered by a single aggregate query.
+    return getStore()->getTrialSummary (productUid, machineUid, now);
+}
 
-    SQLite::Statement query (
-        *database_,
-        R"(DELETE FROM activations
-           WHERE product_uid = ? AND machine_uid = ?;
-        )");
+std::vector<indiekey::Activation> indiekey::ActivationsDatabase::getTrialActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return readThroughCache (productUid, machineUid, &CacheEntry::trialActivations, [&] (ActivationStore& store) {
+        return store.getTrialActivations (productUid, machineUid);
+    });
+}
 
-    query.bind (1, productUid);
-    query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
-    return query.exec();
+int indiekey::ActivationsDatabase::deleteAllActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    auto numDeleted = getStore()->deleteAllActivations (productUid, machineUid);
+    generation_++;
+    return numDeleted;
 }
 
 std::vector<indiekey::Activation> indiekey::ActivationsDatabase::getActivationsWhichNeedUpdate (
     const std::string& productUid,
     const std::vector<uint8_t>& machineUid,
-    bool getAllActivations)
+    bool getAllActivations,
+    juce::Time now)
 {
-    if (database_ == nullptr)
-        throw std::runtime_error ("Database not open");
+    // Not cached, as it changes whenever the time passes a refresh interval.
+    return getStore()->getActivationsWhichNeedUpdate (productUid, machineUid, getAllActivations, now);
+}
 
-    // TODO: Make this configurable as part of the activation returned by the server.
-    static constexpr int onlineCheckIntervalHours = 24;
-    auto now = juce::Time::getCurrentTime();
+std::optional<juce::Time> indiekey::ActivationsDatabase::getNextUpdateTime (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return readThroughCache (productUid, machineUid, &CacheEntry::nextUpdateTime, [&] (ActivationStore& store) {
+        return store.getNextUpdateTime (productUid, machineUid);
+    });
+}
 
-    SQLite::Statement query (
-        *database_,
-        R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature
-             FROM activations
-            WHERE product_uid = ? AND machine_uid = ? AND (expires_at < ? OR last_updated_at < ? OR ?)
-        )");
+std::optional<juce::int64> indiekey::ActivationsDatabase::getMetadata (const std::string& key)
+{
+    return getStore()->getMetadata (key);
+}
 
-    // Note: we don't have to test for license_expires_at because expires_at will (should) never outlast
-    // license_expires_at.
+void indiekey::ActivationsDatabase::setMetadata (const std::string& key, juce::int64 value)
+{
+    getStore()->setMetadata (key, value);
+}
+
+void indiekey::ActivationsDatabase::updateMetadata (
+    const std::vector<std::string>& keys,
+    const std::function<Metadata (const Metadata&)>& update)
+{
+    getStore()->updateMetadata (keys, update);
+}
+
+juce::int64 indiekey::ActivationsDatabase::getDataVersion()
+{
+    return getStore()->getDataVersion();
+}
 
-    query.bind (1, productUid);
-    query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
-    query.bind (3, (now + juce::RelativeTime::hours (onlineCheckIntervalHours)).toMilliseconds());
-    query.bind (4, (now - juce::RelativeTime::hours (onlineCheckIntervalHours)).toMilliseconds());
-    query.bind (5, getAllActivations);
+const indiekey::ActivationsDatabase::Options& indiekey::ActivationsDatabase::getOptions() const
+{
+    return options_;
+}
 
-    std::vector<Activation> activations;
+double indiekey::ActivationsDatabase::getRefreshJitterFactor (const std::vector<uint8_t>& machineUid)
+{
+    return ActivationStore::getRefreshJitterFactor (machineUid);
+}
+
+indiekey::ActivationsDatabase::MaintenanceReport
+indiekey::ActivationsDatabase::runMaintenance (juce::Time now, bool force)
+{
+    auto report = getStore()->runMaintenance (now, force);
 
-    while (query.executeStep())
-        activations.emplace_back (getActivationFromQuery (query));
+    // Maintenance is rate limited but called after every refresh, so the cache is only dropped when rows went away.
+    if (report.ran && report.numRowsPruned > 0)
+        generation_++;
 
-    return activations;
+    return report;
 }
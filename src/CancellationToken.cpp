@@ -0,0 +1,91 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/CancellationToken.h"
+
+#include <juce_core/juce_core.h>
+
+indiekey::CancellationToken::~CancellationToken()
+{
+    jassert (callbacks_.empty()); // Registrations must not outlive their token.
+}
+
+void indiekey::CancellationToken::cancel()
+{
+    std::lock_guard lock (mutex_);
+
+    if (cancelled_.exchange (true))
+        return;
+
+    // Called with the lock held, so that a callback never runs concurrently with (or after) its unregistration.
+    for (auto& [id, callback] : callbacks_)
+        callback();
+}
+
+bool indiekey::CancellationToken::isCancelled() const
+{
+    return cancelled_.load();
+}
+
+void indiekey::CancellationToken::throwIfCancelled() const
+{
+    if (isCancelled())
+        throw Cancelled();
+}
+
+indiekey::CancellationToken::Registration indiekey::CancellationToken::onCancel (std::function<void()> callback)
+{
+    std::lock_guard lock (mutex_);
+
+    if (cancelled_)
+    {
+        callback();
+        return {};
+    }
+
+    auto id = nextId_++;
+    callbacks_.emplace (id, std::move (callback));
+    return { this, id };
+}
+
+void indiekey::CancellationToken::unregister (size_t id)
+{
+    std::lock_guard lock (mutex_);
+    callbacks_.erase (id);
+}
+
+indiekey::CancellationToken::Registration::Registration (CancellationToken* token, size_t id) : token_ (token), id_ (id)
+{
+}
+
+indiekey::CancellationToken::Registration::~Registration()
+{
+    reset();
+}
+
+indiekey::CancellationToken::Registration::Registration (Registration&& other) noexcept :
+    token_ (std::exchange (other.token_, nullptr)),
+    id_ (other.id_)
+{
+}
+
+indiekey::CancellationToken::Registration&
+indiekey::CancellationToken::Registration::operator= (Registration&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        token_ = std::exchange (other.token_, nullptr);
+        id_ = other.id_;
+    }
+    return *this;
+}
+
+void indiekey::CancellationToken::Registration::reset()
+{
+    if (token_ != nullptr)
+        token_->unregister (id_);
+    token_ = nullptr;
+}
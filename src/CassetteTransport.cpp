@@ -0,0 +1,150 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/CassetteTransport.h"
+
+#include <algorithm>
+
+indiekey::CassetteTransport::CassetteTransport (
+    Mode mode,
+    juce::File cassetteFile,
+    std::shared_ptr<Transport> transport,
+    bool replayRecordedLatency) :
+    mode_ (mode),
+    cassetteFile_ (std::move (cassetteFile)),
+    transport_ (std::move (transport)),
+    replayRecordedLatency_ (replayRecordedLatency)
+{
+    if (mode_ == Mode::Record)
+    {
+        if (transport_ == nullptr)
+            throw std::runtime_error ("No transport to record from");
+        return;
+    }
+
+    try
+    {
+        interactions_ = nlohmann::json::parse (cassetteFile_.loadFileAsString().toStdString()).at ("interactions");
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        throw std::runtime_error ("Failed to read cassette " + cassetteFile_.getFullPathName().toStdString() + ": " +
+                                  e.what());
+    }
+
+    replayed_.resize (interactions_.size(), false);
+}
+
+indiekey::RestClient::Response indiekey::CassetteTransport::send (
+    const RestClient::Request& request,
+    CancellationToken* cancellationToken)
+{
+    auto method = getMethod (request);
+    // Query parameters (like the timestamp of a ping) differ between runs and are not part of the match.
+    auto path = request.url.getSubPath().upToFirstOccurrenceOf ("?", false, false);
+
+    if (mode_ == Mode::Record)
+    {
+        nlohmann::json interaction {
+            { "method", method.toStdString() },
+            { "path", path.toStdString() },
+            { "request_body", request.url.getPostData().toStdString() },
+        };
+
+        auto startedAt = juce::Time::getMillisecondCounterHiRes();
+        RestClient::Response response;
+
+        try
+        {
+            response = transport_->send (request, cancellationToken);
+        }
+        catch (const CancellationToken::Cancelled&)
+        {
+            throw; // Cancellation is a decision of the client, not something the server did.
+        }
+        catch (const std::exception& e)
+        {
+            interaction["error"] = e.what();
+            interaction["duration_ms"] = juce::Time::getMillisecondCounterHiRes() - startedAt;
+            record (std::move (interaction));
+            throw;
+        }
+
+        interaction["status_code"] = response.statusCode;
+        interaction["response_body"] = response.body.toStdString();
+        interaction["duration_ms"] = juce::Time::getMillisecondCounterHiRes() - startedAt;
+        record (std::move (interaction));
+        return response;
+    }
+
+    nlohmann::json interaction;
+
+    {
+        std::lock_guard lock (mutex_);
+
+        for (size_t i = 0; i < interactions_.size(); ++i)
+        {
+            if (!replayed_[i] && interactions_[i].at ("method") == method.toStdString() &&
+                interactions_[i].at ("path") == path.toStdString())
+            {
+                replayed_[i] = true;
+                interaction = interactions_[i];
+                break;
+            }
+        }
+    }
+
+    if (interaction.is_null())
+        throw std::runtime_error ("No recorded interaction for " + method.toStdString() + " " + path.toStdString());
+
+    if (replayRecordedLatency_)
+    {
+        auto until = juce::Time::getMillisecondCounterHiRes() + interaction.value ("duration_ms", 0.0);
+
+        while (juce::Time::getMillisecondCounterHiRes() < until)
+        {
+            if (cancellationToken != nullptr)
+                cancellationToken->throwIfCancelled();
+            juce::Thread::sleep (1);
+        }
+    }
+
+    if (cancellationToken != nullptr)
+        cancellationToken->throwIfCancelled();
+
+    if (auto error = interaction.find ("error"); error != interaction.end())
+        throw std::runtime_error (error->get<std::string>());
+
+    RestClient::Response response;
+    response.statusCode = interaction.at ("status_code").get<int>();
+    response.body = juce::String (interaction.at ("response_body").get<std::string>());
+    return response;
+}
+
+size_t indiekey::CassetteTransport::getNumRemainingInteractions() const
+{
+    std::lock_guard lock (mutex_);
+
+    if (mode_ == Mode::Record)
+        return interactions_.size();
+
+    return static_cast<size_t> (std::count (replayed_.begin(), replayed_.end(), false));
+}
+
+juce::String indiekey::CassetteTransport::getMethod (const RestClient::Request& request)
+{
+    return request.usePost ? "POST" : "GET";
+}
+
+void indiekey::CassetteTransport::record (nlohmann::json interaction)
+{
+    std::lock_guard lock (mutex_);
+    interactions_.push_back (std::move (interaction));
+
+    // Written after every interaction, so that the cassette is complete even when the process crashes.
+    nlohmann::json cassette { { "interactions", interactions_ } };
+    if (!cassetteFile_.replaceWithText (cassette.dump (2)))
+        throw std::runtime_error ("Failed to write cassette " + cassetteFile_.getFullPathName().toStdString());
+}
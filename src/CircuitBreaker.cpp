@@ -0,0 +1,239 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/CircuitBreaker.h"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr auto kNextProbeAtKey = "circuit_next_probe_at ";
+constexpr auto kNumProbesKey = "circuit_num_probes ";
+
+} // namespace
+
+bool indiekey::CircuitBreaker::Policy::operator== (const Policy& rhs) const
+{
+    return failureThreshold == rhs.failureThreshold && initialProbeInterval == rhs.initialProbeInterval &&
+           maxProbeInterval == rhs.maxProbeInterval;
+}
+
+bool indiekey::CircuitBreaker::Policy::operator!= (const Policy& rhs) const
+{
+    return !(rhs == *this);
+}
+
+void indiekey::CircuitBreaker::setPolicy (const Policy& policy)
+{
+    if (policy.failureThreshold < 1 || policy.initialProbeInterval.inMilliseconds() <= 0 ||
+        policy.maxProbeInterval < policy.initialProbeInterval)
+        throw std::runtime_error ("Circuit breaker policy is invalid");
+
+    std::lock_guard lock (mutex_);
+    policy_ = policy;
+}
+
+indiekey::CircuitBreaker::Policy indiekey::CircuitBreaker::getPolicy() const
+{
+    std::lock_guard lock (mutex_);
+    return policy_;
+}
+
+bool indiekey::CircuitBreaker::allowRequest (ActivationsDatabase& database, const std::string& serverAddress)
+{
+    synchronise (database, serverAddress);
+
+    std::lock_guard lock (mutex_);
+
+    // Also while a probe is due: only the probe may find out whether the server is back, in the background.
+    if (circuits_[serverAddress].nextProbeAt == 0)
+        return true;
+
+    counters_.numShortCircuited++;
+    return false;
+}
+
+bool indiekey::CircuitBreaker::tryStartProbe (
+    ActivationsDatabase& database,
+    const std::string& serverAddress,
+    juce::Time now)
+{
+    synchronise (database, serverAddress);
+
+    {
+        std::lock_guard lock (mutex_);
+        auto& circuit = circuits_[serverAddress];
+
+        if (circuit.nextProbeAt == 0 || now.toMilliseconds() < circuit.nextProbeAt)
+            return false;
+
+        // Scheduled as if the probe fails, recordSuccess closes the circuit if it doesn't.
+        circuit.numProbes++;
+        circuit.nextProbeAt = (now + getProbeInterval (circuit.numProbes)).toMilliseconds();
+        circuit.numUnsavedChanges++;
+        counters_.numProbes++;
+    }
+
+    save (database, serverAddress);
+    return true;
+}
+
+void indiekey::CircuitBreaker::recordSuccess (ActivationsDatabase& database, const std::string& serverAddress)
+{
+    synchronise (database, serverAddress);
+
+    {
+        std::lock_guard lock (mutex_);
+        auto& circuit = circuits_[serverAddress];
+
+        auto wasOpen = circuit.nextProbeAt != 0;
+        circuit.numFailures = 0;
+        circuit.numProbes = 0;
+        circuit.nextProbeAt = 0;
+
+        if (!wasOpen)
+            return;
+
+        circuit.numUnsavedChanges++;
+    }
+
+    save (database, serverAddress);
+}
+
+void indiekey::CircuitBreaker::recordFailure (
+    ActivationsDatabase& database,
+    const std::string& serverAddress,
+    juce::Time now)
+{
+    synchronise (database, serverAddress);
+
+    {
+        std::lock_guard lock (mutex_);
+        auto& circuit = circuits_[serverAddress];
+
+        // A failed probe was already accounted for by tryStartProbe.
+        if (circuit.nextProbeAt != 0)
+            return;
+
+        if (++circuit.numFailures < policy_.failureThreshold)
+            return;
+
+        circuit.numProbes = 0;
+        circuit.nextProbeAt = (now + getProbeInterval (0)).toMilliseconds();
+        circuit.numUnsavedChanges++;
+        counters_.numOpened++;
+    }
+
+    save (database, serverAddress);
+}
+
+indiekey::CircuitBreaker::State indiekey::CircuitBreaker::getState (
+    const std::string& serverAddress,
+    juce::Time now) const
+{
+    auto nextProbeTime = getNextProbeTime (serverAddress);
+
+    if (!nextProbeTime.has_value())
+        return State::Closed;
+
+    return now < *nextProbeTime ? State::Open : State::HalfOpen;
+}
+
+std::optional<juce::Time> indiekey::CircuitBreaker::getNextProbeTime (const std::string& serverAddress) const
+{
+    std::lock_guard lock (mutex_);
+
+    auto it = circuits_.find (serverAddress);
+    if (it == circuits_.end() || it->second.nextProbeAt == 0)
+        return std::nullopt;
+
+    return juce::Time (it->second.nextProbeAt);
+}
+
+indiekey::CircuitBreaker::Counters indiekey::CircuitBreaker::getCounters() const
+{
+    std::lock_guard lock (mutex_);
+    return counters_;
+}
+
+void indiekey::CircuitBreaker::synchronise (ActivationsDatabase& database, const std::string& serverAddress)
+{
+    std::optional<juce::int64> dataVersion;
+
+    try
+    {
+        dataVersion = database.getDataVersion();
+
+        {
+            std::lock_guard lock (mutex_);
+            if (circuits_[serverAddress].dataVersion == dataVersion)
+                return; // Nothing changed since the state was read.
+        }
+
+        // Read in a transaction, so that the values belong together. The mutex is only taken to apply them.
+        auto keys = std::vector<std::string> { kNextProbeAtKey + serverAddress, kNumProbesKey + serverAddress };
+
+        database.updateMetadata (keys, [&] (const ActivationsDatabase::Metadata& stored) {
+            std::lock_guard lock (mutex_);
+            auto& circuit = circuits_[serverAddress];
+
+            // A change which is still being saved is newer than what's stored. It changes the version again, so the
+            // state is read once more after that.
+            if (circuit.numUnsavedChanges > 0)
+                return ActivationsDatabase::Metadata {};
+
+            auto nextProbeAt = stored.find (keys[0]);
+            auto numProbes = stored.find (keys[1]);
+            circuit.nextProbeAt = nextProbeAt != stored.end() ? nextProbeAt->second : 0;
+            circuit.numProbes = numProbes != stored.end() ? static_cast<int> (numProbes->second) : 0;
+            circuit.dataVersion = dataVersion;
+
+            return ActivationsDatabase::Metadata {};
+        });
+    }
+    catch (const std::exception& e)
+    {
+        juce::ignoreUnused (e);
+        DBG ("Failed to load circuit breaker state: " << e.what());
+    }
+}
+
+juce::RelativeTime indiekey::CircuitBreaker::getProbeInterval (int numProbes) const
+{
+    auto intervalMs = policy_.initialProbeInterval.inMilliseconds();
+    auto maxIntervalMs = policy_.maxProbeInterval.inMilliseconds();
+
+    for (int i = 0; i < numProbes && intervalMs < maxIntervalMs; ++i)
+        intervalMs *= 2;
+
+    return juce::RelativeTime::milliseconds (std::min (intervalMs, maxIntervalMs));
+}
+
+void indiekey::CircuitBreaker::save (ActivationsDatabase& database, const std::string& serverAddress)
+{
+    try
+    {
+        // Both values in one transaction, so that other processes never read half of the state. Whatever the circuit
+        // is by the time the transaction runs is saved, so that concurrent saves can't store an older state last.
+        database.updateMetadata ({}, [&] (const ActivationsDatabase::Metadata&) {
+            std::lock_guard lock (mutex_);
+            const auto& circuit = circuits_[serverAddress];
+
+            return ActivationsDatabase::Metadata {
+                { kNextProbeAtKey + serverAddress, circuit.nextProbeAt },
+                { kNumProbesKey + serverAddress, circuit.numProbes },
+            };
+        });
+    }
+    catch (const std::exception& e)
+    {
+        juce::ignoreUnused (e);
+        DBG ("Failed to persist circuit breaker state: " << e.what());
+    }
+
+    std::lock_guard lock (mutex_);
+    circuits_[serverAddress].numUnsavedChanges--;
+}
@@ -0,0 +1,43 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/Clock.h"
+
+namespace
+{
+
+class SystemClock : public indiekey::Clock
+{
+public:
+    [[nodiscard]] juce::Time now() const override
+    {
+        return juce::Time::getCurrentTime();
+    }
+};
+
+} // namespace
+
+const indiekey::Clock& indiekey::Clock::getSystemClock()
+{
+    static const SystemClock systemClock;
+    return systemClock;
+}
+
+indiekey::ManualClock::ManualClock (juce::Time startTime) : milliseconds_ (startTime.toMilliseconds()) {}
+
+juce::Time indiekey::ManualClock::now() const
+{
+    return juce::Time (milliseconds_.load());
+}
+
+void indiekey::ManualClock::setTime (juce::Time time)
+{
+    milliseconds_ = time.toMilliseconds();
+}
+
+void indiekey::ManualClock::advance (juce::RelativeTime amount)
+{
+    milliseconds_ += amount.inMilliseconds();
+}
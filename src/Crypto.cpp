@@ -6,27 +6,101 @@
 #include <sodium/core.h>
 #include <sodium/crypto_box.h>
 #include <sodium/crypto_generichash.h>
+#include <sodium/randombytes.h>
+#include <mutex>
 #include <stdexcept>
 
-std::vector<uint8_t> indiekey::crypto::genericHash (const std::vector<uint8_t>& data)
+static_assert (indiekey::crypto::kGenericHashBytes == crypto_generichash_BYTES);
+static_assert (indiekey::crypto::kKeyedHashKeyBytes == crypto_generichash_KEYBYTES);
+static_assert (indiekey::crypto::kBoxPublicKeyBytes == crypto_box_PUBLICKEYBYTES);
+static_assert (indiekey::crypto::kBoxSealOverheadBytes == crypto_box_SEALBYTES);
+
+void indiekey::crypto::init()
 {
-    unsigned char hash[crypto_generichash_BYTES];
+    // When initialisation throws, the flag is not set and the next call tries again.
+    static std::once_flag initialised;
 
-    if (crypto_generichash (hash, sizeof hash, data.data(), data.size(), nullptr, 0) != 0)
+    std::call_once (initialised, [] {
+        if (sodium_init() == -1)
+            throw std::runtime_error ("Failed to initialise libsodium");
+    });
+}
+
+void indiekey::crypto::genericHash (const uint8_t* data, size_t dataLength, uint8_t* hash)
+{
+    if (crypto_generichash (hash, kGenericHashBytes, data, dataLength, nullptr, 0) != 0)
         throw std::runtime_error ("Failed to generate hash");
+}
 
-    return { hash, hash + sizeof hash };
+void indiekey::crypto::keyedHash (const uint8_t* data, size_t dataLength, const uint8_t* key, uint8_t* hash)
+{
+    if (crypto_generichash (hash, kGenericHashBytes, data, dataLength, key, kKeyedHashKeyBytes) != 0)
+        throw std::runtime_error ("Failed to generate hash");
+}
+
+void indiekey::crypto::randomBytes (uint8_t* buffer, size_t size)
+{
+    randombytes_buf (buffer, size);
+}
+
+std::vector<uint8_t> indiekey::crypto::genericHash (const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> hash (kGenericHashBytes);
+    genericHash (data.data(), data.size(), hash.data());
+    return hash;
 }
 
 std::vector<uint8_t> indiekey::crypto::genericHash (const std::string& text)
 {
-    return genericHash (std::vector<uint8_t> (text.begin(), text.end()));
+    std::vector<uint8_t> hash (kGenericHashBytes);
+    genericHash (reinterpret_cast<const uint8_t*> (text.data()), text.size(), hash.data());
+    return hash;
 }
 
-void indiekey::crypto::init()
+static crypto_generichash_state* toGenericHashState (unsigned char* storage)
+{
+    return reinterpret_cast<crypto_generichash_state*> (storage);
+}
+
+indiekey::crypto::GenericHash::GenericHash()
+{
+    static_assert (sizeof (state_) >= sizeof (crypto_generichash_state));
+    static_assert (alignof (crypto_generichash_state) <= 64);
+
+    if (crypto_generichash_init (toGenericHashState (state_), nullptr, 0, kGenericHashBytes) != 0)
+        throw std::runtime_error ("Failed to initialise hash");
+}
+
+void indiekey::crypto::GenericHash::update (const uint8_t* data, size_t dataLength)
+{
+    if (crypto_generichash_update (toGenericHashState (state_), data, dataLength) != 0)
+        throw std::runtime_error ("Failed to update hash");
+}
+
+void indiekey::crypto::GenericHash::update (const std::string& text)
 {
-    if (sodium_init() == -1)
-        throw std::runtime_error ("Failed to initialise libsodium");
+    update (reinterpret_cast<const uint8_t*> (text.data()), text.size());
+}
+
+void indiekey::crypto::GenericHash::finish (uint8_t* hash)
+{
+    if (crypto_generichash_final (toGenericHashState (state_), hash, kGenericHashBytes) != 0)
+        throw std::runtime_error ("Failed to generate hash");
+}
+
+std::vector<uint8_t> indiekey::crypto::GenericHash::finish()
+{
+    std::vector<uint8_t> hash (kGenericHashBytes);
+    finish (hash.data());
+    return hash;
+}
+
+size_t indiekey::crypto::boxSeal (const uint8_t* data, size_t dataLength, const uint8_t* key, uint8_t* cipherText)
+{
+    if (crypto_box_seal (cipherText, data, dataLength, key) != 0)
+        throw std::runtime_error ("Failed to encrypt data");
+
+    return dataLength + kBoxSealOverheadBytes;
 }
 
 std::vector<uint8_t> indiekey::crypto::boxSeal (const std::vector<uint8_t>& data, const std::vector<uint8_t>& key)
@@ -44,14 +118,10 @@ std::vector<uint8_t> indiekey::crypto::boxSeal (
     size_t dataLength,
     const std::vector<uint8_t>& key)
 {
-    if (key.size() != crypto_box_PUBLICKEYBYTES)
+    if (key.size() != kBoxPublicKeyBytes)
         throw std::runtime_error ("Invalid key length");
 
-    auto cipherTextLength = dataLength + crypto_box_SEALBYTES;
-    std::vector<uint8_t> cipherText (cipherTextLength);
-
-    if (crypto_box_seal (cipherText.data(), data, dataLength, key.data()) != 0)
-        throw std::runtime_error ("Failed to encrypt data");
-
+    std::vector<uint8_t> cipherText (dataLength + kBoxSealOverheadBytes);
+    boxSeal (data, dataLength, key.data(), cipherText.data());
     return cipherText;
 }
@@ -0,0 +1,109 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/FaultInjectingTransport.h"
+
+#include <optional>
+
+indiekey::FaultInjectingTransport::FaultInjectingTransport (std::shared_ptr<Transport> transport, Faults faults) :
+    transport_ (std::move (transport)),
+    faults_ (faults),
+    random_ (faults.seed)
+{
+    if (transport_ == nullptr)
+        throw std::runtime_error ("No transport to inject faults into");
+}
+
+indiekey::RestClient::Response indiekey::FaultInjectingTransport::send (
+    const RestClient::Request& request,
+    CancellationToken* cancellationToken)
+{
+    std::optional<juce::RelativeTime> latency;
+    bool refuse = false;
+    bool serverError = false;
+    double truncateAt = -1.0; // Fraction of the body to keep, negative to keep all of it.
+
+    {
+        std::lock_guard lock (mutex_);
+
+        // Every request draws the same number of values, so that the faults only depend on the seed and the number of
+        // requests which came before, not on which faults were injected.
+        auto delayDraw = random_.nextDouble();
+        auto delayFraction = random_.nextDouble();
+        auto refuseDraw = random_.nextDouble();
+        auto truncateDraw = random_.nextDouble();
+        auto truncateFraction = random_.nextDouble();
+        auto serverErrorDraw = random_.nextDouble();
+
+        counters_.numRequests++;
+
+        if (delayDraw < faults_.latencyProbability)
+        {
+            auto minMs = faults_.minLatency.inMilliseconds();
+            latency = juce::RelativeTime::milliseconds (
+                minMs + static_cast<juce::int64> ((faults_.maxLatency.inMilliseconds() - minMs) * delayFraction));
+            counters_.numDelayed++;
+        }
+
+        if (refuseDraw < faults_.refusalProbability)
+        {
+            refuse = true;
+            counters_.numRefused++;
+        }
+        else if (serverErrorDraw < faults_.serverErrorProbability)
+        {
+            serverError = true;
+            counters_.numServerErrors++;
+        }
+        else if (truncateDraw < faults_.truncationProbability)
+        {
+            truncateAt = truncateFraction;
+            counters_.numTruncated++;
+        }
+    }
+
+    if (latency.has_value())
+    {
+        auto until = juce::Time::getMillisecondCounterHiRes() + latency->inMilliseconds();
+
+        while (juce::Time::getMillisecondCounterHiRes() < until)
+        {
+            if (cancellationToken != nullptr)
+                cancellationToken->throwIfCancelled();
+            juce::Thread::sleep (1);
+        }
+    }
+
+    if (cancellationToken != nullptr)
+        cancellationToken->throwIfCancelled();
+
+    // The same error as WebTransport throws when it can't connect.
+    if (refuse)
+        throw std::runtime_error ("Failed to reach activation server");
+
+    if (serverError)
+    {
+        RestClient::Response response;
+        response.statusCode = 503;
+        response.body = R"({"error":"Service unavailable"})";
+        return response;
+    }
+
+    auto response = transport_->send (request, cancellationToken);
+
+    if (truncateAt >= 0.0)
+    {
+        auto numBytes = static_cast<int> (response.body.getNumBytesAsUTF8() * truncateAt);
+        response.body = juce::String::fromUTF8 (response.body.toRawUTF8(), numBytes);
+    }
+
+    return response;
+}
+
+indiekey::FaultInjectingTransport::Counters indiekey::FaultInjectingTransport::getCounters() const
+{
+    std::lock_guard lock (mutex_);
+    return counters_;
+}
@@ -0,0 +1,325 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/FileActivationStore.h"
+#include "indiekey/Encoding.h"
+
+#include <array>
+#include <cstring>
+
+// Every line of the file is a record: the CRC-32 of the json (8 hex digits), a space, the json and a newline. The first
+// record is a header which identifies the file, all others are changes.
+
+namespace
+{
+
+constexpr int kMaxHeaderSize = 256;
+
+uint32_t computeChecksum (const char* data, size_t size)
+{
+    static const auto table = [] {
+        std::array<uint32_t, 256> t {};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            auto c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) != 0 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ static_cast<uint8_t> (data[i])) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffff;
+}
+
+std::string encodeRecord (const nlohmann::json& json)
+{
+    auto text = json.dump();
+    char checksum[9];
+    std::snprintf (checksum, sizeof (checksum), "%08x", computeChecksum (text.data(), text.size()));
+    return std::string (checksum) + " " + text + "\n";
+}
+
+/**
+ * Decodes the record at the start of given data.
+ * @returns The json of the record and the size of the record including the newline, or nullopt if the data doesn't
+ * start with a complete and valid record.
+ */
+std::optional<std::pair<nlohmann::json, size_t>> decodeRecord (const char* data, size_t size)
+{
+    auto end = static_cast<const char*> (std::memchr (data, '\n', size));
+    if (end == nullptr || end - data < 10 || data[8] != ' ')
+        return std::nullopt;
+
+    auto text = data + 9;
+    auto textSize = static_cast<size_t> (end - text);
+
+    if (std::strtoul (std::string (data, 8).c_str(), nullptr, 16) != computeChecksum (text, textSize))
+        return std::nullopt;
+
+    auto json = nlohmann::json::parse (text, end, nullptr, false);
+    if (json.is_discarded())
+        return std::nullopt;
+
+    return std::make_pair (std::move (json), static_cast<size_t> (end - data) + 1);
+}
+
+} // namespace
+
+nlohmann::json indiekey::FileActivationStore::changeToJson (const Change& change)
+{
+    using Type = Change::Type;
+
+    switch (change.type)
+    {
+    case Type::Save:
+        return { { "op", "save" }, { "time", change.time }, { "activations", change.activations } };
+    case Type::Delete:
+        return { { "op", "delete" }, { "hash", encodeToBase64 (change.hash) } };
+    case Type::DeleteAll:
+        return { { "op", "delete_all" },
+                 { "product_uid", change.productUid },
+                 { "machine_uid", encodeToBase64 (change.machineUid) } };
+    case Type::Prune:
+        return { { "op", "prune" }, { "time", change.time } };
+    case Type::SetMetadata:
+        return { { "op", "set" }, { "metadata", change.metadata } };
+    }
+
+    throw std::runtime_error ("Unknown change type");
+}
+
+indiekey::MemoryActivationStore::Change indiekey::FileActivationStore::changeFromJson (const nlohmann::json& json)
+{
+    using Type = Change::Type;
+
+    Change change;
+    auto op = json.at ("op").get<std::string>();
+
+    if (op == "save")
+    {
+        change.type = Type::Save;
+        change.time = json.at ("time").get<juce::int64>();
+        change.activations = json.at ("activations").get<std::vector<Activation>>();
+    }
+    else if (op == "delete")
+    {
+        change.type = Type::Delete;
+        change.hash = decodeFromBase64 (json.at ("hash").get<std::string>());
+    }
+    else if (op == "delete_all")
+    {
+        change.type = Type::DeleteAll;
+        change.productUid = json.at ("product_uid").get<std::string>();
+        change.machineUid = decodeFromBase64 (json.at ("machine_uid").get<std::string>());
+    }
+    else if (op == "prune")
+    {
+        change.type = Type::Prune;
+        change.time = json.at ("time").get<juce::int64>();
+    }
+    else if (op == "set")
+    {
+        change.type = Type::SetMetadata;
+        change.metadata = json.at ("metadata").get<Metadata>();
+    }
+    else
+    {
+        throw std::runtime_error ("Unknown change in activations file: " + op);
+    }
+
+    return change;
+}
+
+indiekey::FileActivationStore::FileActivationStore (juce::File file) :
+    file_ (std::move (file)),
+    processLock_ ("indiekey_" + juce::String::toHexString (file_.getFullPathName().hashCode64()))
+{
+    auto result = file_.getParentDirectory().createDirectory();
+    if (result.failed())
+        throw std::runtime_error (result.getErrorMessage().toStdString());
+
+    std::lock_guard lock (mutex_);
+    synchronise();
+}
+
+void indiekey::FileActivationStore::reset()
+{
+    rows_.clear();
+    metadata_.clear();
+    generation_.clear();
+    readPosition_ = 0;
+}
+
+void indiekey::FileActivationStore::synchronise()
+{
+    // The file is only ever created and replaced by renaming a complete file, so when it exists it has a valid header.
+    juce::FileInputStream stream (file_);
+
+    if (!stream.openedOk())
+    {
+        if (file_.exists())
+            throw std::runtime_error ("Failed to open " + file_.getFullPathName().toStdString());
+
+        reset();
+        return;
+    }
+
+    // Checking the header is cheap, the rest of the file is only read when it grew.
+    char headerData[kMaxHeaderSize];
+    auto numHeaderBytes = std::max (0, stream.read (headerData, kMaxHeaderSize));
+
+    auto header = decodeRecord (headerData, static_cast<size_t> (numHeaderBytes));
+    if (!header.has_value() || !header->first.contains ("generation"))
+        throw std::runtime_error ("Invalid activations file: " + file_.getFullPathName().toStdString());
+
+    // Another process compacted the file, start over.
+    if (auto generation = header->first.at ("generation").get<std::string>(); generation != generation_)
+    {
+        reset();
+        generation_ = generation;
+        readPosition_ = static_cast<juce::int64> (header->second);
+    }
+
+    if (stream.getTotalLength() <= readPosition_ || !stream.setPosition (readPosition_))
+        return;
+
+    juce::MemoryBlock data;
+    stream.readIntoMemoryBlock (data);
+
+    auto begin = static_cast<const char*> (data.getData());
+    auto size = data.getSize();
+    size_t position = 0;
+
+    // Stops at the first incomplete or corrupt record, which is either being written or was torn by a crash.
+    while (position < size)
+    {
+        auto record = decodeRecord (begin + position, size - position);
+        if (!record.has_value())
+            break;
+
+        apply (changeFromJson (record->first));
+        position += record->second;
+        readPosition_ += static_cast<juce::int64> (record->second);
+    }
+}
+
+void indiekey::FileActivationStore::append (const std::string& record)
+{
+    juce::FileOutputStream stream (file_);
+
+    if (stream.failedToOpen())
+        throw std::runtime_error (stream.getStatus().getErrorMessage().toStdString());
+
+    // Drops a torn tail left behind by a crash. Safe because all writers hold the process lock.
+    if (stream.getPosition() != readPosition_)
+    {
+        stream.setPosition (readPosition_);
+        stream.truncate();
+    }
+
+    stream.write (record.data(), record.size());
+    stream.flush(); // Also syncs the file to disk.
+
+    if (stream.getStatus().failed())
+        throw std::runtime_error (stream.getStatus().getErrorMessage().toStdString());
+
+    readPosition_ += static_cast<juce::int64> (record.size());
+}
+
+int indiekey::FileActivationStore::commit (const Change& change)
+{
+    juce::InterProcessLock::ScopedLockType processLock (processLock_);
+    if (!processLock.isLocked())
+        throw std::runtime_error ("Failed to lock " + file_.getFullPathName().toStdString());
+
+    if (!file_.existsAsFile())
+        compact(); // Creates the file with a header.
+
+    synchronise(); // Catch up with changes from other processes before appending.
+    append (encodeRecord (changeToJson (change)));
+
+    return apply (change);
+}
+
+void indiekey::FileActivationStore::compact()
+{
+    auto generation = juce::Uuid().toString().toStdString();
+
+    std::string contents = encodeRecord ({ { "generation", generation } });
+
+    for (const auto& row : rows_)
+    {
+        Change change;
+        change.type = Change::Type::Save;
+        change.activations = { row.activation };
+        change.time = row.lastUpdatedAt;
+        contents += encodeRecord (changeToJson (change));
+    }
+
+    if (!metadata_.empty())
+    {
+        Change change;
+        change.type = Change::Type::SetMetadata;
+        change.metadata = metadata_;
+        contents += encodeRecord (changeToJson (change));
+    }
+
+    auto temporaryFile = file_.getSiblingFile (file_.getFileName() + ".tmp");
+    temporaryFile.deleteFile();
+
+    {
+        juce::FileOutputStream stream (temporaryFile);
+        stream.write (contents.data(), contents.size());
+        stream.flush();
+
+        if (stream.failedToOpen() || stream.getStatus().failed())
+            throw std::runtime_error (stream.getStatus().getErrorMessage().toStdString());
+    }
+
+    if (!temporaryFile.moveFileTo (file_))
+        throw std::runtime_error ("Failed to replace " + file_.getFullPathName().toStdString());
+
+    generation_ = generation;
+    readPosition_ = static_cast<juce::int64> (contents.size());
+}
+
+indiekey::ActivationStore::MaintenanceReport
+indiekey::FileActivationStore::runMaintenance (juce::Time now, bool force)
+{
+    std::lock_guard lock (mutex_);
+
+    juce::InterProcessLock::ScopedLockType processLock (processLock_);
+    if (!processLock.isLocked())
+        throw std::runtime_error ("Failed to lock " + file_.getFullPathName().toStdString());
+
+    auto sizeBefore = file_.getSize();
+    auto report = MemoryActivationStore::runMaintenance (now, force);
+
+    if (report.ran)
+    {
+        compact();
+        report.numBytesReclaimed = std::max<juce::int64> (0, sizeBefore - file_.getSize());
+    }
+
+    return report;
+}
+
+void indiekey::FileActivationStore::updateMetadata (
+    const std::vector<std::string>& keys,
+    const std::function<Metadata (const Metadata&)>& update)
+{
+    std::lock_guard lock (mutex_);
+
+    // Held from reading the values until the change is appended, so that no other process writes in between.
+    juce::InterProcessLock::ScopedLockType processLock (processLock_);
+    if (!processLock.isLocked())
+        throw std::runtime_error ("Failed to lock " + file_.getFullPathName().toStdString());
+
+    MemoryActivationStore::updateMetadata (keys, update);
+}
@@ -0,0 +1,407 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/MemoryActivationStore.h"
+
+#include <set>
+
+// Note: the queries in this file must behave exactly like the SQL in SqliteActivationStore, which is verified by the
+// conformance tests in ActivationStore.test.cpp.
+
+bool indiekey::MemoryActivationStore::matches (
+    const Record& row,
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return row.activation.getProductUid() == productUid && row.activation.getMachineUid() == machineUid;
+}
+
+indiekey::MemoryActivationStore::MemoryActivationStore (std::vector<Record> records) : rows_ (std::move (records)) {}
+
+int indiekey::MemoryActivationStore::apply (const Change& change)
+{
+    numChanges_++;
+
+    switch (change.type)
+    {
+    case Change::Type::Save:
+        for (const auto& activation : change.activations)
+        {
+            // Like INSERT OR REPLACE, which gives a replaced row a new id.
+            rows_.erase (
+                std::remove_if (
+                    rows_.begin(),
+                    rows_.end(),
+                    [&activation] (const Record& row) {
+                        return row.activation.getHash() == activation.getHash();
+                    }),
+                rows_.end());
+            rows_.push_back ({ activation, change.time });
+        }
+        return static_cast<int> (change.activations.size());
+
+    case Change::Type::Delete:
+    case Change::Type::DeleteAll:
+    {
+        auto numRowsBefore = rows_.size();
+        rows_.erase (
+            std::remove_if (
+                rows_.begin(),
+                rows_.end(),
+                [&change] (const Record& row) {
+                    if (change.type == Change::Type::Delete)
+                        return row.activation.getHash() == change.hash;
+                    return matches (row, change.productUid, change.machineUid);
+                }),
+            rows_.end());
+        return static_cast<int> (numRowsBefore - rows_.size());
+    }
+
+    case Change::Type::Prune:
+    {
+        // Walk backwards so that the first trial seen for a product and machine is the latest one, which is kept.
+        std::set<std::pair<std::string, std::vector<uint8_t>>> seenTrials;
+        std::vector<Record> kept;
+        kept.reserve (rows_.size());
+
+        for (auto it = rows_.rbegin(); it != rows_.rend(); ++it)
+        {
+            const auto& activation = it->activation;
+            auto isLatestTrial = activation.getLicenseType() == License::Type::Trial &&
+                                 seenTrials.emplace (activation.getProductUid(), activation.getMachineUid()).second;
+
+            auto isBeforeCutoff = [&change] (const std::optional<juce::Time>& time) {
+                return time.has_value() && time->toMilliseconds() < change.time;
+            };
+
+            auto expiredBeforeCutoff = isBeforeCutoff (activation.getExpiresAt()) ||
+                                       isBeforeCutoff (activation.getLicenseExpiresAt());
+
+            if (!expiredBeforeCutoff || isLatestTrial)
+                kept.push_back (*it);
+        }
+
+        auto numPruned = static_cast<int> (rows_.size() - kept.size());
+        rows_.assign (kept.rbegin(), kept.rend());
+        return numPruned;
+    }
+
+    case Change::Type::SetMetadata:
+        for (const auto& [key, value] : change.metadata)
+            metadata_[key] = value;
+
+        return static_cast<int> (change.metadata.size());
+    }
+
+    return 0;
+}
+
+int indiekey::MemoryActivationStore::commit (const Change& change)
+{
+    return apply (change);
+}
+
+void indiekey::MemoryActivationStore::saveActivations (const std::vector<Activation>& activations, juce::Time now)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    Change change;
+    change.type = Change::Type::Save;
+    change.activations = activations;
+    change.time = now.toMilliseconds();
+    commit (change);
+}
+
+void indiekey::MemoryActivationStore::deleteActivation (const Activation::Hash& activationHash)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    Change change;
+    change.type = Change::Type::Delete;
+    change.hash = activationHash;
+    commit (change);
+}
+
+int indiekey::MemoryActivationStore::deleteAllActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    Change change;
+    change.type = Change::Type::DeleteAll;
+    change.productUid = productUid;
+    change.machineUid = machineUid;
+    return commit (change);
+}
+
+std::vector<indiekey::ActivationStore::Record> indiekey::MemoryActivationStore::getRecords (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    std::vector<Record> records;
+
+    for (const auto& row : rows_)
+        if (matches (row, productUid, machineUid))
+            records.push_back (row);
+
+    return records;
+}
+
+juce::int64 indiekey::MemoryActivationStore::getDataVersion()
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+    return numChanges_;
+}
+
+std::vector<indiekey::Activation> indiekey::MemoryActivationStore::getActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    std::vector<Activation> activations;
+
+    for (const auto& row : rows_)
+        if (matches (row, productUid, machineUid))
+            activations.push_back (row.activation);
+
+    return activations;
+}
+
+std::optional<indiekey::Activation> indiekey::MemoryActivationStore::getMostValuableActivation (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    juce::Time now)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    const Activation* mostValuable = nullptr;
+
+    for (const auto& row : rows_)
+        if (matches (row, productUid, machineUid))
+            if (mostValuable == nullptr || row.activation.isMoreValuableThan (*mostValuable, now))
+                mostValuable = &row.activation;
+
+    if (mostValuable == nullptr)
+        return std::nullopt;
+
+    return *mostValuable;
+}
+
+std::vector<indiekey::Activation> indiekey::MemoryActivationStore::getTrialActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    std::vector<Activation> activations;
+
+    for (const auto& row : rows_)
+        if (matches (row, productUid, machineUid) && row.activation.getLicenseType() == License::Type::Trial)
+            activations.push_back (row.activation);
+
+    return activations;
+}
+
+indiekey::ActivationStore::TrialSummary indiekey::MemoryActivationStore::getTrialSummary (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    juce::Time now)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    TrialSummary summary;
+
+    for (const auto& row : rows_)
+    {
+        if (!matches (row, productUid, machineUid) || row.activation.getLicenseType() != License::Type::Trial)
+            continue;
+
+        summary.numTrials++;
+        if (!row.activation.isExpired (now))
+            summary.numActiveTrials++;
+    }
+
+    return summary;
+}
+
+static juce::int64 getRefreshIntervalMs (const indiekey::Activation& activation)
+{
+    return activation.getRefreshInterval()
+        .value_or (juce::RelativeTime::hours (indiekey::ActivationStore::kDefaultRefreshIntervalHours))
+        .inMilliseconds();
+}
+
+std::vector<indiekey::Activation> indiekey::MemoryActivationStore::getActivationsWhichNeedUpdate (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    bool getAllActivations,
+    juce::Time now)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    const auto jitterFactor = getRefreshJitterFactor (machineUid);
+    const auto nowMs = now.toMilliseconds();
+
+    std::vector<Activation> activations;
+
+    for (const auto& row : rows_)
+    {
+        if (!matches (row, productUid, machineUid))
+            continue;
+
+        const auto interval = getRefreshIntervalMs (row.activation);
+        const auto& expiresAt = row.activation.getExpiresAt();
+
+        // Same arithmetic as SQLite: the jittered interval is a real number.
+        if (getAllActivations || (expiresAt.has_value() && expiresAt->toMilliseconds() < nowMs + interval) ||
+            static_cast<double> (row.lastUpdatedAt) <
+                static_cast<double> (nowMs) - static_cast<double> (interval) * jitterFactor)
+            activations.push_back (row.activation);
+    }
+
+    return activations;
+}
+
+std::optional<juce::Time> indiekey::MemoryActivationStore::getNextUpdateTime (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    const auto jitterFactor = getRefreshJitterFactor (machineUid);
+    std::optional<double> next;
+
+    for (const auto& row : rows_)
+    {
+        if (!matches (row, productUid, machineUid))
+            continue;
+
+        const auto interval = getRefreshIntervalMs (row.activation);
+        const auto& expiresAt = row.activation.getExpiresAt();
+
+        auto time = static_cast<double> (row.lastUpdatedAt) + static_cast<double> (interval) * jitterFactor;
+
+        // Same rules as SQLite: the expiry only brings the update forward when the last update was before that point.
+        if (expiresAt.has_value() && expiresAt->toMilliseconds() > row.lastUpdatedAt)
+        {
+            auto dueAt = expiresAt->toMilliseconds() - interval;
+            if (dueAt <= row.lastUpdatedAt)
+                dueAt = expiresAt->toMilliseconds();
+
+            time = std::min (time, static_cast<double> (dueAt));
+        }
+
+        next = next.has_value() ? std::min (*next, time) : time;
+    }
+
+    if (!next.has_value())
+        return std::nullopt;
+
+    return juce::Time (static_cast<juce::int64> (*next)); // Truncates like CAST(... AS INTEGER).
+}
+
+indiekey::ActivationStore::MaintenanceReport
+indiekey::MemoryActivationStore::runMaintenance (juce::Time now, bool force)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    MaintenanceReport report;
+
+    if (!force)
+    {
+        if (auto it = metadata_.find ("last_maintenance_at"); it != metadata_.end() &&
+            now - juce::Time (it->second) < juce::RelativeTime::days (kMaintenanceIntervalDays))
+            return report;
+    }
+
+    Change prune;
+    prune.type = Change::Type::Prune;
+    prune.time = (now - juce::RelativeTime::days (kPruneRetentionDays)).toMilliseconds();
+    report.numRowsPruned = commit (prune);
+
+    Change saveTime;
+    saveTime.type = Change::Type::SetMetadata;
+    saveTime.metadata = { { "last_maintenance_at", now.toMilliseconds() } };
+    commit (saveTime);
+
+    rows_.shrink_to_fit();
+
+    report.ran = true;
+    return report;
+}
+
+std::optional<juce::int64> indiekey::MemoryActivationStore::getMetadata (const std::string& key)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    if (auto it = metadata_.find (key); it != metadata_.end())
+        return it->second;
+
+    return std::nullopt;
+}
+
+void indiekey::MemoryActivationStore::setMetadata (const std::string& key, juce::int64 value)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    Change change;
+    change.type = Change::Type::SetMetadata;
+    change.metadata = { { key, value } };
+    commit (change);
+}
+
+void indiekey::MemoryActivationStore::updateMetadata (
+    const std::vector<std::string>& keys,
+    const std::function<Metadata (const Metadata&)>& update)
+{
+    std::lock_guard lock (mutex_);
+    synchronise();
+
+    Metadata stored;
+
+    for (const auto& key : keys)
+        if (auto it = metadata_.find (key); it != metadata_.end())
+            stored.insert (*it);
+
+    Change change;
+    change.type = Change::Type::SetMetadata;
+    change.metadata = update (stored);
+
+    if (!change.metadata.empty())
+        commit (change);
+}
+
+size_t indiekey::MemoryActivationStore::getMemoryUsage()
+{
+    std::lock_guard lock (mutex_);
+
+    auto usage = sizeof (*this) + (rows_.capacity() - rows_.size()) * sizeof (Record);
+
+    for (const auto& row : rows_)
+        usage += sizeof (row) - sizeof (row.activation) + row.activation.getMemoryUsage();
+
+    for (const auto& [key, value] : metadata_)
+        usage += sizeof (key) + sizeof (value) + key.capacity();
+
+    return usage;
+}
@@ -0,0 +1,118 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/RefreshScheduler.h"
+
+#include <algorithm>
+
+indiekey::RefreshScheduler::RefreshScheduler() : juce::Thread ("IndieKey refresh scheduler") {}
+
+indiekey::RefreshScheduler::~RefreshScheduler()
+{
+    jassert (clients_.empty()); // All clients should have removed themselves by now.
+    stopThread (kMaxWaitMs);
+}
+
+void indiekey::RefreshScheduler::addClient (Client* client)
+{
+    if (client == nullptr)
+        return;
+
+    {
+        std::lock_guard lock (mutex_);
+
+        if (std::find (clients_.begin(), clients_.end(), client) == clients_.end())
+            clients_.push_back (client);
+    }
+
+    if (!isThreadRunning())
+        startThread();
+
+    notify();
+}
+
+void indiekey::RefreshScheduler::removeClient (Client* client)
+{
+    std::unique_lock lock (mutex_);
+
+    clients_.erase (std::remove (clients_.begin(), clients_.end(), client), clients_.end());
+
+    refreshFinished_.wait (lock, [this, client] {
+        return refreshingClient_ != client;
+    });
+}
+
+void indiekey::RefreshScheduler::reschedule()
+{
+    notify();
+}
+
+void indiekey::RefreshScheduler::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::int64 waitMs = kMaxWaitMs;
+        Client* dueClient = nullptr;
+        bool isIdle = false;
+
+        {
+            std::lock_guard lock (mutex_);
+
+            for (auto* client : clients_)
+            {
+                auto timeUntilRefresh = client->getTimeUntilNextRefresh();
+
+                if (timeUntilRefresh.has_value() && timeUntilRefresh->inMilliseconds() <= 0)
+                {
+                    dueClient = client;
+                    break;
+                }
+
+                auto timeUntilIdle = client->getTimeUntilIdle();
+
+                if (timeUntilIdle.has_value() && timeUntilIdle->inMilliseconds() <= 0)
+                {
+                    dueClient = client;
+                    isIdle = true;
+                    break;
+                }
+
+                if (timeUntilRefresh.has_value())
+                    waitMs = std::min (waitMs, timeUntilRefresh->inMilliseconds());
+
+                if (timeUntilIdle.has_value())
+                    waitMs = std::min (waitMs, timeUntilIdle->inMilliseconds());
+            }
+
+            refreshingClient_ = dueClient;
+        }
+
+        if (dueClient == nullptr)
+        {
+            wait (static_cast<int> (waitMs));
+            continue;
+        }
+
+        try
+        {
+            if (isIdle)
+                dueClient->releaseIdleResources();
+            else
+                dueClient->refresh();
+        }
+        catch (const std::exception& e)
+        {
+            juce::ignoreUnused (e);
+            jassertfalse; // Clients are expected to handle their own errors.
+        }
+
+        {
+            std::lock_guard lock (mutex_);
+            refreshingClient_ = nullptr;
+        }
+
+        refreshFinished_.notify_all();
+    }
+}
@@ -0,0 +1,195 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/RequestBudget.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool indiekey::RequestBudget::Policy::operator== (const Policy& rhs) const
+{
+    return capacity == rhs.capacity && refillInterval == rhs.refillInterval;
+}
+
+bool indiekey::RequestBudget::Policy::operator!= (const Policy& rhs) const
+{
+    return !(rhs == *this);
+}
+
+void indiekey::RequestBudget::setPolicy (const Policy& policy)
+{
+    if (policy.capacity < 1 || policy.refillInterval.inMilliseconds() <= 0)
+        throw std::runtime_error ("Request budget policy is invalid");
+
+    std::lock_guard lock (mutex_);
+    policy_ = policy;
+
+    for (auto& [key, bucket] : buckets_)
+        bucket.tokens = std::min (bucket.tokens, static_cast<double> (policy_.capacity));
+}
+
+indiekey::RequestBudget::Policy indiekey::RequestBudget::getPolicy() const
+{
+    std::lock_guard lock (mutex_);
+    return policy_;
+}
+
+bool indiekey::RequestBudget::tryAcquire (ActivationsDatabase& database, juce::Time now)
+{
+    const auto key = getBucketKey (database);
+    std::optional<juce::int64> dataVersion;
+
+    try
+    {
+        dataVersion = database.getDataVersion();
+    }
+    catch (const std::exception& e)
+    {
+        juce::ignoreUnused (e);
+        DBG ("Failed to read the version of the request budget database: " << e.what());
+    }
+
+    std::optional<bool> granted;
+
+    // While nobody changed the database since the stored bucket was read, the bucket in memory is up-to-date and a
+    // request which is throttled doesn't touch the database at all.
+    {
+        std::lock_guard lock (mutex_);
+        auto& bucket = getBucket (key);
+
+        if (dataVersion.has_value() && bucket.dataVersion == dataVersion)
+        {
+            granted = take (bucket, now);
+
+            if (!*granted)
+                return false;
+        }
+    }
+
+    // The database is read and written without holding the mutex. The update function only locks it to merge, which
+    // doesn't block on anything else.
+    try
+    {
+        database.updateMetadata ({ kTokensKey, kUpdatedAtKey }, [&] (const ActivationsDatabase::Metadata& stored) {
+            std::lock_guard lock (mutex_);
+            auto& bucket = getBucket (key);
+
+            merge (bucket, stored, now);
+            bucket.dataVersion = dataVersion; // Writing below changes the version, which only costs another read.
+
+            if (!granted.has_value())
+                granted = take (bucket, now);
+
+            if (!*granted)
+                return ActivationsDatabase::Metadata {}; // Nothing changed.
+
+            return ActivationsDatabase::Metadata {
+                { kTokensKey, static_cast<juce::int64> (std::floor (bucket.tokens * 1000.0)) },
+                { kUpdatedAtKey, bucket.updatedAt.toMilliseconds() },
+            };
+        });
+    }
+    catch (const std::exception& e)
+    {
+        juce::ignoreUnused (e);
+        DBG ("Failed to persist request budget: " << e.what());
+    }
+
+    if (!granted.has_value())
+    {
+        std::lock_guard lock (mutex_);
+        granted = take (getBucket (key), now);
+    }
+
+    return *granted;
+}
+
+juce::Time indiekey::RequestBudget::getNextAvailableTime (const ActivationsDatabase& database, juce::Time now) const
+{
+    std::lock_guard lock (mutex_);
+
+    auto it = buckets_.find (getBucketKey (database));
+    if (it == buckets_.end())
+        return now;
+
+    auto tokens = getTokensAt (it->second, now);
+    if (tokens >= 1.0)
+        return now;
+
+    return now + juce::RelativeTime::milliseconds (
+                     static_cast<juce::int64> (std::ceil ((1.0 - tokens) * policy_.refillInterval.inMilliseconds())));
+}
+
+indiekey::RequestBudget::Counters indiekey::RequestBudget::getCounters() const
+{
+    std::lock_guard lock (mutex_);
+    return counters_;
+}
+
+indiekey::RequestBudget::Bucket& indiekey::RequestBudget::getBucket (const std::string& key)
+{
+    return buckets_.try_emplace (key, Bucket { static_cast<double> (policy_.capacity), {}, std::nullopt })
+        .first->second;
+}
+
+bool indiekey::RequestBudget::take (Bucket& bucket, juce::Time now)
+{
+    refill (bucket, now);
+
+    if (bucket.tokens < 1.0)
+    {
+        counters_.numThrottled++;
+        return false;
+    }
+
+    bucket.tokens -= 1.0;
+    counters_.numGranted++;
+    return true;
+}
+
+void indiekey::RequestBudget::refill (Bucket& bucket, juce::Time now) const
+{
+    bucket.tokens = getTokensAt (bucket, now);
+
+    if (now > bucket.updatedAt)
+        bucket.updatedAt = now;
+}
+
+void indiekey::RequestBudget::merge (Bucket& bucket, const ActivationsDatabase::Metadata& stored, juce::Time now) const
+{
+    refill (bucket, now);
+
+    auto tokens = stored.find (kTokensKey);
+    auto updatedAt = stored.find (kUpdatedAtKey);
+
+    if (tokens == stored.end() || updatedAt == stored.end())
+        return; // Nothing spent yet.
+
+    // Both buckets only ever lose tokens to requests, so the emptier one includes the requests of the other.
+    auto capacity = static_cast<double> (policy_.capacity);
+    auto storedTokens = std::clamp (static_cast<double> (tokens->second) / 1000.0, 0.0, capacity);
+    storedTokens = getTokensAt (storedTokens, juce::Time (updatedAt->second), bucket.updatedAt);
+    bucket.tokens = std::min (bucket.tokens, storedTokens);
+}
+
+double indiekey::RequestBudget::getTokensAt (const Bucket& bucket, juce::Time now) const
+{
+    return getTokensAt (bucket.tokens, bucket.updatedAt, now);
+}
+
+double indiekey::RequestBudget::getTokensAt (double tokens, juce::Time since, juce::Time now) const
+{
+    // A clock which went backwards doesn't take tokens away, it only delays earning new ones.
+    auto elapsedMs = std::max<juce::int64> (0, (now - since).inMilliseconds());
+    auto earned = static_cast<double> (elapsedMs) / static_cast<double> (policy_.refillInterval.inMilliseconds());
+    return std::min (tokens + earned, static_cast<double> (policy_.capacity));
+}
+
+std::string indiekey::RequestBudget::getBucketKey (const ActivationsDatabase& database)
+{
+    // Databases in memory can't be shared with other processes, so all of them share one bucket.
+    const auto& options = database.getOptions();
+    return options.inMemory ? std::string() : options.databaseFile.getFullPathName().toStdString();
+}
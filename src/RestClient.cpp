@@ -4,11 +4,45 @@
 //
 
 #include "indiekey/RestClient.h"
+#include "indiekey/WebTransport.h"
 
 #include <nlohmann/json.hpp>
 
+#include <ostream>
+#include <streambuf>
 #include <utility>
 
+namespace
+{
+
+/**
+ * Stream buffer which appends to a string, so that json can be serialised into an existing buffer.
+ */
+class StringAppendBuffer : public std::streambuf
+{
+public:
+    explicit StringAppendBuffer (std::string& target) : target_ (target) {}
+
+protected:
+    int_type overflow (int_type c) override
+    {
+        if (!traits_type::eq_int_type (c, traits_type::eof()))
+            target_.push_back (traits_type::to_char_type (c));
+        return traits_type::not_eof (c);
+    }
+
+    std::streamsize xsputn (const char* data, std::streamsize size) override
+    {
+        target_.append (data, static_cast<size_t> (size));
+        return size;
+    }
+
+private:
+    std::string& target_;
+};
+
+} // namespace
+
 indiekey::RestClient::Exception::Exception (int statusCode, const char* message) :
     mMessage (std::to_string (statusCode) + " " + message)
 {
@@ -19,51 +53,37 @@ indiekey::RestClient::Exception::Exception (const indiekey::RestClient::Response
 {
 }
 
-indiekey::RestClient::RestClient (juce::URL address) : mAddress (std::move (address)) {}
-
-indiekey::RestClient::Response indiekey::RestClient::get (juce::StringRef path)
+indiekey::RestClient::RestClient (juce::URL address, std::shared_ptr<Transport> transport) :
+    mAddress (std::move (address)),
+    mTransport (transport != nullptr ? std::move (transport) : std::make_shared<WebTransport>())
 {
-    auto requestUrl = mAddress.getChildURL (path);
-
-    Response response;
-
-    auto inputStream = requestUrl.createInputStream (
-        getDefaultInputStreamOptions().withStatusCode (&response.statusCode));
-
-    if (inputStream == nullptr)
-        throw std::runtime_error ("Failed to reach activation server");
-
-    response.body = inputStream->readEntireStreamAsString();
-
-    return response;
 }
 
-indiekey::RestClient::Response indiekey::RestClient::post (juce::StringRef path, const nlohmann::json& postData)
+size_t indiekey::RestClient::getMemoryUsage() const
 {
-    auto requestUrl = mAddress.getChildURL (path);
-    requestUrl = requestUrl.withPOSTData (postData.dump());
-
-    Response response;
-
-    auto inputStream = requestUrl.createInputStream (getDefaultInputStreamOptions()
-                                                         .withStatusCode (&response.statusCode)
-                                                         .withExtraHeaders ("Content-Type: application/json")
-                                                         .withConnectionTimeoutMs (3000));
-
-    if (inputStream == nullptr)
-        throw std::runtime_error ("Failed to reach activation server");
-
-    response.body = inputStream->readEntireStreamAsString();
+    return sizeof (*this) + mAddress.toString (true).getNumBytesAsUTF8();
+}
 
-    return response;
+indiekey::RestClient::Response indiekey::RestClient::get (juce::StringRef path, CancellationToken* cancellationToken)
+{
+    return mTransport->send ({ mAddress.getChildURL (path), false, {}, 1000 }, cancellationToken);
 }
 
-const juce::URL::InputStreamOptions& indiekey::RestClient::getDefaultInputStreamOptions()
+indiekey::RestClient::Response indiekey::RestClient::post (
+    juce::StringRef path,
+    const nlohmann::json& postData,
+    CancellationToken* cancellationToken)
 {
-    static const auto inputStreamOptions = juce::URL::InputStreamOptions (juce::URL::ParameterHandling::inAddress)
-                                               .withConnectionTimeoutMs (1000)
-                                               .withNumRedirectsToFollow (0);
-    return inputStreamOptions;
+    // Serialised once, into a buffer which is reused by all posts on this thread. The URL keeps its own copy.
+    thread_local std::string body;
+    body.clear();
+
+    StringAppendBuffer buffer (body);
+    std::ostream stream (&buffer);
+    stream << postData;
+
+    auto requestUrl = mAddress.getChildURL (path).withPOSTData (juce::MemoryBlock (body.data(), body.size()));
+    return mTransport->send ({ requestUrl, true, "Content-Type: application/json", 3000 }, cancellationToken);
 }
 
 bool indiekey::RestClient::Response::isInformational() const
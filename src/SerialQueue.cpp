@@ -0,0 +1,100 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/SerialQueue.h"
+
+#include <algorithm>
+
+void indiekey::SerialQueue::run (const Task& task)
+{
+    run ({}, task);
+}
+
+void indiekey::SerialQueue::run (const std::string& mergeKey, const Task& task)
+{
+    std::unique_lock lock (mutex_);
+
+    if (runningThread_ == std::this_thread::get_id())
+    {
+        // Called from within a task, waiting would deadlock.
+        lock.unlock();
+        task();
+        return;
+    }
+
+    std::shared_ptr<Entry> entry;
+
+    if (!mergeKey.empty())
+    {
+        auto it = std::find_if (pending_.begin(), pending_.end(), [&mergeKey] (const auto& pendingEntry) {
+            return pendingEntry->mergeKey == mergeKey;
+        });
+
+        if (it != pending_.end())
+        {
+            entry = *it;
+            numMergedTasks_++;
+        }
+    }
+
+    if (entry == nullptr)
+    {
+        entry = std::make_shared<Entry>();
+        entry->mergeKey = mergeKey;
+        entry->task = task;
+        pending_.push_back (entry);
+    }
+
+    while (!entry->done)
+    {
+        if (runningThread_ != std::thread::id())
+        {
+            taskFinished_.wait (lock);
+            continue;
+        }
+
+        // Nobody is running tasks, so this thread runs the next one. This is not necessarily the task of this thread.
+        auto next = pending_.front();
+        pending_.pop_front();
+        runningThread_ = std::this_thread::get_id();
+
+        lock.unlock();
+
+        try
+        {
+            next->task();
+        }
+        catch (...)
+        {
+            next->exception = std::current_exception();
+        }
+
+        lock.lock();
+
+        next->done = true;
+        next->task = nullptr; // Releases captured state right away.
+        runningThread_ = {};
+
+        taskFinished_.notify_all();
+    }
+
+    if (entry->exception != nullptr)
+        std::rethrow_exception (entry->exception);
+}
+
+size_t indiekey::SerialQueue::getNumMergedTasks() const
+{
+    std::lock_guard lock (mutex_);
+    return numMergedTasks_;
+}
+
+void indiekey::SerialQueue::waitUntilIdle()
+{
+    std::unique_lock lock (mutex_);
+
+    taskFinished_.wait (lock, [this] {
+        return pending_.empty() && runningThread_ == std::thread::id();
+    });
+}
@@ -0,0 +1,581 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/SharedStatusCache.h"
+#include "indiekey/Crypto.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if JUCE_WINDOWS
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+
+constexpr uint32_t kRegionMagic = 0x314b4953; // "SIK1", changes with the layout.
+constexpr size_t kNumSlots = 256;
+constexpr size_t kMaxBytes = 64; // Of activation hashes and signatures.
+constexpr juce::int64 kNoTime = std::numeric_limits<juce::int64>::min();
+constexpr int kMaxEntryAgeMinutes = 60; // In case a process changed the activations without invalidating.
+constexpr int kMaxAttempts = 100;       // To read a slot or key file which isn't being written.
+
+/**
+ * The contents of a slot, which are covered by the MAC. Fixed size and without padding, so that the bytes are the
+ * same in every process.
+ */
+struct Payload
+{
+    uint8_t slotKey[indiekey::crypto::kGenericHashBytes];
+    uint8_t activationHash[kMaxBytes];
+    uint8_t signature[kMaxBytes];
+    uint32_t activationHashSize;
+    uint32_t signatureSize;
+    int32_t licenseType;
+    int32_t hasActivation;
+    juce::int64 expiresAt;
+    juce::int64 licenseExpiresAt;
+    juce::int64 refreshIntervalMs;
+    juce::int64 nextUpdateAt;
+    juce::int64 publishedAt;
+};
+
+static_assert (sizeof (Payload) == 216, "Payload must not contain padding");
+
+/**
+ * Creates given file with given contents, readable and writable by its owner only.
+ * @returns False if the file already existed or couldn't be written.
+ */
+bool createExclusively (const juce::File& file, const void* data, size_t size)
+{
+#if JUCE_WINDOWS
+    int fd = -1;
+    if (_wsopen_s (
+            &fd,
+            file.getFullPathName().toWideCharPointer(),
+            _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY,
+            _SH_DENYNO,
+            _S_IREAD | _S_IWRITE) != 0)
+        return false;
+
+    auto written = size == 0 ? 0 : _write (fd, data, static_cast<unsigned int> (size));
+    _close (fd);
+#else
+    auto fd = ::open (file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return false;
+
+    auto written = size == 0 ? 0 : ::write (fd, data, size);
+    ::close (fd);
+#endif
+
+    return written == static_cast<decltype (written)> (size);
+}
+
+/**
+ * @returns True if given file is a regular file, owned by the user of this process and not accessible by others.
+ */
+bool isPrivateToUser (const juce::File& file)
+{
+#if JUCE_WINDOWS
+    return file.existsAsFile(); // The temporary directory is private to the user already.
+#else
+    struct stat info {};
+
+    // Doesn't follow links, so that a link to a file of another user isn't taken for that file.
+    if (::lstat (file.getFullPathName().toRawUTF8(), &info) != 0)
+        return false;
+
+    return S_ISREG (info.st_mode) && info.st_uid == ::geteuid() && (info.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+#endif
+}
+
+/**
+ * Activations of which this process verified the signature, so that looking up the same published activation again
+ * only checks its expiry. Keyed by a hash of the verifying key and everything the activation is made of.
+ */
+class VerifiedActivations
+{
+public:
+    using Key = std::array<uint8_t, indiekey::crypto::kGenericHashBytes>;
+
+    std::optional<indiekey::Activation> find (const Key& key)
+    {
+        std::lock_guard lock (mutex_);
+
+        if (auto it = activations_.find (key); it != activations_.end())
+            return it->second;
+
+        return std::nullopt;
+    }
+
+    void add (const Key& key, const indiekey::Activation& activation)
+    {
+        std::lock_guard lock (mutex_);
+
+        // Rarely more than a few products are installed, so hitting the limit means the entries are mostly outdated.
+        if (activations_.size() >= kMaxSize)
+            activations_.clear();
+
+        activations_.emplace (key, activation);
+    }
+
+    static VerifiedActivations& getInstance()
+    {
+        static VerifiedActivations instance;
+        return instance;
+    }
+
+private:
+    static constexpr size_t kMaxSize = 64;
+
+    std::mutex mutex_;
+    std::map<Key, indiekey::Activation> activations_;
+};
+
+/**
+ * @returns The key under which the activation in given payload is stored in VerifiedActivations.
+ */
+std::array<uint8_t, indiekey::crypto::kGenericHashBytes> getVerifiedActivationKey (
+    const Payload& payload,
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    const std::vector<uint8_t>& verifyingKey)
+{
+    static const uint8_t separator = 0;
+
+    // The parts which are not part of the activation are left out, so that republishing it keeps the key the same.
+    auto activationPart = payload;
+    std::memset (activationPart.slotKey, 0, sizeof (activationPart.slotKey));
+    activationPart.nextUpdateAt = 0;
+    activationPart.publishedAt = 0;
+
+    std::array<uint8_t, indiekey::crypto::kGenericHashBytes> key {};
+
+    indiekey::crypto::GenericHash hash;
+    hash.update (verifyingKey.data(), verifyingKey.size());
+    hash.update (&separator, 1);
+    hash.update (productUid);
+    hash.update (&separator, 1);
+    hash.update (machineUid.data(), machineUid.size());
+    hash.update (reinterpret_cast<const uint8_t*> (&activationPart), sizeof (activationPart));
+    hash.finish (key.data());
+
+    return key;
+}
+
+juce::int64 millisecondsFromTime (const std::optional<juce::Time>& time)
+{
+    return time.has_value() ? time->toMilliseconds() : kNoTime;
+}
+
+std::optional<juce::Time> timeFromMilliseconds (juce::int64 milliseconds)
+{
+    if (milliseconds == kNoTime)
+        return std::nullopt;
+    return juce::Time (milliseconds);
+}
+
+} // namespace
+
+struct indiekey::SharedStatusCache::Slot
+{
+    std::atomic<uint32_t> sequence; // Odd while a writer changes the slot.
+    uint32_t reserved;
+    Payload payload;
+    uint8_t mac[crypto::kGenericHashBytes];
+};
+
+struct indiekey::SharedStatusCache::Region
+{
+    struct Header
+    {
+        std::atomic<uint32_t> magic;
+        uint8_t reserved[60];
+    };
+
+    static constexpr size_t kSize = sizeof (Header) + kNumSlots * sizeof (Slot);
+
+    std::unique_ptr<juce::MemoryMappedFile> file;
+    Slot* slots = nullptr;
+};
+
+static_assert (std::atomic<uint32_t>::is_always_lock_free, "Atomics in shared memory must be lock free");
+
+indiekey::SharedStatusCache::SharedStatusCache (const juce::File& databaseFile, const std::string& regionName) :
+    databasePath_ (databaseFile.getFullPathName().toStdString())
+{
+    // The key is read once per process, so that constructing many clients doesn't read the file over and over.
+    static std::mutex keysMutex;
+    static std::map<std::string, std::array<uint8_t, 32>> keys;
+
+    {
+        std::lock_guard lock (keysMutex);
+
+        if (auto it = keys.find (databasePath_); it != keys.end())
+            key_ = it->second;
+        else if (loadOrCreateKey (databaseFile, key_))
+            keys[databasePath_] = key_;
+        else
+            return; // Disabled.
+    }
+
+    region_ = openRegion (regionName.empty() ? getDefaultRegionName() : regionName);
+}
+
+indiekey::SharedStatusCache::~SharedStatusCache() = default;
+
+bool indiekey::SharedStatusCache::isAvailable() const
+{
+    return region_ != nullptr;
+}
+
+indiekey::SharedStatusCache::Lookup indiekey::SharedStatusCache::lookup (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    const std::vector<uint8_t>& verifyingKey,
+    juce::Time now)
+{
+    Lookup result;
+
+    if (!isAvailable())
+        return result;
+
+    std::array<uint8_t, 32> slotKey {};
+    auto* slot = getSlot (productUid, machineUid, slotKey);
+
+    Payload payload {};
+    uint8_t mac[crypto::kGenericHashBytes] {};
+
+    for (int attempt = 0;; ++attempt)
+    {
+        result.version = slot->sequence.load (std::memory_order_acquire);
+
+        // A slot which stays odd belongs to a writer which crashed, it misses until another writer takes it over.
+        if (attempt == kMaxAttempts)
+            return result;
+
+        if ((result.version & 1) != 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Read optimistically, the copy is only used when no writer started in the meantime.
+        std::memcpy (&payload, &slot->payload, sizeof (payload));
+        std::memcpy (mac, slot->mac, sizeof (mac));
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (slot->sequence.load (std::memory_order_relaxed) == result.version)
+            break;
+    }
+
+    if (std::memcmp (payload.slotKey, slotKey.data(), slotKey.size()) != 0)
+        return result; // Empty, invalidated or taken by another product.
+
+    uint8_t expectedMac[crypto::kGenericHashBytes];
+    crypto::keyedHash (reinterpret_cast<const uint8_t*> (&payload), sizeof (payload), key_.data(), expectedMac);
+
+    if (std::memcmp (mac, expectedMac, sizeof (mac)) != 0)
+        return result;
+
+    if (std::abs ((now - juce::Time (payload.publishedAt)).inMinutes()) >= kMaxEntryAgeMinutes)
+        return result;
+
+    Entry entry;
+    entry.nextUpdateTime = timeFromMilliseconds (payload.nextUpdateAt);
+
+    if (payload.hasActivation != 0)
+    {
+        if (payload.activationHashSize > kMaxBytes || payload.signatureSize > kMaxBytes)
+            return result;
+
+        // Everything but the time is covered by the key, so an activation which was verified before is only checked
+        // for expiry, in the same way Activation::validate does.
+        auto verifiedKey = getVerifiedActivationKey (payload, productUid, machineUid, verifyingKey);
+
+        if (auto verified = VerifiedActivations::getInstance().find (verifiedKey))
+        {
+            auto licenseExpiresAt = timeFromMilliseconds (payload.licenseExpiresAt);
+            auto expiresAt = timeFromMilliseconds (payload.expiresAt);
+
+            auto isLicenseExpired = licenseExpiresAt.has_value() && now > *licenseExpiresAt;
+            auto isActivationExpired = expiresAt.has_value() && now > *expiresAt;
+
+            if (isLicenseExpired || isActivationExpired)
+                return result;
+
+            entry.activation = std::move (verified);
+            result.entry = std::move (entry);
+            return result;
+        }
+
+        if (payload.licenseType < static_cast<int32_t> (License::Type::Undefined) ||
+            payload.licenseType > static_cast<int32_t> (License::Type::Beta))
+            return result;
+
+        std::optional<juce::RelativeTime> refreshInterval;
+        if (payload.refreshIntervalMs >= 0)
+            refreshInterval = juce::RelativeTime::milliseconds (payload.refreshIntervalMs);
+
+        Activation activation (
+            Activation::Hash (payload.activationHash, payload.activationHash + payload.activationHashSize),
+            productUid,
+            machineUid,
+            timeFromMilliseconds (payload.expiresAt),
+            timeFromMilliseconds (payload.licenseExpiresAt),
+            static_cast<License::Type> (payload.licenseType),
+            std::vector<uint8_t> (payload.signature, payload.signature + payload.signatureSize),
+            refreshInterval);
+
+        // The MAC only shows the entry was written by a process of this user, which is not proof of a license.
+        if (activation.validate (productUid, machineUid, verifyingKey, now) != Activation::Status::Valid)
+            return result;
+
+        VerifiedActivations::getInstance().add (verifiedKey, activation);
+        entry.activation = std::move (activation);
+    }
+
+    result.entry = std::move (entry);
+    return result;
+}
+
+bool indiekey::SharedStatusCache::publish (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    Version version,
+    const Activation* activation,
+    std::optional<juce::Time> nextUpdateTime,
+    juce::Time now)
+{
+    if (!isAvailable())
+        return false;
+
+    std::array<uint8_t, 32> slotKey {};
+    auto* slot = getSlot (productUid, machineUid, slotKey);
+
+    Payload payload;
+    std::memset (&payload, 0, sizeof (payload));
+    uint8_t mac[crypto::kGenericHashBytes] {};
+
+    auto isPublishable = activation == nullptr ||
+                         (activation->getStatus() == Activation::Status::Valid &&
+                          activation->getHash().size() <= kMaxBytes && activation->getSignature().size() <= kMaxBytes);
+
+    // Anything else leaves the slot empty, so that readers validate from the database themselves.
+    if (isPublishable)
+    {
+        std::memcpy (payload.slotKey, slotKey.data(), slotKey.size());
+        payload.nextUpdateAt = millisecondsFromTime (nextUpdateTime);
+        payload.publishedAt = now.toMilliseconds();
+        payload.expiresAt = kNoTime;
+        payload.licenseExpiresAt = kNoTime;
+        payload.refreshIntervalMs = -1;
+
+        if (activation != nullptr)
+        {
+            const auto& hash = activation->getHash();
+            const auto& signature = activation->getSignature();
+
+            payload.hasActivation = 1;
+            std::memcpy (payload.activationHash, hash.data(), hash.size());
+            payload.activationHashSize = static_cast<uint32_t> (hash.size());
+            std::memcpy (payload.signature, signature.data(), signature.size());
+            payload.signatureSize = static_cast<uint32_t> (signature.size());
+            payload.licenseType = static_cast<int32_t> (activation->getLicenseType());
+            payload.expiresAt = millisecondsFromTime (activation->getExpiresAt());
+            payload.licenseExpiresAt = millisecondsFromTime (activation->getLicenseExpiresAt());
+
+            if (activation->getRefreshInterval().has_value())
+                payload.refreshIntervalMs = activation->getRefreshInterval()->inMilliseconds();
+        }
+
+        crypto::keyedHash (reinterpret_cast<const uint8_t*> (&payload), sizeof (payload), key_.data(), mac);
+    }
+
+    // Fails when another process wrote or invalidated the slot since the lookup, or is writing it right now.
+    auto expected = version;
+    if ((version & 1) != 0)
+        return false;
+
+    if (!slot->sequence.compare_exchange_strong (expected, version + 1, std::memory_order_acquire))
+        return false;
+
+    std::atomic_thread_fence (std::memory_order_release);
+    std::memcpy (&slot->payload, &payload, sizeof (payload));
+    std::memcpy (slot->mac, mac, sizeof (mac));
+    slot->sequence.store (version + 2, std::memory_order_release);
+
+    return isPublishable;
+}
+
+void indiekey::SharedStatusCache::invalidate (const std::string& productUid, const std::vector<uint8_t>& machineUid)
+{
+    if (!isAvailable())
+        return;
+
+    std::array<uint8_t, 32> slotKey {};
+    auto* slot = getSlot (productUid, machineUid, slotKey);
+
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt)
+    {
+        auto version = slot->sequence.load (std::memory_order_acquire);
+
+        if ((version & 1) == 0 && slot->sequence.compare_exchange_strong (version, version + 1))
+        {
+            std::atomic_thread_fence (std::memory_order_release);
+            std::memset (&slot->payload, 0, sizeof (Payload));
+            std::memset (slot->mac, 0, sizeof (slot->mac));
+            slot->sequence.store (version + 2, std::memory_order_release);
+            return;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+indiekey::SharedStatusCache::Slot* indiekey::SharedStatusCache::getSlot (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    std::array<uint8_t, 32>& slotKey) const
+{
+    static const uint8_t separator = 0;
+
+    crypto::GenericHash hash;
+    hash.update (databasePath_);
+    hash.update (&separator, 1);
+    hash.update (productUid);
+    hash.update (&separator, 1);
+    hash.update (machineUid.data(), machineUid.size());
+    hash.finish (slotKey.data());
+
+    auto index = (static_cast<size_t> (slotKey[0]) | static_cast<size_t> (slotKey[1]) << 8) % kNumSlots;
+    return region_->slots + index;
+}
+
+std::string indiekey::SharedStatusCache::getDefaultRegionName()
+{
+    // Named per user, as the region is only for processes which can read the key files of that user anyway.
+    static const auto name = [] {
+        auto userHash = crypto::genericHash (juce::SystemStats::getLogonName().toStdString());
+        return "indiekey-status-" + juce::String::toHexString (userHash.data(), 8, 0).toStdString();
+    }();
+
+    return name;
+}
+
+void indiekey::SharedStatusCache::deleteRegion (const std::string& regionName)
+{
+    getRegionFile (regionName).deleteFile();
+}
+
+juce::File indiekey::SharedStatusCache::getRegionFile (const std::string& regionName)
+{
+    auto directory = juce::File ("/dev/shm");
+    if (!directory.isDirectory())
+        directory = juce::File::getSpecialLocation (juce::File::tempDirectory);
+
+    return directory.getChildFile (regionName);
+}
+
+std::shared_ptr<indiekey::SharedStatusCache::Region>
+indiekey::SharedStatusCache::openRegion (const std::string& regionName)
+{
+    // One mapping per region and process, shared by all caches and released with the last of them.
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<Region>> shared;
+
+    std::lock_guard lock (mutex);
+
+    if (auto region = shared[regionName].lock())
+        return region;
+
+    // Fails when another process created the region first, which is checked below like any existing region.
+    auto file = getRegionFile (regionName);
+    createExclusively (file, nullptr, 0);
+
+    // The directory is shared by all users. A region which another user created or can access could be read, or
+    // written to publish results for processes which can't tell the difference, so the cache is disabled instead.
+    if (!isPrivateToUser (file))
+        return nullptr;
+
+    if (file.getSize() < static_cast<juce::int64> (Region::kSize))
+    {
+        // Appends zeros, so that slots other processes wrote in the meantime are kept.
+        juce::FileOutputStream stream (file);
+        if (stream.failedToOpen())
+            return nullptr;
+
+        stream.writeRepeatedByte (0, Region::kSize - static_cast<size_t> (file.getSize()));
+        stream.flush();
+    }
+
+    auto region = std::make_shared<Region>();
+    region->file = std::make_unique<juce::MemoryMappedFile> (
+        file,
+        juce::Range<juce::int64> (0, static_cast<juce::int64> (Region::kSize)),
+        juce::MemoryMappedFile::readWrite,
+        false);
+
+    if (region->file->getData() == nullptr || region->file->getSize() < Region::kSize)
+        return nullptr;
+
+    auto* header = static_cast<Region::Header*> (region->file->getData());
+    auto magic = 0u;
+
+    // A region of another layout is left alone, which disables the cache until it's gone (for example after a reboot).
+    if (!header->magic.compare_exchange_strong (magic, kRegionMagic) && magic != kRegionMagic)
+        return nullptr;
+
+    region->slots = reinterpret_cast<Slot*> (static_cast<char*> (region->file->getData()) + sizeof (Region::Header));
+    shared[regionName] = region;
+    return region;
+}
+
+bool indiekey::SharedStatusCache::loadOrCreateKey (const juce::File& databaseFile, std::array<uint8_t, 32>& key)
+{
+    static_assert (std::tuple_size_v<std::array<uint8_t, 32>> == crypto::kKeyedHashKeyBytes);
+
+    auto keyFile = databaseFile.getSiblingFile (databaseFile.getFileName() + ".statuskey");
+
+    if (!keyFile.existsAsFile())
+    {
+        if (!keyFile.getParentDirectory().createDirectory().wasOk())
+            return false;
+
+        // Only one process creates the key. The others, including those which lost the race, read that one below, so
+        // that all processes end up with the same key.
+        crypto::randomBytes (key.data(), key.size());
+        createExclusively (keyFile, key.data(), key.size());
+    }
+
+    juce::MemoryBlock data;
+
+    // The process which created the file might still be writing the key.
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt)
+    {
+        if (keyFile.loadFileAsData (data) && data.getSize() == key.size())
+        {
+            std::memcpy (key.data(), data.getData(), key.size());
+            return true;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return false;
+}
@@ -0,0 +1,662 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/SqliteActivationStore.h"
+
+#include <SQLiteCpp/Transaction.h>
+#include <sqlite3.h>
+
+std::atomic<juce::int64> indiekey::SqliteActivationStore::numBusyErrors_ { 0 };
+
+indiekey::SqliteActivationStore::SqliteActivationStore() :
+    database_ (std::make_unique<SQLite::Database> (":memory:", SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE))
+{
+    initialise (0);
+}
+
+indiekey::SqliteActivationStore::SqliteActivationStore (const juce::File& databaseFile, int cacheSizeKiB)
+{
+    auto result = databaseFile.getParentDirectory().createDirectory();
+    if (result.failed())
+        throw std::runtime_error (result.getErrorMessage().toStdString());
+
+    database_ = std::make_unique<SQLite::Database> (
+        databaseFile.getFullPathName().toRawUTF8(),
+        SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE,
+        kBusyTimeoutMs);
+
+    initialise (cacheSizeKiB);
+
+    // In WAL mode readers see the last committed snapshot and don't wait for writers. Queries use their own connection
+    // with a short timeout, so that they fail fast with BusyError in the rare cases they do have to wait, for example
+    // while another process recovers the WAL after a crash.
+    readOnlyDatabase_ = std::make_unique<SQLite::Database> (
+        databaseFile.getFullPathName().toRawUTF8(),
+        SQLite::OPEN_READONLY,
+        kReadBusyTimeoutMs);
+
+    readOnlyDatabase_->exec ("PRAGMA synchronous = NORMAL");
+
+    if (cacheSizeKiB > 0)
+        readOnlyDatabase_->exec ("PRAGMA cache_size = -" + std::to_string (cacheSizeKiB));
+}
+
+void indiekey::SqliteActivationStore::initialise (int cacheSizeKiB)
+{
+    // A negative cache size is in KiB instead of pages.
+    if (cacheSizeKiB > 0)
+        database_->exec ("PRAGMA cache_size = -" + std::to_string (cacheSizeKiB));
+
+    // Only takes effect for new databases, existing ones are converted by runMaintenance.
+    database_->exec ("PRAGMA auto_vacuum = INCREMENTAL");
+
+    // WAL is persistent, so this converts existing databases once. NORMAL only syncs at checkpoints, which in WAL mode
+    // can lose the last transactions on power loss but never corrupts the database. Both are ignored in memory.
+    database_->exec ("PRAGMA journal_mode = WAL");
+    database_->exec ("PRAGMA synchronous = NORMAL");
+
+    migrate (*database_);
+}
+
+juce::int64 indiekey::SqliteActivationStore::getNumBusyErrors()
+{
+    return numBusyErrors_;
+}
+
+template <typename Function>
+auto indiekey::SqliteActivationStore::read (Function&& function)
+{
+    try
+    {
+        return function (readOnlyDatabase_ != nullptr ? *readOnlyDatabase_ : *database_);
+    }
+    catch (const SQLite::Exception& e)
+    {
+        if (auto code = e.getErrorCode() & 0xff; code == SQLITE_BUSY || code == SQLITE_LOCKED)
+        {
+            numBusyErrors_++;
+            throw BusyError (e.what());
+        }
+        throw;
+    }
+}
+
+void indiekey::SqliteActivationStore::migrate (SQLite::Database& database)
+{
+    // Each migration brings the schema to the version equal to its index + 1. The current version is kept in
+    // PRAGMA user_version. Databases created before versioning was introduced have version 0.
+    static const std::vector<const char*> migrations {
+        R"(create table if not exists activations(
+            id                 integer primary key autoincrement,
+            hash               blob unique not null,
+            product_uid        text        not null,
+            machine_uid        blob        not null,
+            expires_at         integer,
+            license_expires_at integer,
+            last_updated_at    integer     not null,
+            license_type       text        not null,
+            signature          blob        not null);
+           create index if not exists activations_product_machine on activations(product_uid, machine_uid);
+        )",
+        R"(alter table activations add column refresh_interval integer;
+        )",
+        R"(create table if not exists metadata(
+            key   text primary key,
+            value);
+        )",
+    };
+
+    auto getVersion = [&database] {
+        return static_cast<size_t> (database.execAndGet ("PRAGMA user_version").getInt());
+    };
+
+    // Checked without a transaction first, so that opening an up-to-date database doesn't take the write lock.
+    if (getVersion() >= migrations.size())
+        return;
+
+    for (;;)
+    {
+        // Immediate, so that of two processes upgrading at the same time (for example during a plugin scan) one waits
+        // for the other and then reads its version, instead of applying the same step twice.
+        SQLite::Transaction transaction (database, SQLite::TransactionBehavior::IMMEDIATE);
+
+        auto version = getVersion();
+        if (version >= migrations.size())
+            return;
+
+        database.exec (migrations[version]);
+        database.exec ("PRAGMA user_version = " + std::to_string (version + 1));
+        transaction.commit();
+    }
+}
+
+static constexpr auto kSaveActivationQuery = R"(INSERT OR REPLACE INTO activations(
+            hash, product_uid, machine_uid, expires_at, license_expires_at, last_updated_at, license_type, signature,
+            refresh_interval)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);
+        )";
+
+static void bindActivation (SQLite::Statement& statement, const indiekey::Activation& activation, juce::Time now)
+{
+    const auto& activationHash = activation.getHash();
+    statement.bind (1, activationHash.data(), static_cast<int> (activationHash.size()));
+    statement.bind (2, activation.getProductUid());
+    const auto& machineUid = activation.getMachineUid();
+    statement.bind (3, machineUid.data(), static_cast<int> (machineUid.size()));
+    activation.getExpiresAt().has_value() ? statement.bind (4, activation.getExpiresAt()->toMilliseconds())
+                                          : statement.bind (4, nullptr);
+    activation.getLicenseExpiresAt().has_value()
+        ? statement.bind (5, activation.getLicenseExpiresAt()->toMilliseconds())
+        : statement.bind (5, nullptr);
+    statement.bind (6, now.toMilliseconds());
+    statement.bind (7, indiekey::License::typeToString (activation.getLicenseType()));
+    const auto& signature = activation.getSignature();
+    statement.bind (8, signature.data(), static_cast<int> (signature.size()));
+    activation.getRefreshInterval().has_value()
+        ? statement.bind (9, activation.getRefreshInterval()->inMilliseconds())
+        : statement.bind (9, nullptr);
+}
+
+void indiekey::SqliteActivationStore::saveActivation (const indiekey::Activation& activation, juce::Time now)
+{
+    std::lock_guard lock (writeMutex_);
+    auto& database = *database_;
+
+    SQLite::Statement statement (database, kSaveActivationQuery);
+    bindActivation (statement, activation, now);
+    statement.exec();
+    numWrites_++;
+}
+
+void indiekey::SqliteActivationStore::saveActivations (const std::vector<Activation>& activations, juce::Time now)
+{
+    std::lock_guard lock (writeMutex_);
+    auto& database = *database_;
+
+    SQLite::Transaction transaction (database);
+    SQLite::Statement statement (database, kSaveActivationQuery);
+
+    for (const auto& activation : activations)
+    {
+        bindActivation (statement, activation, now);
+        statement.exec();
+        statement.reset();
+    }
+
+    transaction.commit();
+    numWrites_++;
+}
+
+void indiekey::SqliteActivationStore::deleteActivation (const indiekey::Activation::Hash& activationHash)
+{
+    std::lock_guard lock (writeMutex_);
+    auto& database = *database_;
+
+    SQLite::Statement statement (database, "DELETE FROM activations WHERE hash = ?");
+    statement.bind (1, activationHash.data(), static_cast<int> (activationHash.size()));
+    statement.exec();
+    numWrites_++;
+}
+
+static std::vector<uint8_t> toBlobVector (const SQLite::Column& column)
+{
+    if (!column.isBlob())
+        return {};
+    auto size = column.getBytes();
+    auto data = static_cast<const uint8_t*> (column.getBlob());
+    return { data, data + size };
+}
+
+[[maybe_unused]] static juce::Time toTime (const SQLite::Column& column)
+{
+    return juce::Time (column);
+}
+
+static std::optional<juce::Time> toOptionalTime (const SQLite::Column& column)
+{
+    return column.isNull() ? std::optional<juce::Time> {} : std::optional<juce::Time> { column };
+}
+
+static std::optional<juce::RelativeTime> toOptionalRelativeTime (const SQLite::Column& column)
+{
+    return column.isNull() ? std::optional<juce::RelativeTime> {}
+                           : juce::RelativeTime::milliseconds (column.getInt64());
+}
+
+namespace
+{
+
+indiekey::Activation getActivationFromQuery (SQLite::Statement& query)
+{
+    return { toBlobVector (query.getColumn ("hash")),
+             query.getColumn ("product_uid").getString(),
+             toBlobVector (query.getColumn ("machine_uid")),
+             toOptionalTime (query.getColumn ("expires_at")),
+             toOptionalTime (query.getColumn ("license_expires_at")),
+             indiekey::License::typeFromString (query.getColumn ("license_type")),
+             toBlobVector (query.getColumn ("signature")),
+             toOptionalRelativeTime (query.getColumn ("refresh_interval")) };
+}
+} // namespace
+
+std::vector<indiekey::ActivationStore::Record> indiekey::SqliteActivationStore::getRecords (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return read ([&] (SQLite::Database& database) {
+        SQLite::Statement query (
+            database,
+            R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature,
+                      refresh_interval, last_updated_at
+                 FROM activations
+                WHERE product_uid = ? AND machine_uid = ?
+                ORDER BY id
+            )");
+
+        query.bind (1, productUid);
+        query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
+
+        std::vector<Record> records;
+
+        while (query.executeStep())
+            records.push_back ({ getActivationFromQuery (query), query.getColumn ("last_updated_at").getInt64() });
+
+        return records;
+    });
+}
+
+juce::int64 indiekey::SqliteActivationStore::getDataVersion()
+{
+    // PRAGMA data_version changes when another connection commits. That includes the read-write connection of this
+    // store, except when the database lives in memory and there's only one connection, hence the local count. Both
+    // only increase, so their sum changes whenever either does.
+    return numWrites_ + read ([] (SQLite::Database& database) {
+               return database.execAndGet ("PRAGMA data_version").getInt64();
+           });
+}
+
+std::vector<indiekey::Activation> indiekey::SqliteActivationStore::getActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return read ([&] (SQLite::Database& database) {
+        SQLite::Statement query (
+            database,
+            R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature,
+                      refresh_interval
+                 FROM activations
+                WHERE product_uid = ? AND machine_uid = ?
+                ORDER BY id
+            )");
+
+        query.bind (1, productUid);
+        query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
+
+        std::vector<Activation> activations;
+
+        while (query.executeStep())
+            activations.emplace_back (getActivationFromQuery (query));
+
+        return activations;
+    });
+}
+
+std::optional<indiekey::Activation> indiekey::SqliteActivationStore::getMostValuableActivation (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    juce::Time now)
+{
+    return read ([&] (SQLite::Database& database) -> std::optional<Activation> {
+        // Note: this ordering must match Activation::isMoreValuableThan, ties are resolved in insertion order.
+        SQLite::Statement query (
+            database,
+            R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature,
+                      refresh_interval
+                 FROM activations
+                WHERE product_uid = :product_uid AND machine_uid = :machine_uid
+                ORDER BY (expires_at IS NOT NULL AND expires_at < :now) OR
+                         (license_expires_at IS NOT NULL AND license_expires_at < :now),
+                         license_expires_at IS NULL DESC,
+                         license_expires_at DESC,
+                         expires_at IS NULL,
+                         expires_at DESC,
+                         CASE license_type
+                             WHEN 'Perpetual' THEN 5
+                             WHEN 'Subscription' THEN 4
+                             WHEN 'Trial' THEN 3
+                             WHEN 'Beta' THEN 2
+                             WHEN 'Alpha' THEN 1
+                             ELSE 0
+                         END DESC,
+                         id
+                LIMIT 1
+            )");
+
+        query.bind (":product_uid", productUid);
+        query.bind (":machine_uid", machineUid.data(), static_cast<int> (machineUid.size()));
+        query.bind (":now", now.toMilliseconds());
+
+        if (!query.executeStep())
+            return std::nullopt;
+
+        return getActivationFromQuery (query);
+    });
+}
+
+indiekey::ActivationStore::TrialSummary indiekey::SqliteActivationStore::getTrialSummary (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    juce::Time now)
+{
+    return read ([&] (SQLite::Database& database) {
+        SQLite::Statement query (
+            database,
+            R"(SELECT COUNT(*),
+                      COALESCE(SUM(NOT ((expires_at IS NOT NULL AND expires_at < :now) OR
+                                        (license_expires_at IS NOT NULL AND license_expires_at < :now))), 0)
+                 FROM activations
+                WHERE product_uid = :product_uid AND machine_uid = :machine_uid AND license_type = :license_type
+            )");
+
+        query.bind (":product_uid", productUid);
+        query.bind (":machine_uid", machineUid.data(), static_cast<int> (machineUid.size()));
+        query.bind (":license_type", License::typeToString (License::Type::Trial));
+        query.bind (":now", now.toMilliseconds());
+
+        TrialSummary summary;
+
+        if (query.executeStep())
+        {
+            summary.numTrials = query.getColumn (0).getInt();
+            summary.numActiveTrials = query.getColumn (1).getInt();
+        }
+
+        return summary;
+    });
+}
+
+std::vector<indiekey::Activation> indiekey::SqliteActivationStore::getTrialActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return read ([&] (SQLite::Database& database) {
+        SQLite::Statement query (
+            database,
+            R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature,
+                      refresh_interval
+                 FROM activations
+                WHERE product_uid = ? AND machine_uid = ? AND license_type = ?
+                ORDER BY id
+            )");
+
+        query.bind (1, productUid);
+        query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
+        query.bind (3, License::typeToString (License::Type::Trial));
+
+        std::vector<Activation> activations;
+
+        while (query.executeStep())
+            activations.emplace_back (getActivationFromQuery (query));
+
+        return activations;
+    });
+}
+
+int indiekey::SqliteActivationStore::deleteAllActivations (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    std::lock_guard lock (writeMutex_);
+    auto& database = *database_;
+
+    SQLite::Statement query (
+        database,
+        R"(DELETE FROM activations
+           WHERE product_uid = ? AND machine_uid = ?;
+        )");
+
+    query.bind (1, productUid);
+    query.bind (2, machineUid.data(), static_cast<int> (machineUid.size()));
+    auto numDeleted = query.exec();
+    numWrites_++;
+    return numDeleted;
+}
+
+std::vector<indiekey::Activation> indiekey::SqliteActivationStore::getActivationsWhichNeedUpdate (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid,
+    bool getAllActivations,
+    juce::Time now)
+{
+    return read ([&] (SQLite::Database& database) {
+        // Each activation is refreshed at the interval given by the server, or the default interval. The interval since
+        // the last update is shortened by a deterministic per-machine jitter, to spread the load on the server.
+        SQLite::Statement query (
+            database,
+            R"(SELECT hash, product_uid, machine_uid, expires_at, license_expires_at, license_type, signature,
+                      refresh_interval
+                 FROM activations
+                WHERE product_uid = :product_uid AND machine_uid = :machine_uid AND (
+                          expires_at < :now + COALESCE(refresh_interval, :default_interval) OR
+                          last_updated_at < :now - COALESCE(refresh_interval, :default_interval) * :jitter_factor OR
+                          :get_all)
+            )");
+
+        // Note: we don't have to test for license_expires_at because expires_at will (should) never outlast
+        // license_expires_at.
+
+        query.bind (":product_uid", productUid);
+        query.bind (":machine_uid", machineUid.data(), static_cast<int> (machineUid.size()));
+        query.bind (":now", now.toMilliseconds());
+        query.bind (":default_interval", juce::RelativeTime::hours (kDefaultRefreshIntervalHours).inMilliseconds());
+        query.bind (":jitter_factor", getRefreshJitterFactor (machineUid));
+        query.bind (":get_all", getAllActivations);
+
+        std::vector<Activation> activations;
+
+        while (query.executeStep())
+            activations.emplace_back (getActivationFromQuery (query));
+
+        return activations;
+    });
+}
+
+std::optional<juce::Time> indiekey::SqliteActivationStore::getNextUpdateTime (
+    const std::string& productUid,
+    const std::vector<uint8_t>& machineUid)
+{
+    return read ([&] (SQLite::Database& database) -> std::optional<juce::Time> {
+        // An activation needs an update once it is about to expire or when it wasn't updated for a while, see
+        // getActivationsWhichNeedUpdate. The expiry only brings the update forward when the last update was before
+        // that point. An activation which the server didn't extend (for example a lapsed subscription) would otherwise
+        // be due again right after every update, so it's updated once more when it expires and then at the interval.
+        SQLite::Statement query (
+            database,
+            R"(SELECT CAST(MIN(CASE
+                                   WHEN expires_at IS NULL OR expires_at <= last_updated_at
+                                       THEN last_updated_at + interval * :jitter_factor
+                                   WHEN expires_at - interval > last_updated_at
+                                       THEN MIN(expires_at - interval, last_updated_at + interval * :jitter_factor)
+                                   ELSE MIN(expires_at, last_updated_at + interval * :jitter_factor)
+                               END) AS INTEGER)
+                 FROM (SELECT expires_at, last_updated_at, COALESCE(refresh_interval, :default_interval) AS interval
+                         FROM activations
+                        WHERE product_uid = :product_uid AND machine_uid = :machine_uid)
+            )");
+
+        query.bind (":product_uid", productUid);
+        query.bind (":machine_uid", machineUid.data(), static_cast<int> (machineUid.size()));
+        query.bind (":default_interval", juce::RelativeTime::hours (kDefaultRefreshIntervalHours).inMilliseconds());
+        query.bind (":jitter_factor", getRefreshJitterFactor (machineUid));
+
+        if (!query.executeStep())
+            return std::nullopt;
+
+        return toOptionalTime (query.getColumn (0));
+    });
+}
+
+indiekey::ActivationStore::MaintenanceReport
+indiekey::SqliteActivationStore::runMaintenance (juce::Time now, bool force)
+{
+    std::lock_guard lock (writeMutex_);
+    auto& database = *database_;
+
+    MaintenanceReport report;
+
+    if (!force)
+    {
+        SQLite::Statement query (database, "SELECT value FROM metadata WHERE key = 'last_maintenance_at'");
+
+        if (query.executeStep() && !query.getColumn (0).isNull() &&
+            now - juce::Time (query.getColumn (0).getInt64()) < juce::RelativeTime::days (kMaintenanceIntervalDays))
+            return report;
+    }
+
+    auto getDatabaseSize = [&database] {
+        return database.execAndGet ("PRAGMA page_count").getInt64() *
+               database.execAndGet ("PRAGMA page_size").getInt64();
+    };
+
+    auto sizeBefore = getDatabaseSize();
+
+    {
+        SQLite::Transaction transaction (database);
+
+        // Removes activations which expired longer than the retention window ago. The latest trial of each product and
+        // machine is kept, so that getTrialSummary keeps reporting an expired trial instead of an available one.
+        SQLite::Statement prune (
+            database,
+            R"(DELETE FROM activations
+                WHERE ((expires_at IS NOT NULL AND expires_at < :cutoff) OR
+                       (license_expires_at IS NOT NULL AND license_expires_at < :cutoff))
+                  AND NOT (license_type = :trial AND
+                           id = (SELECT MAX(trials.id)
+                                   FROM activations AS trials
+                                  WHERE trials.product_uid = activations.product_uid AND
+                                        trials.machine_uid = activations.machine_uid AND
+                                        trials.license_type = :trial))
+            )");
+
+        prune.bind (":cutoff", (now - juce::RelativeTime::days (kPruneRetentionDays)).toMilliseconds());
+        prune.bind (":trial", License::typeToString (License::Type::Trial));
+        report.numRowsPruned = prune.exec();
+
+        SQLite::Statement saveTime (
+            database,
+            "INSERT OR REPLACE INTO metadata(key, value) VALUES ('last_maintenance_at', :now)");
+        saveTime.bind (":now", now.toMilliseconds());
+        saveTime.exec();
+
+        transaction.commit();
+    }
+
+    // Databases created before auto_vacuum was enabled need a full vacuum once to convert them.
+    if (database.execAndGet ("PRAGMA auto_vacuum").getInt() != 2)
+    {
+        database.exec ("PRAGMA auto_vacuum = INCREMENTAL");
+        database.exec ("VACUUM");
+    }
+    else
+    {
+        database.exec ("PRAGMA incremental_vacuum");
+    }
+
+    database.exec ("PRAGMA optimize");
+
+    numWrites_++;
+    report.ran = true;
+    report.numBytesReclaimed = std::max<juce::int64> (0, sizeBefore - getDatabaseSize());
+
+    return report;
+}
+
+std::optional<juce::int64> indiekey::SqliteActivationStore::getMetadata (const std::string& key)
+{
+    return read ([&key] (SQLite::Database& database) -> std::optional<juce::int64> {
+        SQLite::Statement query (database, "SELECT value FROM metadata WHERE key = ?");
+        query.bind (1, key);
+
+        if (!query.executeStep() || query.getColumn (0).isNull())
+            return std::nullopt;
+
+        return query.getColumn (0).getInt64();
+    });
+}
+
+void indiekey::SqliteActivationStore::setMetadata (const std::string& key, juce::int64 value)
+{
+    std::lock_guard lock (writeMutex_);
+
+    SQLite::Statement statement (*database_, "INSERT OR REPLACE INTO metadata(key, value) VALUES (?, ?)");
+    statement.bind (1, key);
+    statement.bind (2, value);
+    statement.exec();
+
+    // Not counted in numWrites_: metadata isn't part of the cached query results which the data version validates.
+}
+
+void indiekey::SqliteActivationStore::updateMetadata (
+    const std::vector<std::string>& keys,
+    const std::function<Metadata (const Metadata&)>& update)
+{
+    std::lock_guard lock (writeMutex_);
+
+    // Immediate, so that the values can't change between reading and writing them.
+    SQLite::Transaction transaction (*database_, SQLite::TransactionBehavior::IMMEDIATE);
+
+    Metadata stored;
+    SQLite::Statement query (*database_, "SELECT value FROM metadata WHERE key = ?");
+
+    for (const auto& key : keys)
+    {
+        query.bind (1, key);
+
+        if (query.executeStep() && !query.getColumn (0).isNull())
+            stored[key] = query.getColumn (0).getInt64();
+
+        query.reset();
+    }
+
+    auto values = update (stored);
+
+    if (values.empty())
+        return;
+
+    SQLite::Statement statement (*database_, "INSERT OR REPLACE INTO metadata(key, value) VALUES (?, ?)");
+
+    for (const auto& [key, value] : values)
+    {
+        statement.bind (1, key);
+        statement.bind (2, value);
+        statement.exec();
+        statement.reset();
+    }
+
+    transaction.commit();
+}
+
+size_t indiekey::SqliteActivationStore::getMemoryUsage()
+{
+    auto getConnectionMemoryUsage = [] (SQLite::Database* database) -> size_t {
+        if (database == nullptr)
+            return 0;
+
+        size_t usage = sizeof (*database);
+
+        for (auto op : { SQLITE_DBSTATUS_CACHE_USED, SQLITE_DBSTATUS_SCHEMA_USED, SQLITE_DBSTATUS_STMT_USED })
+        {
+            int current = 0;
+            int highwater = 0;
+            if (sqlite3_db_status (database->getHandle(), op, &current, &highwater, 0) == SQLITE_OK)
+                usage += static_cast<size_t> (current);
+        }
+
+        return usage;
+    };
+
+    return sizeof (*this) + getConnectionMemoryUsage (database_.get()) +
+           getConnectionMemoryUsage (readOnlyDatabase_.get());
+}
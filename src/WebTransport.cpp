@@ -0,0 +1,43 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include "indiekey/WebTransport.h"
+
+indiekey::RestClient::Response indiekey::WebTransport::send (
+    const RestClient::Request& request,
+    CancellationToken* cancellationToken)
+{
+    // A WebInputStream (rather than URL::createInputStream) can be cancelled from another thread, which aborts a
+    // connection attempt or a blocking read right away.
+    juce::WebInputStream stream (request.url, request.usePost);
+    stream.withExtraHeaders (request.extraHeaders)
+        .withConnectionTimeout (request.connectionTimeoutMs)
+        .withNumRedirectsToFollow (0);
+
+    CancellationToken::Registration registration;
+
+    if (cancellationToken != nullptr)
+    {
+        registration = cancellationToken->onCancel ([&stream] {
+            stream.cancel();
+        });
+    }
+
+    auto connected = stream.connect (nullptr);
+
+    RestClient::Response response;
+    response.statusCode = stream.getStatusCode();
+
+    if (connected)
+        response.body = stream.readEntireStreamAsString();
+
+    if (cancellationToken != nullptr)
+        cancellationToken->throwIfCancelled(); // A cancelled transfer might look like a (partial) success.
+
+    if (!connected)
+        throw std::runtime_error ("Failed to reach activation server");
+
+    return response;
+}
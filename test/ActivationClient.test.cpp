@@ -0,0 +1,587 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include "ActivationClientTest.h"
+#include "StandInServer.h"
+#include "indiekey/FaultInjectingTransport.h"
+#include "indiekey/SharedStatusCache.h"
+#include "indiekey/WebTransport.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+class CountingSubscriber : public indiekey::ActivationClient::Subscriber
+{
+public:
+    int numCalls = 0;
+    indiekey::Activation::Hash lastHash;
+
+    void onActivationsUpdated (const indiekey::Activation* mostValuableActivation) override
+    {
+        numCalls++;
+        lastHash = mostValuableActivation != nullptr ? mostValuableActivation->getHash() : indiekey::Activation::Hash {};
+    }
+};
+
+} // namespace
+
+using indiekey::test::ActivationClientTest;
+
+TEST_F (ActivationClientTest, SubscribersAreNotifiedOncePerChange)
+{
+    juce::Random random (1);
+
+    indiekey::ActivationClient client;
+    client.setProductData (productData, inMemory());
+
+    std::vector<CountingSubscriber> subscribers (10);
+    for (auto& subscriber : subscribers)
+        client.addListener (&subscriber);
+
+    for (int i = 0; i < 1000; ++i)
+        client.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+
+    runMessageLoop();
+
+    for (auto& subscriber : subscribers)
+    {
+        ASSERT_EQ (subscriber.numCalls, 1); // Initial state only.
+        ASSERT_TRUE (subscriber.lastHash.empty());
+    }
+
+    auto activation = signer.sign (
+        indiekey::test::ActivationSigner::randomBytes (random, 32),
+        productData.productUid,
+        machineUid,
+        std::nullopt,
+        std::nullopt,
+        indiekey::License::Type::Perpetual);
+
+    // Perpetual and just saved, so no update is required and the server is not contacted.
+    client.installActivation (indiekey::Activation (activation));
+
+    for (int i = 0; i < 1000; ++i)
+        client.validate (indiekey::ActivationClient::ValidationStrategy::Online);
+
+    runMessageLoop();
+
+    for (auto& subscriber : subscribers)
+    {
+        ASSERT_EQ (subscriber.numCalls, 2);
+        ASSERT_EQ (subscriber.lastHash, activation.getHash());
+    }
+
+    CountingSubscriber lateSubscriber;
+    client.addListener (&lateSubscriber);
+
+    runMessageLoop();
+
+    ASSERT_EQ (lateSubscriber.numCalls, 1);
+    ASSERT_EQ (lateSubscriber.lastHash, activation.getHash());
+
+    for (auto& subscriber : subscribers)
+        ASSERT_EQ (subscriber.numCalls, 2);
+
+    for (auto& subscriber : subscribers)
+        client.removeListener (&subscriber);
+    client.removeListener (&lateSubscriber);
+}
+
+TEST_F (ActivationClientTest, InstallActivationBundle)
+{
+    juce::Random random (2);
+
+    auto makeProductData = [this] (const std::string& productUid) {
+        auto result = productData;
+        result.productUid = productUid;
+        return result;
+    };
+
+    auto makeActivation = [&] (const std::string& productUid) {
+        return signer.sign (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productUid,
+            machineUid,
+            std::nullopt,
+            std::nullopt,
+            indiekey::License::Type::Perpetual);
+    };
+
+    auto productA = makeProductData ("product-a");
+    auto productB = makeProductData ("product-b");
+    std::vector<indiekey::Activation> activations { makeActivation ("product-a"),
+                                                    makeActivation ("product-b"),
+                                                    makeActivation ("product-unknown") };
+
+    juce::TemporaryFile bundleFile (".json");
+    ASSERT_TRUE (bundleFile.getFile().replaceWithText (nlohmann::json (activations).dump()));
+
+    {
+        indiekey::ActivationClient client;
+        client.setProductData (productA, inMemory());
+
+        ASSERT_EQ (client.installActivationBundle (bundleFile.getFile(), { productB }), 2);
+        ASSERT_NE (client.getLoadedActivation(), nullptr);
+        ASSERT_EQ (client.getLoadedActivation()->getHash(), activations[0].getHash());
+    }
+
+    // A single invalid activation fails the whole bundle.
+    auto tampered = nlohmann::json (activations);
+    tampered[1]["product_uid"] = "product-a";
+    ASSERT_TRUE (bundleFile.getFile().replaceWithText (tampered.dump()));
+
+    {
+        indiekey::ActivationClient client;
+        client.setProductData (productA, inMemory());
+
+        ASSERT_THROW (client.installActivationBundle (bundleFile.getFile()), std::runtime_error);
+
+        client.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+        ASSERT_EQ (client.getLoadedActivation(), nullptr);
+    }
+
+    // Files which are not a bundle at all are rejected with an error of the client, not one of the JSON parser.
+    indiekey::ActivationClient client;
+    client.setProductData (productA, inMemory());
+
+    for (const auto* text : { R"({"activations":[]})",
+                              R"([{"product_uid":"product-a"}])",
+                              R"([1, 2, 3])",
+                              R"([[]])",
+                              R"("bundle")",
+                              R"([{"hash":)" })
+    {
+        ASSERT_TRUE (bundleFile.getFile().replaceWithText (text));
+        ASSERT_THROW (client.installActivationBundle (bundleFile.getFile()), std::runtime_error) << text;
+    }
+
+    client.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+    ASSERT_EQ (client.getLoadedActivation(), nullptr);
+}
+
+TEST_F (ActivationClientTest, InstallActivationBundleWhileValidating)
+{
+    juce::Random random (9);
+
+    std::vector<indiekey::Activation> activations;
+    for (int i = 0; i < 4; ++i)
+    {
+        activations.push_back (signer.sign (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productData.productUid,
+            machineUid,
+            std::nullopt,
+            std::nullopt,
+            indiekey::License::Type::Perpetual));
+    }
+
+    juce::TemporaryFile bundleFile (".json");
+    ASSERT_TRUE (bundleFile.getFile().replaceWithText (nlohmann::json (activations).dump()));
+
+    indiekey::ActivationClient client;
+    client.setProductData (productData, inMemory());
+
+    // The install validates from within its task on the work queue. That validation must run right away: merged into
+    // one of the validations waiting behind the install it would wait for itself.
+    std::atomic<bool> isInstalling { true };
+    std::thread validator ([&] {
+        while (isInstalling)
+            client.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+    });
+
+    for (int i = 0; i < 20; ++i)
+        EXPECT_EQ (client.installActivationBundle (bundleFile.getFile()), 4);
+
+    isInstalling = false;
+    validator.join();
+
+    ASSERT_NE (client.getLoadedActivation(), nullptr);
+    ASSERT_EQ (client.getLoadedActivation()->getStatus(), indiekey::Activation::Status::Valid);
+}
+
+TEST_F (ActivationClientTest, InstallActivationFileDoesNotContactServer)
+{
+    juce::Random random (3);
+
+    auto activation = signer.sign (
+        indiekey::test::ActivationSigner::randomBytes (random, 32),
+        productData.productUid,
+        machineUid,
+        juce::Time::getCurrentTime() + juce::RelativeTime::days (30),
+        std::nullopt,
+        indiekey::License::Type::Subscription);
+
+    juce::TemporaryFile responseFile (".json");
+    ASSERT_TRUE (responseFile.getFile().replaceWithText (activation.toJson().dump()));
+
+    juce::TemporaryFile requestFile (".json");
+    ASSERT_TRUE (requestFile.getFile().replaceWithText (R"({"TrialRequest":{}})"));
+
+    // Counts the requests, none of which may be sent.
+    auto transport = std::make_shared<indiekey::FaultInjectingTransport> (
+        std::make_shared<indiekey::WebTransport>(),
+        indiekey::FaultInjectingTransport::Faults {});
+
+    indiekey::ActivationClient client;
+    client.setProductData (productData, inMemory());
+    client.setTransport (transport);
+
+    ASSERT_THROW (client.installActivationFile (requestFile.getFile()), std::runtime_error);
+
+    client.installActivationFile (responseFile.getFile());
+    ASSERT_NE (client.getLoadedActivation(), nullptr);
+    ASSERT_EQ (client.getLoadedActivation()->getStatus(), indiekey::Activation::Status::Valid);
+    ASSERT_EQ (transport->getCounters().numRequests, 0);
+}
+
+TEST_F (ActivationClientTest, FootprintPerAdditionalInstanceIsSmall)
+{
+    juce::Random random (4);
+
+    auto file = createDatabaseFile ("indiekey_footprint_test");
+
+    indiekey::ActivationsDatabase::Options options;
+    options.databaseFile = file;
+    options.memoryBudget.sqliteCacheSizeKiB = 64;
+
+    // Like a host which loads many instances of the same plugin.
+    constexpr size_t kNumClients = 32;
+    constexpr size_t kMaxBytesPerAdditionalClient = 8 * 1024;
+
+    {
+        std::vector<std::unique_ptr<indiekey::ActivationClient>> clients;
+        size_t firstFootprint = 0;
+
+        for (size_t i = 0; i < kNumClients; ++i)
+        {
+            auto& client = clients.emplace_back (std::make_unique<indiekey::ActivationClient>());
+            client->setProductData (productData, options);
+
+            if (i == 0)
+            {
+                client->installActivation (signer.sign (
+                    indiekey::test::ActivationSigner::randomBytes (random, 32),
+                    productData.productUid,
+                    machineUid,
+                    juce::Time::getCurrentTime() + juce::RelativeTime::days (30),
+                    std::nullopt,
+                    indiekey::License::Type::Subscription));
+            }
+
+            client->validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+            ASSERT_NE (client->getLoadedActivation(), nullptr);
+
+            if (i == 0)
+                firstFootprint = client->getMemoryFootprint().getTotal();
+        }
+
+        size_t totalFootprint = 0;
+        for (auto& client : clients)
+            totalFootprint += client->getMemoryFootprint().getTotal();
+
+        ASSERT_GT (firstFootprint, 0);
+        ASSERT_LT ((totalFootprint - firstFootprint) / (kNumClients - 1), kMaxBytesPerAdditionalClient);
+    }
+}
+
+TEST_F (ActivationClientTest, UpdatesAreSentByHashAndDeviceInfoOnlyOnce)
+{
+    juce::Random random (5);
+    indiekey::test::StandInServer server;
+    productData.verifyingKey = server.getSigner().getVerifyingKey();
+    productData.primaryPublicServerAddress = server.getAddress();
+
+    {
+        indiekey::ActivationClient client;
+        client.setProductData (productData, inMemory());
+        client.setDeviceInfo (std::string ("Test device"));
+
+        client.activate ("someone@example.com", "LICENSE");
+        client.startTrial ("someone@example.com");
+        ASSERT_EQ (server.getNumRequestsWithDeviceInfo(), 1);
+
+        // The server attaches the device info to the activations of a product, so another product needs it as well.
+        auto otherProductData = productData;
+        otherProductData.productUid = "other product";
+
+        indiekey::ActivationClient otherClient;
+        otherClient.setProductData (otherProductData, inMemory());
+        otherClient.setDeviceInfo (std::string ("Test device"));
+        otherClient.activate ("someone@example.com", "LICENSE");
+        ASSERT_EQ (server.getNumRequestsWithDeviceInfo(), 2);
+
+        client.installActivation (server.issue (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productData.productUid,
+            machineUid,
+            indiekey::License::Type::Perpetual,
+            juce::Time::getCurrentTime()));
+
+        client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline);
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH), 1);
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS), 0);
+        ASSERT_NE (client.getLoadedActivation(), nullptr);
+        ASSERT_EQ (client.getLoadedActivation()->getStatus(), indiekey::Activation::Status::Valid);
+    }
+}
+
+TEST_F (ActivationClientTest, ServerWithoutUpdatesByHashIsRemembered)
+{
+    juce::Random random (10);
+    indiekey::test::StandInServer server;
+    server.setSupportsUpdatesByHash (false);
+    productData.verifyingKey = server.getSigner().getVerifyingKey();
+    productData.primaryPublicServerAddress = server.getAddress();
+
+    auto file = createDatabaseFile ("indiekey_by_hash_test");
+
+    // Every session, like a host which is started again.
+    for (int session = 0; session < 3; ++session)
+    {
+        indiekey::ActivationClient client;
+        client.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+
+        if (session == 0)
+        {
+            client.installActivation (server.issue (
+                indiekey::test::ActivationSigner::randomBytes (random, 32),
+                productData.productUid,
+                machineUid,
+                indiekey::License::Type::Perpetual,
+                juce::Time::getCurrentTime()));
+        }
+
+        client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline);
+        ASSERT_NE (client.getLoadedActivation(), nullptr);
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS), session + 1);
+    }
+
+    ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH), 1);
+}
+
+TEST_F (ActivationClientTest, ForceOnlineBeyondRequestBudgetValidatesLocally)
+{
+    juce::Random random (6);
+    indiekey::test::StandInServer server;
+    productData.verifyingKey = server.getSigner().getVerifyingKey();
+    productData.primaryPublicServerAddress = server.getAddress();
+
+    auto file = createDatabaseFile ("indiekey_budget_test");
+
+    {
+        indiekey::ActivationClient client;
+        client.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+
+        juce::SharedResourcePointer<indiekey::RequestBudget> budget;
+        budget->setPolicy ({ 3, juce::RelativeTime::hours (1) });
+
+        client.installActivation (server.issue (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productData.productUid,
+            machineUid,
+            indiekey::License::Type::Perpetual,
+            juce::Time::getCurrentTime()));
+
+        // Like a host which validates online every time an editor opens.
+        for (int i = 0; i < 10; ++i)
+        {
+            client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline);
+            ASSERT_NE (client.getLoadedActivation(), nullptr);
+            ASSERT_EQ (client.getLoadedActivation()->getStatus(), indiekey::Activation::Status::Valid);
+        }
+
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH), 3);
+        ASSERT_EQ (client.getNumThrottledRequests(), 7);
+        ASSERT_EQ (budget->getCounters().numGranted, 3);
+        ASSERT_EQ (budget->getCounters().numThrottled, 7);
+    }
+
+    // A restarted host finds the budget it left behind, not a full one.
+    {
+        indiekey::ActivationClient client;
+        client.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+        client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline);
+
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH), 3);
+        ASSERT_EQ (client.getNumThrottledRequests(), 1);
+        ASSERT_NE (client.getLoadedActivation(), nullptr);
+    }
+}
+
+TEST_F (ActivationClientTest, UnreachableServerIsSkippedUntilBackgroundProbeReachesIt)
+{
+    juce::Random random (7);
+    indiekey::test::StandInServer server;
+    productData.verifyingKey = server.getSigner().getVerifyingKey();
+    productData.primaryPublicServerAddress = server.getAddress();
+
+    auto file = createDatabaseFile ("indiekey_circuit_test");
+
+    // Offline: every connection is refused.
+    indiekey::FaultInjectingTransport::Faults offline;
+    offline.refusalProbability = 1.0;
+
+    auto transport = std::make_shared<indiekey::FaultInjectingTransport> (
+        std::make_shared<indiekey::WebTransport>(),
+        offline);
+
+    // Time only moves when the test says so, the probes are scheduled against this clock.
+    indiekey::ManualClock clock;
+
+    {
+        juce::SharedResourcePointer<indiekey::CircuitBreaker> circuitBreaker;
+        circuitBreaker->setPolicy ({ 3, juce::RelativeTime::minutes (1), juce::RelativeTime::minutes (10) });
+
+        indiekey::ActivationClient client;
+        client.setClock (clock);
+        client.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+        client.setTransport (transport);
+
+        // Expires within the refresh interval, so online validations want to update it.
+        client.installActivation (server.issue (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productData.productUid,
+            machineUid,
+            indiekey::License::Type::Perpetual,
+            clock.now() - juce::RelativeTime::hours (13 * 24 + 12)));
+
+        // A background refresh might fail as well, but the circuit opens only once.
+        for (int i = 0; i < 3; ++i)
+            ASSERT_ANY_THROW (client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline));
+
+        ASSERT_EQ (circuitBreaker->getCounters().numOpened, 1);
+
+        // The open circuit skips the request instead of waiting for the connection to fail.
+        auto numRequests = transport->getCounters().numRequests;
+        client.validate (indiekey::ActivationClient::ValidationStrategy::Online);
+        ASSERT_EQ (transport->getCounters().numRequests, numRequests);
+        ASSERT_NE (client.getLoadedActivation(), nullptr);
+        ASSERT_EQ (circuitBreaker->getCounters().numShortCircuited, 1);
+
+        // Forced validations bypass the open circuit.
+        ASSERT_ANY_THROW (client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline));
+        ASSERT_EQ (circuitBreaker->getCounters().numShortCircuited, 1);
+    }
+
+    // After a restart the open circuit is still known, and the server is back.
+    {
+        juce::SharedResourcePointer<indiekey::CircuitBreaker> circuitBreaker;
+
+        indiekey::ActivationClient client;
+        client.setClock (clock);
+        client.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+        client.validate (indiekey::ActivationClient::ValidationStrategy::Online);
+
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH), 0);
+        ASSERT_EQ (circuitBreaker->getCounters().numShortCircuited, 1);
+        ASSERT_EQ (server.getNumRequests ("/ping"), 0);
+
+        // By now the activation expired and a probe is due. The validation waits for the background refresh, which
+        // probes the server, closes the circuit and renews the activation.
+        clock.advance (juce::RelativeTime::hours (13));
+        client.validate (
+            indiekey::ActivationClient::ValidationStrategy::StaleWhileRevalidate,
+            juce::RelativeTime::seconds (30));
+
+        auto state = circuitBreaker->getState (server.getAddress(), clock.now());
+        ASSERT_EQ (state, indiekey::CircuitBreaker::State::Closed);
+        ASSERT_EQ (server.getNumRequests ("/ping"), 1);
+        ASSERT_EQ (server.getNumRequests (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH), 1);
+        ASSERT_NE (client.getLoadedActivation(), nullptr);
+        ASSERT_EQ (client.getLoadedActivation()->getStatus(), indiekey::Activation::Status::Valid);
+    }
+}
+
+TEST_F (ActivationClientTest, LocalValidationsTakeOverTheSharedStatus)
+{
+    juce::Random random (8);
+
+    auto file = createDatabaseFile ("indiekey_shared_status_test");
+    auto region = createSharedStatusRegion(); // So that other test runs don't publish to or read from it.
+
+    {
+        // Stands in for the processes which read the published status, for example a plugin scanner.
+        indiekey::SharedStatusCache cache (file, region);
+        ASSERT_TRUE (cache.isAvailable());
+
+        auto lookUp = [&] (juce::Time time) {
+            return cache.lookup (productData.productUid, machineUid, productData.verifyingKey, time);
+        };
+
+        auto now = juce::Time::getCurrentTime();
+        ASSERT_FALSE (lookUp (now).entry.has_value());
+
+        indiekey::ActivationClient client;
+        client.setSharedStatusRegion (region);
+        client.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+        client.installActivation (signer.sign (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productData.productUid,
+            machineUid,
+            now + juce::RelativeTime::minutes (30),
+            std::nullopt,
+            indiekey::License::Type::Subscription));
+
+        auto lookup = lookUp (now);
+        ASSERT_TRUE (lookup.entry.has_value());
+        ASSERT_TRUE (lookup.entry->activation.has_value());
+        ASSERT_EQ (lookup.entry->activation->getHash(), client.getLoadedActivation()->getHash());
+        ASSERT_EQ (lookup.entry->activation->getStatus(), indiekey::Activation::Status::Valid);
+
+        // Expiry is checked by the reader, not by the process which published the status.
+        auto later = now + juce::RelativeTime::minutes (31);
+        ASSERT_FALSE (lookUp (later).entry.has_value());
+
+        indiekey::ActivationClient otherClient;
+        otherClient.setSharedStatusRegion (region);
+        otherClient.setProductData (productData, indiekey::ActivationsDatabase::Options { file });
+        otherClient.validate (indiekey::ActivationClient::ValidationStrategy::LocalValidOnly);
+        ASSERT_NE (otherClient.getLoadedActivation(), nullptr);
+        ASSERT_EQ (otherClient.getLoadedActivation()->getHash(), client.getLoadedActivation()->getHash());
+
+        // Changing the activations invalidates the status, and a result read before that is not published anymore.
+        auto staleLookup = lookUp (now);
+        ASSERT_EQ (client.destroyAllLocalActivations(), 1);
+        ASSERT_FALSE (lookUp (now).entry.has_value());
+        ASSERT_FALSE (cache.publish (
+            productData.productUid,
+            machineUid,
+            staleLookup.version,
+            otherClient.getLoadedActivation().get(),
+            std::nullopt,
+            now));
+
+        otherClient.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+        ASSERT_EQ (otherClient.getLoadedActivation(), nullptr);
+
+        lookup = lookUp (now);
+        ASSERT_TRUE (lookup.entry.has_value());
+        ASSERT_FALSE (lookup.entry->activation.has_value());
+
+        // Anyone who can read the key file can write a slot, but not sign an activation.
+        indiekey::test::ActivationSigner forger;
+        auto forged = forger.sign (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            productData.productUid,
+            machineUid,
+            std::nullopt,
+            std::nullopt,
+            indiekey::License::Type::Perpetual);
+        ASSERT_EQ (
+            forged.validate (productData.productUid, machineUid, forger.getVerifyingKey(), now),
+            indiekey::Activation::Status::Valid);
+
+        ASSERT_TRUE (cache.publish (productData.productUid, machineUid, lookup.version, &forged, std::nullopt, now));
+        ASSERT_FALSE (lookUp (now).entry.has_value());
+
+        otherClient.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+        ASSERT_EQ (otherClient.getLoadedActivation(), nullptr);
+    }
+}
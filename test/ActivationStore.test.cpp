@@ -0,0 +1,462 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "ActivationSigner.h"
+#include "indiekey/FileActivationStore.h"
+#include "indiekey/MemoryActivationStore.h"
+#include "indiekey/SqliteActivationStore.h"
+
+// Conformance tests which every ActivationStore must pass. Stores are compared against SqliteActivationStore, which is
+// the reference implementation.
+
+namespace
+{
+
+const std::string kProductUid = "product";
+const std::vector<uint8_t> kMachineUid { 1, 2, 3, 4 };
+const juce::Time kNow (1700000000000);
+
+struct StoreFactory
+{
+    const char* name;
+    std::function<std::unique_ptr<indiekey::ActivationStore> (const juce::File&)> create;
+};
+
+const StoreFactory kStoreFactories[] = {
+    { "Sqlite",
+      [] (const juce::File& file) {
+          return std::make_unique<indiekey::SqliteActivationStore> (file);
+      } },
+    { "Memory",
+      [] (const juce::File&) {
+          return std::make_unique<indiekey::MemoryActivationStore>();
+      } },
+    { "File",
+      [] (const juce::File& file) {
+          return std::make_unique<indiekey::FileActivationStore> (file);
+      } },
+};
+
+std::optional<juce::Time> randomTime (juce::Random& random)
+{
+    // Offsets around now which hit expiry, refresh and retention boundaries often.
+    static const juce::int64 offsets[] = { -100 * 86400000LL, -2 * 86400000LL, -1, 0, 1, 3600000LL, 86400000LL };
+
+    if (random.nextInt (4) == 0)
+        return std::nullopt;
+
+    return juce::Time (kNow.toMilliseconds() + offsets[random.nextInt (juce::numElementsInArray (offsets))]);
+}
+
+indiekey::Activation randomActivation (juce::Random& random, const std::vector<uint8_t>& hash)
+{
+    static const indiekey::License::Type types[] = {
+        indiekey::License::Type::Perpetual,
+        indiekey::License::Type::Subscription,
+        indiekey::License::Type::Trial,
+    };
+
+    std::optional<juce::RelativeTime> refreshInterval;
+    if (random.nextBool())
+        refreshInterval = juce::RelativeTime::hours (1 + random.nextInt (48));
+
+    return { hash,
+             kProductUid,
+             random.nextInt (5) == 0 ? std::vector<uint8_t> { 9 } : kMachineUid,
+             randomTime (random),
+             randomTime (random),
+             types[random.nextInt (juce::numElementsInArray (types))],
+             indiekey::test::ActivationSigner::randomBytes (random, 64),
+             refreshInterval };
+}
+
+indiekey::Activation makeActivation (const indiekey::Activation::Hash& hash, indiekey::License::Type type)
+{
+    return { hash, kProductUid, kMachineUid, std::nullopt, std::nullopt, type, std::vector<uint8_t> (64, 0) };
+}
+
+std::vector<indiekey::Activation::Hash> hashesOf (const std::vector<indiekey::Activation>& activations)
+{
+    std::vector<indiekey::Activation::Hash> hashes;
+    for (const auto& activation : activations)
+        hashes.push_back (activation.getHash());
+    return hashes;
+}
+
+class ActivationStoreTest : public ::testing::TestWithParam<StoreFactory>
+{
+protected:
+    juce::File file_ = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                           .getNonexistentChildFile ("indiekey_store_test", ".db", false);
+
+    void TearDown() override
+    {
+        file_.deleteFile();
+    }
+
+    std::unique_ptr<indiekey::ActivationStore> createStore()
+    {
+        return GetParam().create (file_);
+    }
+};
+
+} // namespace
+
+TEST_P (ActivationStoreTest, SaveReplaceAndDelete)
+{
+    auto store = createStore();
+
+    auto a = makeActivation ({ 1 }, indiekey::License::Type::Trial);
+    auto b = makeActivation ({ 2 }, indiekey::License::Type::Perpetual);
+    indiekey::Activation c { { 3 },
+                             kProductUid,
+                             kMachineUid,
+                             kNow - juce::RelativeTime::days (1),
+                             std::nullopt,
+                             indiekey::License::Type::Trial,
+                             std::vector<uint8_t> (64, 3),
+                             juce::RelativeTime::hours (2) };
+
+    auto dataVersion = store->getDataVersion();
+    store->saveActivations ({ a, b, c }, kNow);
+    ASSERT_EQ (hashesOf (store->getActivations (kProductUid, kMachineUid)), hashesOf ({ a, b, c }));
+    ASSERT_NE (store->getDataVersion(), dataVersion);
+
+    auto records = store->getRecords (kProductUid, kMachineUid);
+    ASSERT_EQ (records.size(), 3);
+    ASSERT_EQ (records[2].activation.getHash(), c.getHash());
+    ASSERT_EQ (records[2].lastUpdatedAt, kNow.toMilliseconds());
+
+    // Replacing an activation moves it to the end.
+    store->saveActivation (a, kNow);
+    auto stored = store->getActivations (kProductUid, kMachineUid);
+    ASSERT_EQ (hashesOf (stored), hashesOf ({ b, c, a }));
+    ASSERT_EQ (stored[1].getExpiresAt(), c.getExpiresAt());
+    ASSERT_EQ (stored[1].getRefreshInterval(), juce::RelativeTime::hours (2));
+    ASSERT_EQ (stored[1].getSignature(), c.getSignature());
+
+    ASSERT_EQ (hashesOf (store->getTrialActivations (kProductUid, kMachineUid)), hashesOf ({ c, a }));
+    auto summary = store->getTrialSummary (kProductUid, kMachineUid, kNow);
+    ASSERT_EQ (summary.numTrials, 2);
+    ASSERT_EQ (summary.numActiveTrials, 1);
+
+    store->deleteActivation (b.getHash());
+    ASSERT_EQ (hashesOf (store->getActivations (kProductUid, kMachineUid)), hashesOf ({ c, a }));
+
+    ASSERT_EQ (store->deleteAllActivations (kProductUid, kMachineUid), 2);
+    ASSERT_TRUE (store->getActivations (kProductUid, kMachineUid).empty());
+    ASSERT_FALSE (store->getMostValuableActivation (kProductUid, kMachineUid, kNow).has_value());
+    ASSERT_FALSE (store->getNextUpdateTime (kProductUid, kMachineUid).has_value());
+}
+
+TEST_P (ActivationStoreTest, RandomOperationsMatchReference)
+{
+    juce::Random random (5);
+    auto store = createStore();
+    indiekey::SqliteActivationStore reference;
+
+    for (int step = 0; step < 2000; ++step)
+    {
+        const auto now = kNow + juce::RelativeTime::hours (random.nextInt (72) - 24);
+
+        switch (random.nextInt (10))
+        {
+        case 0:
+        {
+            std::vector<indiekey::Activation> activations;
+            for (int i = 0, n = random.nextInt (4); i < n; ++i)
+                activations.push_back (randomActivation (random, { static_cast<uint8_t> (random.nextInt (16)) }));
+            store->saveActivations (activations, now);
+            reference.saveActivations (activations, now);
+            break;
+        }
+        case 1:
+        {
+            indiekey::Activation::Hash hash { static_cast<uint8_t> (random.nextInt (16)) };
+            store->deleteActivation (hash);
+            reference.deleteActivation (hash);
+            break;
+        }
+        case 2:
+            if (random.nextInt (10) == 0)
+                ASSERT_EQ (
+                    store->deleteAllActivations (kProductUid, kMachineUid),
+                    reference.deleteAllActivations (kProductUid, kMachineUid));
+            break;
+        case 3:
+        {
+            auto force = random.nextBool();
+            auto report = store->runMaintenance (now, force);
+            auto expected = reference.runMaintenance (now, force);
+            ASSERT_EQ (report.ran, expected.ran) << "Step " << step;
+            ASSERT_EQ (report.numRowsPruned, expected.numRowsPruned) << "Step " << step;
+            break;
+        }
+        default:
+        {
+            auto activation = randomActivation (random, { static_cast<uint8_t> (random.nextInt (16)) });
+            store->saveActivation (activation, now);
+            reference.saveActivation (activation, now);
+            break;
+        }
+        }
+
+        ASSERT_EQ (
+            hashesOf (store->getActivations (kProductUid, kMachineUid)),
+            hashesOf (reference.getActivations (kProductUid, kMachineUid)))
+            << "Step " << step;
+
+        auto mostValuable = store->getMostValuableActivation (kProductUid, kMachineUid, now);
+        auto expectedMostValuable = reference.getMostValuableActivation (kProductUid, kMachineUid, now);
+        ASSERT_EQ (mostValuable.has_value(), expectedMostValuable.has_value()) << "Step " << step;
+        if (mostValuable.has_value())
+            ASSERT_EQ (mostValuable->getHash(), expectedMostValuable->getHash()) << "Step " << step;
+
+        auto summary = store->getTrialSummary (kProductUid, kMachineUid, now);
+        auto expectedSummary = reference.getTrialSummary (kProductUid, kMachineUid, now);
+        ASSERT_EQ (summary.numTrials, expectedSummary.numTrials) << "Step " << step;
+        ASSERT_EQ (summary.numActiveTrials, expectedSummary.numActiveTrials) << "Step " << step;
+
+        auto getAll = random.nextInt (10) == 0;
+        ASSERT_EQ (
+            hashesOf (store->getActivationsWhichNeedUpdate (kProductUid, kMachineUid, getAll, now)),
+            hashesOf (reference.getActivationsWhichNeedUpdate (kProductUid, kMachineUid, getAll, now)))
+            << "Step " << step;
+
+        ASSERT_EQ (
+            store->getNextUpdateTime (kProductUid, kMachineUid),
+            reference.getNextUpdateTime (kProductUid, kMachineUid))
+            << "Step " << step;
+    }
+}
+
+TEST_P (ActivationStoreTest, ActivationsSurviveReopening)
+{
+    if (std::string (GetParam().name) == "Memory")
+        GTEST_SKIP() << "Not persistent";
+
+    auto a = makeActivation ({ 1 }, indiekey::License::Type::Trial);
+    auto b = makeActivation ({ 2 }, indiekey::License::Type::Perpetual);
+
+    {
+        auto store = createStore();
+        store->saveActivations ({ a, b }, kNow);
+        store->deleteActivation (a.getHash());
+        store->runMaintenance (kNow, true);
+        store->saveActivation (a, kNow);
+    }
+
+    auto store = createStore();
+    ASSERT_EQ (hashesOf (store->getActivations (kProductUid, kMachineUid)), hashesOf ({ b, a }));
+    ASSERT_FALSE (store->runMaintenance (kNow + juce::RelativeTime::days (1), false).ran);
+}
+
+TEST_P (ActivationStoreTest, MetadataIsStoredPerKeyAndSurvivesReopening)
+{
+    {
+        auto store = createStore();
+        ASSERT_FALSE (store->getMetadata ("a").has_value());
+
+        store->setMetadata ("a", 1);
+        store->setMetadata ("b", -2);
+        store->setMetadata ("a", 3);
+
+        ASSERT_EQ (store->getMetadata ("a"), 3);
+        ASSERT_EQ (store->getMetadata ("b"), -2);
+    }
+
+    if (std::string (GetParam().name) == "Memory")
+        return;
+
+    auto store = createStore();
+    ASSERT_EQ (store->getMetadata ("a"), 3);
+    ASSERT_EQ (store->getMetadata ("b"), -2);
+}
+
+TEST_P (ActivationStoreTest, MetadataUpdatesAreNotLost)
+{
+    auto store = createStore();
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back ([&store] {
+            for (int j = 0; j < 25; ++j)
+            {
+                store->updateMetadata ({ "count", "unused" }, [] (const indiekey::ActivationStore::Metadata& stored) {
+                    auto count = stored.count ("count") != 0 ? stored.at ("count") : 0;
+                    return indiekey::ActivationStore::Metadata { { "count", count + 1 }, { "other", -count } };
+                });
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    ASSERT_EQ (store->getMetadata ("count"), 100);
+    ASSERT_EQ (store->getMetadata ("other"), -99);
+    ASSERT_FALSE (store->getMetadata ("unused").has_value());
+
+    // Nothing is stored when the update returns no values.
+    store->updateMetadata ({ "count" }, [] (const indiekey::ActivationStore::Metadata&) {
+        return indiekey::ActivationStore::Metadata {};
+    });
+
+    ASSERT_EQ (store->getMetadata ("count"), 100);
+}
+
+INSTANTIATE_TEST_SUITE_P (
+    AllBackends,
+    ActivationStoreTest,
+    ::testing::ValuesIn (kStoreFactories),
+    [] (const ::testing::TestParamInfo<StoreFactory>& info) {
+        return std::string (info.param.name);
+    });
+
+TEST (FileActivationStore, TornTailIsIgnoredAndOverwritten)
+{
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                    .getNonexistentChildFile ("indiekey_store_test", ".log", false);
+
+    auto a = makeActivation ({ 1 }, indiekey::License::Type::Trial);
+    auto b = makeActivation ({ 2 }, indiekey::License::Type::Perpetual);
+
+    indiekey::FileActivationStore (file).saveActivation (a, kNow);
+
+    // Simulates a crash halfway through appending a change.
+    file.appendText ("0badc0de {\"op\":\"delete\",", false, false, nullptr);
+
+    {
+        indiekey::FileActivationStore store (file);
+        ASSERT_EQ (hashesOf (store.getActivations (kProductUid, kMachineUid)), hashesOf ({ a }));
+        store.saveActivation (b, kNow);
+    }
+
+    indiekey::FileActivationStore store (file);
+    ASSERT_EQ (hashesOf (store.getActivations (kProductUid, kMachineUid)), hashesOf ({ a, b }));
+
+    file.deleteFile();
+}
+
+TEST (FileActivationStore, InstancesSeeEachOthersChanges)
+{
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                    .getNonexistentChildFile ("indiekey_store_test", ".log", false);
+
+    indiekey::FileActivationStore first (file);
+    indiekey::FileActivationStore second (file);
+
+    auto a = makeActivation ({ 1 }, indiekey::License::Type::Perpetual);
+    first.saveActivation (a, kNow);
+    ASSERT_EQ (second.getActivations (kProductUid, kMachineUid).size(), 1);
+
+    // Compaction replaces the file, which the other instance must notice.
+    second.runMaintenance (kNow, true);
+    second.deleteActivation (a.getHash());
+    ASSERT_TRUE (first.getActivations (kProductUid, kMachineUid).empty());
+
+    file.deleteFile();
+}
+
+TEST (SqliteActivationStore, ReadsDoNotWaitForWriters)
+{
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                    .getNonexistentChildFile ("indiekey_store_test", ".db", false);
+
+    {
+        indiekey::SqliteActivationStore store (file);
+        auto a = makeActivation ({ 1 }, indiekey::License::Type::Perpetual);
+        store.saveActivation (a, kNow);
+
+        // Another process is in the middle of a write: readers see the last committed snapshot.
+        SQLite::Database writer (file.getFullPathName().toRawUTF8(), SQLite::OPEN_READWRITE);
+        writer.exec ("BEGIN IMMEDIATE");
+        writer.exec ("DELETE FROM activations");
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        ASSERT_EQ (hashesOf (store.getActivations (kProductUid, kMachineUid)), hashesOf ({ a }));
+        ASSERT_LT (juce::Time::getMillisecondCounterHiRes() - start, 500.0);
+
+        writer.exec ("ROLLBACK");
+    }
+
+    file.deleteFile();
+    file.getSiblingFile (file.getFileName() + "-wal").deleteFile();
+    file.getSiblingFile (file.getFileName() + "-shm").deleteFile();
+}
+
+TEST (SqliteActivationStore, ProcessesUpgradingAtTheSameTimeMigrateOnce)
+{
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                    .getNonexistentChildFile ("indiekey_store_test", ".db", false);
+
+    // A database from before refresh intervals were stored, which every plugin instance of a scan upgrades at once.
+    {
+        SQLite::Database database (file.getFullPathName().toRawUTF8(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        database.exec ("PRAGMA journal_mode = WAL");
+        database.exec (R"(create table activations(
+            id                 integer primary key autoincrement,
+            hash               blob unique not null,
+            product_uid        text        not null,
+            machine_uid        blob        not null,
+            expires_at         integer,
+            license_expires_at integer,
+            last_updated_at    integer     not null,
+            license_type       text        not null,
+            signature          blob        not null);
+           PRAGMA user_version = 1;
+        )");
+    }
+
+    std::atomic<int> numFailures { 0 };
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back ([&file, &numFailures] {
+            try
+            {
+                indiekey::SqliteActivationStore store (file);
+            }
+            catch (const std::exception&)
+            {
+                numFailures++;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    ASSERT_EQ (numFailures, 0);
+
+    {
+        indiekey::SqliteActivationStore store (file);
+        indiekey::Activation a { { 1 },
+                                 kProductUid,
+                                 kMachineUid,
+                                 std::nullopt,
+                                 std::nullopt,
+                                 indiekey::License::Type::Perpetual,
+                                 std::vector<uint8_t> (64, 0),
+                                 juce::RelativeTime::hours (2) };
+        store.saveActivation (a, kNow);
+
+        auto stored = store.getActivations (kProductUid, kMachineUid);
+        ASSERT_EQ (stored.size(), 1);
+        ASSERT_EQ (stored[0].getRefreshInterval(), juce::RelativeTime::hours (2));
+    }
+
+    file.deleteFile();
+    file.getSiblingFile (file.getFileName() + "-wal").deleteFile();
+    file.getSiblingFile (file.getFileName() + "-shm").deleteFile();
+}
@@ -0,0 +1,441 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include "ActivationSigner.h"
+#include "indiekey/ActivationsDatabase.h"
+
+namespace
+{
+
+const std::string kProductUid = "product";
+const std::vector<uint8_t> kMachineUid { 1, 2, 3, 4 };
+
+std::optional<juce::Time> randomTime (juce::Random& random, juce::Time now)
+{
+    // A small set of offsets around now, so that ties and expiry boundaries are hit often.
+    static const juce::int64 offsets[] = { -2 * 86400000LL, -1, 0, 1, 86400000LL, 30 * 86400000LL };
+
+    if (random.nextInt (4) == 0)
+        return std::nullopt;
+
+    return juce::Time (now.toMilliseconds() + offsets[random.nextInt (juce::numElementsInArray (offsets))]);
+}
+
+indiekey::Activation randomActivation (juce::Random& random, juce::Time now)
+{
+    static const indiekey::License::Type types[] = {
+        indiekey::License::Type::Undefined, indiekey::License::Type::Perpetual, indiekey::License::Type::Subscription,
+        indiekey::License::Type::Trial,     indiekey::License::Type::Alpha,     indiekey::License::Type::Beta,
+    };
+
+    return { indiekey::test::ActivationSigner::randomBytes (random, 32),
+             kProductUid,
+             kMachineUid,
+             randomTime (random, now),
+             randomTime (random, now),
+             types[random.nextInt (juce::numElementsInArray (types))],
+             indiekey::test::ActivationSigner::randomBytes (random, 64) };
+}
+
+} // namespace
+
+TEST (ActivationsDatabase, MostValuableActivationMatchesIsMoreValuableThan)
+{
+    juce::Random random (42);
+    const juce::Time now (1700000000000);
+
+    for (int round = 0; round < 500; ++round)
+    {
+        indiekey::ActivationsDatabase database;
+        database.openDatabase ({ {}, false, true });
+
+        for (int i = 0, n = random.nextInt (10); i < n; ++i)
+            database.saveActivation (randomActivation (random, now), now);
+
+        auto activations = database.getActivations (kProductUid, kMachineUid);
+
+        auto expected = activations.cbegin();
+        for (auto it = activations.cbegin(); it != activations.cend(); ++it)
+            if (it->isMoreValuableThan (*expected, now))
+                expected = it;
+
+        auto mostValuable = database.getMostValuableActivation (kProductUid, kMachineUid, now);
+
+        if (activations.empty())
+        {
+            ASSERT_FALSE (mostValuable.has_value());
+            continue;
+        }
+
+        ASSERT_TRUE (mostValuable.has_value());
+        ASSERT_EQ (mostValuable->getHash(), expected->getHash()) << "Round " << round;
+    }
+}
+
+TEST (ActivationsDatabase, TrialSummaryMatchesTrialActivations)
+{
+    juce::Random random (43);
+    const juce::Time now (1700000000000);
+
+    for (int round = 0; round < 500; ++round)
+    {
+        indiekey::ActivationsDatabase database;
+        database.openDatabase ({ {}, false, true });
+
+        for (int i = 0, n = random.nextInt (6); i < n; ++i)
+            database.saveActivation (randomActivation (random, now), now);
+
+        auto trials = database.getTrialActivations (kProductUid, kMachineUid);
+        auto numActiveTrials = std::count_if (trials.begin(), trials.end(), [now] (const auto& activation) {
+            return !activation.isExpired (now);
+        });
+
+        auto summary = database.getTrialSummary (kProductUid, kMachineUid, now);
+
+        ASSERT_EQ (summary.numTrials, static_cast<int> (trials.size())) << "Round " << round;
+        ASSERT_EQ (summary.numActiveTrials, static_cast<int> (numActiveTrials)) << "Round " << round;
+    }
+}
+
+TEST (ActivationsDatabase, RefreshIntervalIsHonouredPerActivation)
+{
+    juce::Random random (7);
+    const juce::Time now (1700000000000);
+    const auto factor = indiekey::ActivationsDatabase::getRefreshJitterFactor (kMachineUid);
+
+    indiekey::ActivationsDatabase database;
+    database.openDatabase ({ {}, false, true });
+
+    indiekey::Activation hourly { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                                  kProductUid,
+                                  kMachineUid,
+                                  std::nullopt,
+                                  std::nullopt,
+                                  indiekey::License::Type::Perpetual,
+                                  indiekey::test::ActivationSigner::randomBytes (random, 64),
+                                  juce::RelativeTime::hours (1) };
+
+    indiekey::Activation byDefault { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                                     kProductUid,
+                                     kMachineUid,
+                                     std::nullopt,
+                                     std::nullopt,
+                                     indiekey::License::Type::Perpetual,
+                                     indiekey::test::ActivationSigner::randomBytes (random, 64) };
+
+    database.saveActivation (hourly, now);
+    database.saveActivation (byDefault, now);
+
+    auto stored = database.getActivations (kProductUid, kMachineUid);
+    ASSERT_EQ (stored.size(), 2);
+    ASSERT_EQ (stored[0].getRefreshInterval(), juce::RelativeTime::hours (1));
+    ASSERT_FALSE (stored[1].getRefreshInterval().has_value());
+
+    auto nextUpdateTime = database.getNextUpdateTime (kProductUid, kMachineUid);
+    ASSERT_TRUE (nextUpdateTime.has_value());
+    ASSERT_NEAR (
+        static_cast<double> (nextUpdateTime->toMilliseconds()),
+        static_cast<double> (now.toMilliseconds()) + 3600000.0 * factor,
+        1.0);
+
+    ASSERT_TRUE (database.getActivationsWhichNeedUpdate (kProductUid, kMachineUid, false, now).empty());
+
+    auto needUpdate = database.getActivationsWhichNeedUpdate (
+        kProductUid,
+        kMachineUid,
+        false,
+        now + juce::RelativeTime::hours (1));
+    ASSERT_EQ (needUpdate.size(), 1);
+    ASSERT_EQ (needUpdate[0].getHash(), hourly.getHash());
+}
+
+TEST (ActivationsDatabase, ExpiredActivationIsNotDueAgainRightAfterUpdate)
+{
+    juce::Random random (9);
+    const juce::Time now (1700000000000);
+    const auto factor = indiekey::ActivationsDatabase::getRefreshJitterFactor (kMachineUid);
+    const auto interval = juce::RelativeTime::hours (indiekey::ActivationStore::kDefaultRefreshIntervalHours);
+
+    indiekey::ActivationsDatabase database;
+    database.openDatabase ({ {}, false, true });
+
+    auto expectNextUpdateAt = [&] (juce::Time expected) {
+        auto nextUpdateTime = database.getNextUpdateTime (kProductUid, kMachineUid);
+        ASSERT_TRUE (nextUpdateTime.has_value());
+        ASSERT_NEAR (
+            static_cast<double> (nextUpdateTime->toMilliseconds()),
+            static_cast<double> (expected.toMilliseconds()),
+            1.0);
+    };
+
+    // Like a lapsed subscription: the server keeps returning the activation without extending it.
+    indiekey::Activation lapsed { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                                  kProductUid,
+                                  kMachineUid,
+                                  now - juce::RelativeTime::days (1),
+                                  std::nullopt,
+                                  indiekey::License::Type::Subscription,
+                                  indiekey::test::ActivationSigner::randomBytes (random, 64) };
+
+    database.saveActivation (lapsed, now);
+    expectNextUpdateAt (now + juce::RelativeTime (interval.inSeconds() * factor));
+
+    // About to expire: due when it expires, and after an update which didn't extend it at the regular interval.
+    database.deleteAllActivations (kProductUid, kMachineUid);
+
+    indiekey::Activation expiring { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                                    kProductUid,
+                                    kMachineUid,
+                                    now + juce::RelativeTime::hours (1),
+                                    std::nullopt,
+                                    indiekey::License::Type::Subscription,
+                                    indiekey::test::ActivationSigner::randomBytes (random, 64) };
+
+    database.saveActivation (expiring, now);
+    expectNextUpdateAt (now + juce::RelativeTime::hours (1));
+
+    auto updatedAt = now + juce::RelativeTime::hours (2);
+    database.saveActivation (expiring, updatedAt);
+    expectNextUpdateAt (updatedAt + juce::RelativeTime (interval.inSeconds() * factor));
+}
+
+TEST (ActivationsDatabase, RefreshJitterFactorIsDeterministicAndBounded)
+{
+    juce::Random random (3);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto machineUid = indiekey::test::ActivationSigner::randomBytes (random, 32);
+        auto factor = indiekey::ActivationsDatabase::getRefreshJitterFactor (machineUid);
+
+        ASSERT_GT (factor, 1.0 - indiekey::ActivationsDatabase::kMaxRefreshJitter);
+        ASSERT_LE (factor, 1.0);
+        ASSERT_EQ (factor, indiekey::ActivationsDatabase::getRefreshJitterFactor (machineUid));
+    }
+}
+
+TEST (ActivationsDatabase, MaintenancePrunesExpiredActivationsButKeepsLatestTrial)
+{
+    juce::Random random (11);
+    const juce::Time now (1700000000000);
+    const auto longAgo = now - juce::RelativeTime::days (indiekey::ActivationsDatabase::kPruneRetentionDays + 1);
+    const auto recently = now - juce::RelativeTime::days (1);
+
+    indiekey::ActivationsDatabase database;
+    database.openDatabase ({ {}, false, true });
+
+    auto makeActivation = [&random] (std::optional<juce::Time> expiresAt, indiekey::License::Type type) {
+        return indiekey::Activation { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                                      kProductUid,
+                                      kMachineUid,
+                                      expiresAt,
+                                      std::nullopt,
+                                      type,
+                                      indiekey::test::ActivationSigner::randomBytes (random, 64) };
+    };
+
+    database.saveActivation (makeActivation (longAgo, indiekey::License::Type::Trial), now);
+    database.saveActivation (makeActivation (longAgo, indiekey::License::Type::Trial), now);
+    database.saveActivation (makeActivation (longAgo, indiekey::License::Type::Subscription), now);
+    database.saveActivation (makeActivation (recently, indiekey::License::Type::Subscription), now);
+    database.saveActivation (makeActivation (std::nullopt, indiekey::License::Type::Perpetual), now);
+
+    auto report = database.runMaintenance (now);
+    ASSERT_TRUE (report.ran);
+    ASSERT_EQ (report.numRowsPruned, 2);
+    ASSERT_EQ (database.getActivations (kProductUid, kMachineUid).size(), 3);
+
+    auto trialSummary = database.getTrialSummary (kProductUid, kMachineUid, now);
+    ASSERT_EQ (trialSummary.numTrials, 1);
+    ASSERT_EQ (trialSummary.numActiveTrials, 0);
+
+    // Rate limited, unless forced.
+    ASSERT_FALSE (database.runMaintenance (now + juce::RelativeTime::days (1)).ran);
+    ASSERT_TRUE (database.runMaintenance (now + juce::RelativeTime::days (1), true).ran);
+    ASSERT_TRUE (database
+                     .runMaintenance (
+                         now + juce::RelativeTime::days (1 + indiekey::ActivationsDatabase::kMaintenanceIntervalDays))
+                     .ran);
+}
+
+TEST (ActivationsDatabase, CachedResultsSurviveSkippedMaintenance)
+{
+    juce::Random random (19);
+    const juce::Time now (1700000000000);
+
+    indiekey::ActivationsDatabase database;
+    database.openDatabase ({ {}, false, true });
+    database.saveActivation (randomActivation (random, now), now);
+    ASSERT_TRUE (database.runMaintenance (now).ran);
+
+    auto readAll = [&] {
+        (void)database.getActivations (kProductUid, kMachineUid);
+        (void)database.getNextUpdateTime (kProductUid, kMachineUid);
+        (void)database.getMostValuableActivation (kProductUid, kMachineUid, now);
+    };
+
+    readAll();
+    auto numCacheMisses = database.getNumCacheMisses();
+
+    // Like the refresh of a client, which asks for maintenance every time.
+    for (int i = 1; i < 5; ++i)
+    {
+        ASSERT_FALSE (database.runMaintenance (now + juce::RelativeTime::hours (i)).ran);
+        readAll();
+    }
+
+    ASSERT_EQ (database.getNumCacheMisses(), numCacheMisses);
+
+    // Maintenance which pruned rows drops the cache.
+    auto later = now + juce::RelativeTime::days (indiekey::ActivationsDatabase::kPruneRetentionDays + 30);
+    database.saveActivation (
+        indiekey::Activation { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                               kProductUid,
+                               kMachineUid,
+                               now,
+                               std::nullopt,
+                               indiekey::License::Type::Subscription,
+                               indiekey::test::ActivationSigner::randomBytes (random, 64) },
+        now);
+    readAll();
+    numCacheMisses = database.getNumCacheMisses();
+
+    ASSERT_GT (database.runMaintenance (later).numRowsPruned, 0);
+    readAll();
+    ASSERT_GT (database.getNumCacheMisses(), numCacheMisses);
+}
+
+TEST (ActivationsDatabase, CachedResultsFollowWritesFromOtherConnections)
+{
+    juce::Random random (13);
+    const juce::Time now (1700000000000);
+
+    using Backend = indiekey::ActivationsDatabase::Backend;
+
+    for (auto backend : { Backend::Sqlite, Backend::File })
+    {
+        auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                        .getNonexistentChildFile ("indiekey_cache_test", ".db", false);
+
+        {
+            indiekey::ActivationsDatabase first;
+            indiekey::ActivationsDatabase second;
+
+            indiekey::ActivationsDatabase::Options options;
+            options.databaseFile = file;
+            options.backend = backend;
+            options.memoryBudget.shareConnections = false;
+            first.openDatabase (options);
+            second.openDatabase (options);
+
+            auto a = randomActivation (random, now);
+            auto b = randomActivation (random, now);
+
+            first.saveActivation (a, now);
+            ASSERT_EQ (first.getActivations (kProductUid, kMachineUid).size(), 1);
+            ASSERT_EQ (second.getActivations (kProductUid, kMachineUid).size(), 1);
+
+            // A local write invalidates the cache of this instance, the data version the cache of the other.
+            second.saveActivation (b, now);
+            ASSERT_EQ (second.getActivations (kProductUid, kMachineUid).size(), 2);
+            ASSERT_EQ (first.getActivations (kProductUid, kMachineUid).size(), 2);
+
+            first.deleteAllActivations (kProductUid, kMachineUid);
+            ASSERT_FALSE (second.getMostValuableActivation (kProductUid, kMachineUid, now).has_value());
+            ASSERT_FALSE (second.getNextUpdateTime (kProductUid, kMachineUid).has_value());
+        }
+
+        file.deleteFile();
+    }
+}
+
+TEST (ActivationsDatabase, SharedStoreIsReleasedWhenIdle)
+{
+    juce::Random random (17);
+    const juce::Time now (1700000000000);
+    indiekey::ManualClock clock (now);
+
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                    .getNonexistentChildFile ("indiekey_idle_test", ".db", false);
+
+    {
+        indiekey::ActivationsDatabase first;
+        indiekey::ActivationsDatabase second;
+        first.setClock (clock);
+        second.setClock (clock);
+
+        indiekey::ActivationsDatabase::Options options;
+        options.databaseFile = file;
+        options.memoryBudget.idleTimeout = juce::RelativeTime::minutes (5);
+        first.openDatabase (options);
+        second.openDatabase (options);
+
+        ASSERT_FALSE (first.getTimeUntilIdle().has_value()); // Not opened yet.
+        ASSERT_EQ (first.getStoreMemoryUsage(), 0);
+
+        first.saveActivation (randomActivation (random, now), now);
+        ASSERT_EQ (second.getActivations (kProductUid, kMachineUid).size(), 1);
+
+        // Both instances share one store, so each accounts for half of it.
+        auto sharedUsage = first.getStoreMemoryUsage();
+        ASSERT_GT (sharedUsage, 0);
+        ASSERT_GT (second.getCacheMemoryUsage(), 0);
+
+        ASSERT_EQ (first.getTimeUntilIdle(), options.memoryBudget.idleTimeout);
+        ASSERT_FALSE (first.releaseIfIdle());
+
+        clock.advance (juce::RelativeTime::minutes (4));
+        ASSERT_EQ (first.getTimeUntilIdle(), juce::RelativeTime::minutes (1));
+        ASSERT_FALSE (first.releaseIfIdle());
+
+        clock.advance (juce::RelativeTime::minutes (1));
+        ASSERT_TRUE (first.releaseIfIdle());
+        ASSERT_EQ (first.getStoreMemoryUsage(), 0);
+        ASSERT_GT (second.getStoreMemoryUsage(), sharedUsage); // Now the only user of the store.
+
+        ASSERT_TRUE (second.releaseIfIdle());
+        ASSERT_EQ (second.getCacheMemoryUsage(), 0);
+
+        // Reopened on next use.
+        ASSERT_EQ (first.getActivations (kProductUid, kMachineUid).size(), 1);
+    }
+
+    file.deleteFile();
+}
+
+TEST (ActivationsDatabase, CachedMostValuableActivationFollowsExpiry)
+{
+    juce::Random random (17);
+    const juce::Time now (1700000000000);
+
+    indiekey::ActivationsDatabase database;
+    database.openDatabase ({ {}, false, true });
+
+    auto makeActivation = [&] (std::optional<juce::Time> expiresAt) {
+        return indiekey::Activation { indiekey::test::ActivationSigner::randomBytes (random, 32),
+                                      kProductUid,
+                                      kMachineUid,
+                                      expiresAt,
+                                      std::nullopt,
+                                      indiekey::License::Type::Subscription,
+                                      indiekey::test::ActivationSigner::randomBytes (random, 64) };
+    };
+
+    auto expiring = makeActivation (now + juce::RelativeTime::hours (1));
+    auto unlimited = makeActivation (std::nullopt);
+    database.saveActivations ({ expiring, unlimited }, now);
+
+    // Without writes the result is reused, until the time passes the expiry of the cached activation.
+    for (auto time : { now, now + juce::RelativeTime::minutes (30), now + juce::RelativeTime::hours (1) })
+        ASSERT_EQ (database.getMostValuableActivation (kProductUid, kMachineUid, time)->getHash(), expiring.getHash());
+
+    auto later = now + juce::RelativeTime::hours (2);
+    ASSERT_EQ (database.getMostValuableActivation (kProductUid, kMachineUid, later)->getHash(), unlimited.getHash());
+
+    // A clock which went back doesn't get the result for a later time.
+    ASSERT_EQ (database.getMostValuableActivation (kProductUid, kMachineUid, now)->getHash(), expiring.getHash());
+}
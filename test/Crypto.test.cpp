@@ -0,0 +1,65 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include "indiekey/Crypto.h"
+
+#include <sodium/crypto_box.h>
+
+TEST (Crypto, InitCanBeCalledRepeatedly)
+{
+    indiekey::crypto::init();
+    indiekey::crypto::init();
+}
+
+TEST (Crypto, StreamingHashMatchesGenericHash)
+{
+    indiekey::crypto::init();
+
+    const std::string text = "The quick brown fox jumps over the lazy dog";
+
+    indiekey::crypto::GenericHash hash;
+    hash.update (text.substr (0, 10));
+    hash.update (reinterpret_cast<const uint8_t*> (text.data()) + 10, text.size() - 10);
+
+    ASSERT_EQ (hash.finish(), indiekey::crypto::genericHash (text));
+
+    uint8_t buffer[indiekey::crypto::kGenericHashBytes];
+    indiekey::crypto::genericHash (reinterpret_cast<const uint8_t*> (text.data()), text.size(), buffer);
+
+    ASSERT_EQ (std::vector<uint8_t> (buffer, buffer + sizeof (buffer)), indiekey::crypto::genericHash (text));
+}
+
+TEST (Crypto, BoxSealIntoBuffer)
+{
+    indiekey::crypto::init();
+
+    unsigned char publicKey[crypto_box_PUBLICKEYBYTES];
+    unsigned char secretKey[crypto_box_SECRETKEYBYTES];
+    ASSERT_EQ (crypto_box_keypair (publicKey, secretKey), 0);
+
+    const std::string message = "secret";
+    std::vector<uint8_t> cipherText (message.size() + indiekey::crypto::kBoxSealOverheadBytes);
+
+    auto numBytes = indiekey::crypto::boxSeal (
+        reinterpret_cast<const uint8_t*> (message.data()),
+        message.size(),
+        publicKey,
+        cipherText.data());
+
+    ASSERT_EQ (numBytes, cipherText.size());
+
+    std::string decrypted (message.size(), '\0');
+    ASSERT_EQ (
+        crypto_box_seal_open (
+            reinterpret_cast<unsigned char*> (decrypted.data()),
+            cipherText.data(),
+            cipherText.size(),
+            publicKey,
+            secretKey),
+        0);
+    ASSERT_EQ (decrypted, message);
+}
@@ -0,0 +1,68 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include "indiekey/RestClient.h"
+
+#include <thread>
+
+TEST (RestClient, CancellationAbortsRequestWhichIsWaitingForTheServer)
+{
+    // Accepts connections but never responds, like a server which hangs.
+    juce::StreamingSocket server;
+    ASSERT_TRUE (server.createListener (0, "127.0.0.1"));
+
+    std::unique_ptr<juce::StreamingSocket> connection;
+    std::thread acceptThread ([&] {
+        connection.reset (server.waitForNextConnection());
+    });
+
+    indiekey::RestClient client (juce::URL ("http://127.0.0.1:" + juce::String (server.getBoundPort())));
+    indiekey::CancellationToken token;
+
+    std::thread cancelThread ([&token] {
+        std::this_thread::sleep_for (std::chrono::milliseconds (100));
+        token.cancel();
+    });
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    ASSERT_THROW (client.post ("/activate", nlohmann::json::object(), &token), indiekey::CancellationToken::Cancelled);
+    ASSERT_LT (juce::Time::getMillisecondCounterHiRes() - start, 1000.0);
+
+    cancelThread.join();
+    server.close();
+    acceptThread.join();
+
+    // A cancelled token fails new requests right away.
+    ASSERT_THROW (client.get ("/ping", &token), indiekey::CancellationToken::Cancelled);
+}
+
+TEST (CancellationToken, CallbacksRunOnceAndNotAfterUnregistering)
+{
+    indiekey::CancellationToken token;
+    int numCalls = 0;
+
+    {
+        auto registration = token.onCancel ([&numCalls] {
+            numCalls++;
+        });
+    }
+
+    auto registration = token.onCancel ([&numCalls] {
+        numCalls += 10;
+    });
+
+    token.cancel();
+    token.cancel();
+    ASSERT_EQ (numCalls, 10);
+    ASSERT_TRUE (token.isCancelled());
+
+    // Registering after cancellation calls back right away.
+    auto late = token.onCancel ([&numCalls] {
+        numCalls += 100;
+    });
+    ASSERT_EQ (numCalls, 110);
+}
@@ -0,0 +1,212 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include "StandInServer.h"
+#include "indiekey/ActivationClient.h"
+#include "indiekey/CassetteTransport.h"
+#include "indiekey/Crypto.h"
+#include "indiekey/FaultInjectingTransport.h"
+#include "indiekey/WebTransport.h"
+
+namespace
+{
+
+/**
+ * Answers every request with an empty json object, without a server.
+ */
+class StubTransport : public indiekey::Transport
+{
+public:
+    indiekey::RestClient::Response send (const indiekey::RestClient::Request&, indiekey::CancellationToken*) override
+    {
+        return { 200, "{}" };
+    }
+};
+
+indiekey::ProductData makeProductData (const indiekey::test::StandInServer& server)
+{
+    indiekey::ProductData productData;
+    productData.productUid = "product";
+    productData.verifyingKey = server.getSigner().getVerifyingKey();
+    productData.primaryPublicServerAddress = server.getAddress();
+    return productData;
+}
+
+/**
+ * Activates and then validates online through given transport.
+ * @returns The time it took until the client had a result, in milliseconds, and whether that result was an error.
+ */
+std::pair<double, bool> activateAndValidate (
+    const indiekey::ProductData& productData,
+    std::shared_ptr<indiekey::Transport> transport)
+{
+    indiekey::ActivationClient client;
+    client.setProductData (productData, indiekey::ActivationsDatabase::Options { {}, false, true });
+    client.setTransport (std::move (transport));
+
+    auto startedAt = juce::Time::getMillisecondCounterHiRes();
+    auto failed = false;
+
+    try
+    {
+        client.activate ("someone@example.com", "LICENSE");
+        client.validate (indiekey::ActivationClient::ValidationStrategy::ForceOnline);
+    }
+    catch (const std::exception&)
+    {
+        failed = true;
+    }
+
+    auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startedAt;
+
+    if (!failed)
+    {
+        EXPECT_NE (client.getLoadedActivation(), nullptr);
+        EXPECT_EQ (client.getLoadedActivation()->getStatus(), indiekey::Activation::Status::Valid);
+    }
+
+    return { elapsedMs, failed };
+}
+
+} // namespace
+
+TEST (Transport, CassetteReplaysRecordedConversation)
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    indiekey::crypto::init();
+
+    indiekey::test::StandInServer server;
+    auto productData = makeProductData (server);
+
+    juce::TemporaryFile cassetteFile (".json");
+
+    {
+        auto recorder = std::make_shared<indiekey::CassetteTransport> (
+            indiekey::CassetteTransport::Mode::Record,
+            cassetteFile.getFile(),
+            std::make_shared<indiekey::WebTransport>());
+
+        ASSERT_FALSE (activateAndValidate (productData, recorder).second);
+        ASSERT_EQ (recorder->getNumRemainingInteractions(), 2);
+    }
+
+    auto numServerRequests = server.getNumRequests();
+    productData.primaryPublicServerAddress = "http://localhost:1"; // Must not be contacted.
+
+    auto player = std::make_shared<indiekey::CassetteTransport> (
+        indiekey::CassetteTransport::Mode::Replay,
+        cassetteFile.getFile());
+
+    ASSERT_FALSE (activateAndValidate (productData, player).second);
+    ASSERT_EQ (player->getNumRemainingInteractions(), 0);
+    ASSERT_EQ (server.getNumRequests(), numServerRequests);
+
+    // Everything was replayed, so another conversation has nothing to be answered with.
+    ASSERT_TRUE (activateAndValidate (productData, player).second);
+
+    juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+}
+
+TEST (Transport, ClientUnderInjectedFaults)
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    indiekey::crypto::init();
+
+    indiekey::test::StandInServer server;
+    auto productData = makeProductData (server);
+
+    auto run = [&] (indiekey::FaultInjectingTransport::Faults faults) {
+        auto transport = std::make_shared<indiekey::FaultInjectingTransport> (
+            std::make_shared<indiekey::WebTransport>(),
+            faults);
+        auto result = activateAndValidate (productData, transport);
+        return std::make_tuple (result.first, result.second, transport->getCounters());
+    };
+
+    {
+        indiekey::FaultInjectingTransport::Faults faults;
+        faults.latencyProbability = 1.0;
+        faults.minLatency = juce::RelativeTime::milliseconds (100);
+        faults.maxLatency = juce::RelativeTime::milliseconds (100);
+
+        auto [elapsedMs, failed, counters] = run (faults);
+        ASSERT_FALSE (failed);
+        ASSERT_EQ (counters.numDelayed, 2);
+        ASSERT_GE (elapsedMs, 200.0);
+        ASSERT_LT (elapsedMs, 5000.0);
+    }
+
+    // Failures must surface right away, without retrying or waiting for timeouts.
+    {
+        indiekey::FaultInjectingTransport::Faults faults;
+        faults.refusalProbability = 1.0;
+
+        auto [elapsedMs, failed, counters] = run (faults);
+        ASSERT_TRUE (failed);
+        ASSERT_EQ (counters.numRequests, 1);
+        ASSERT_EQ (counters.numRefused, 1);
+        ASSERT_LT (elapsedMs, 1000.0);
+    }
+
+    {
+        indiekey::FaultInjectingTransport::Faults faults;
+        faults.serverErrorProbability = 1.0;
+
+        auto [elapsedMs, failed, counters] = run (faults);
+        ASSERT_TRUE (failed);
+        ASSERT_EQ (counters.numServerErrors, 1);
+        ASSERT_LT (elapsedMs, 1000.0);
+    }
+
+    {
+        indiekey::FaultInjectingTransport::Faults faults;
+        faults.truncationProbability = 1.0;
+
+        auto [elapsedMs, failed, counters] = run (faults);
+        ASSERT_TRUE (failed);
+        ASSERT_EQ (counters.numTruncated, 1);
+        ASSERT_LT (elapsedMs, 5000.0);
+    }
+
+    juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+}
+
+TEST (Transport, SameSeedInjectsSameFaults)
+{
+    indiekey::FaultInjectingTransport::Faults faults;
+    faults.seed = 42;
+    faults.refusalProbability = 0.3;
+    faults.serverErrorProbability = 0.3;
+    faults.truncationProbability = 0.3;
+
+    auto sendAll = [&faults] {
+        indiekey::FaultInjectingTransport transport (std::make_shared<StubTransport>(), faults);
+        std::vector<int> outcomes;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            try
+            {
+                auto response = transport.send ({ juce::URL ("http://localhost:1/ping"), false, {}, 0 }, nullptr);
+                outcomes.push_back (response.statusCode * 10 + response.body.length());
+            }
+            catch (const std::runtime_error&)
+            {
+                outcomes.push_back (-1);
+            }
+        }
+
+        auto counters = transport.getCounters();
+        EXPECT_EQ (counters.numRequests, 100);
+        EXPECT_GT (counters.numRefused, 0);
+        EXPECT_GT (counters.numServerErrors, 0);
+        EXPECT_GT (counters.numTruncated, 0);
+        return outcomes;
+    };
+
+    ASSERT_EQ (sendAll(), sendAll());
+}
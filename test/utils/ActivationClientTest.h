@@ -0,0 +1,114 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "ActivationSigner.h"
+#include "indiekey/ActivationClient.h"
+#include "indiekey/Crypto.h"
+#include "indiekey/SharedStatusCache.h"
+
+#include <gtest/gtest.h>
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <vector>
+
+namespace indiekey::test
+{
+
+/**
+ * Fixture for tests which run ActivationClients. Initialises JUCE and libsodium, and provides a signer, product data
+ * signed by it, and database files and shared status regions which are deleted after the test. The server address of
+ * the product data refuses connections, tests which need a server replace it. Tests may change the process wide request
+ * budget and circuit breaker policies, they are restored afterward.
+ */
+class ActivationClientTest : public ::testing::Test
+{
+protected:
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    ActivationSigner signer;
+    ProductData productData;
+    std::string machineUid;
+
+    ActivationClientTest()
+    {
+        crypto::init();
+
+        machineUid = crypto::genericHash (juce::SystemStats::getUniqueDeviceID().toStdString());
+
+        productData.productUid = "product";
+        productData.verifyingKey = signer.getVerifyingKey();
+        productData.primaryPublicServerAddress = "http://localhost:1"; // Must not be contacted.
+    }
+
+    void TearDown() override
+    {
+        // Clients post their last notifications while they are destroyed.
+        juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+
+        // The policies apply to the whole process, so a test which changed them must not leave them behind.
+        juce::SharedResourcePointer<RequestBudget>()->setPolicy ({});
+        juce::SharedResourcePointer<CircuitBreaker>()->setPolicy ({});
+
+        for (const auto& file : databaseFiles_)
+            deleteDatabaseFile (file);
+
+        for (const auto& region : sharedStatusRegions_)
+            SharedStatusCache::deleteRegion (region);
+    }
+
+    /**
+     * @returns Options for a database which only lives in memory.
+     */
+    static ActivationsDatabase::Options inMemory()
+    {
+        return ActivationsDatabase::Options { {}, false, true };
+    }
+
+    /**
+     * @param name The prefix of the file name.
+     * @returns A database file in the temporary directory which doesn't exist yet, and is deleted after the test.
+     */
+    juce::File createDatabaseFile (const juce::String& name)
+    {
+        return databaseFiles_.emplace_back (juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                                .getNonexistentChildFile (name, ".db", false));
+    }
+
+    /**
+     * @returns The name of a shared status region which no other test uses, and which is deleted after the test.
+     */
+    std::string createSharedStatusRegion()
+    {
+        return sharedStatusRegions_.emplace_back ("indiekey-status-test-" + juce::Uuid().toString().toStdString());
+    }
+
+    /**
+     * Delivers the notifications which clients posted to the message thread.
+     */
+    static void runMessageLoop()
+    {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil (50);
+    }
+
+private:
+    std::vector<juce::File> databaseFiles_;
+    std::vector<std::string> sharedStatusRegions_;
+
+    /**
+     * Deletes a database file, the sidecar files of its write-ahead log and the key file which the shared status cache
+     * created next to it.
+     */
+    static void deleteDatabaseFile (const juce::File& file)
+    {
+        file.deleteFile();
+
+        for (const auto* suffix : { "-wal", "-shm", ".statuskey" })
+            file.getSiblingFile (file.getFileName() + suffix).deleteFile();
+    }
+};
+
+} // namespace indiekey::test
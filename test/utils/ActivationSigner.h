@@ -0,0 +1,103 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "indiekey/Activation.h"
+
+#include <sodium/crypto_sign.h>
+
+namespace indiekey::test
+{
+
+/**
+ * Holds an Ed25519 key pair and signs activations the same way the IndieKey server does. Only meant for tests and
+ * tools which need to stand in for the server.
+ */
+class ActivationSigner
+{
+public:
+    ActivationSigner() : verifyingKey_ (crypto_sign_PUBLICKEYBYTES), signingKey_ (crypto_sign_SECRETKEYBYTES)
+    {
+        if (crypto_sign_keypair (verifyingKey_.data(), signingKey_.data()) != 0)
+            throw std::runtime_error ("Failed to generate key pair");
+    }
+
+    /**
+     * @returns The key to verify activations signed by this signer with.
+     */
+    [[nodiscard]] const std::vector<uint8_t>& getVerifyingKey() const
+    {
+        return verifyingKey_;
+    }
+
+    /**
+     * @returns A signed activation with given properties.
+     */
+    [[nodiscard]] Activation sign (
+        Activation::Hash hash,
+        std::string productUid,
+        std::vector<uint8_t> machineUid,
+        std::optional<juce::Time> expiresAt,
+        std::optional<juce::Time> licenseExpiresAt,
+        License::Type licenseType) const
+    {
+        crypto_sign_state state {};
+
+        if (crypto_sign_init (&state) != 0)
+            throw std::runtime_error ("Failed to initialize crypto_sign_state");
+
+        auto update = [&state] (const void* data, size_t size) {
+            if (crypto_sign_update (&state, static_cast<const unsigned char*> (data), size) != 0)
+                throw std::runtime_error ("Failed to update crypto_sign_state");
+        };
+
+        update (hash.data(), hash.size());
+        update (productUid.data(), productUid.size());
+        update (machineUid.data(), machineUid.size());
+
+        for (const auto& time : { expiresAt, licenseExpiresAt })
+        {
+            if (time.has_value())
+            {
+                int64_t bigEndianBytes = juce::ByteOrder::swapIfLittleEndian (time->toMilliseconds());
+                update (&bigEndianBytes, sizeof (bigEndianBytes));
+            }
+        }
+
+        std::string typeString = License::typeToString (licenseType);
+        update (typeString.data(), typeString.size());
+
+        std::vector<uint8_t> signature (crypto_sign_BYTES);
+
+        if (crypto_sign_final_create (&state, signature.data(), nullptr, signingKey_.data()) != 0)
+            throw std::runtime_error ("Failed to sign activation");
+
+        return { std::move (hash),
+                 std::move (productUid),
+                 std::move (machineUid),
+                 expiresAt,
+                 licenseExpiresAt,
+                 licenseType,
+                 std::move (signature) };
+    }
+
+    /**
+     * @returns Given number of random bytes from given random generator.
+     */
+    static std::vector<uint8_t> randomBytes (juce::Random& random, size_t size)
+    {
+        std::vector<uint8_t> bytes (size);
+        for (auto& byte : bytes)
+            byte = static_cast<uint8_t> (random.nextInt (256));
+        return bytes;
+    }
+
+private:
+    std::vector<uint8_t> verifyingKey_;
+    std::vector<uint8_t> signingKey_;
+};
+
+} // namespace indiekey::test
@@ -0,0 +1,315 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+#pragma once
+
+#include "ActivationSigner.h"
+#include "indiekey/Crypto.h"
+#include "indiekey/Encoding.h"
+#include "indiekey/Endpoints.h"
+
+#include <juce_core/juce_core.h>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace indiekey::test
+{
+
+/**
+ * A minimal HTTP server on localhost which answers the activation endpoints like the IndieKey server would, signing
+ * activations with its own ActivationSigner. Every request gets a fresh connection which is closed after the response.
+ * Only meant for tests and tools which need a server without depending on the network.
+ */
+class StandInServer : private juce::Thread
+{
+public:
+    /**
+     * Starts listening on a free port.
+     * @param numThreads The number of threads which handle requests.
+     * @param processingDelayMs Time added to every request, to mimic the processing time of a real server.
+     * @throws std::runtime_error If no port could be opened.
+     */
+    explicit StandInServer (int numThreads = 4, int processingDelayMs = 0) :
+        juce::Thread ("IndieKey stand-in server"),
+        pool_ (numThreads),
+        processingDelayMs_ (processingDelayMs)
+    {
+        if (!listener_.createListener (0, "127.0.0.1"))
+            throw std::runtime_error ("Failed to open a port for the stand-in server");
+
+        startThread();
+    }
+
+    ~StandInServer() override
+    {
+        signalThreadShouldExit();
+        listener_.close();
+        stopThread (1000);
+        pool_.removeAllJobs (true, 5000);
+    }
+
+    /**
+     * @returns The address to pass to RestClient or ProductData::primaryPublicServerAddress.
+     */
+    [[nodiscard]] std::string getAddress() const
+    {
+        return "http://127.0.0.1:" + std::to_string (listener_.getBoundPort());
+    }
+
+    /**
+     * @returns The signer with which this server signs activations.
+     */
+    [[nodiscard]] const ActivationSigner& getSigner() const
+    {
+        return signer_;
+    }
+
+    /**
+     * @returns The number of requests which were answered.
+     */
+    [[nodiscard]] juce::int64 getNumRequests() const
+    {
+        return numRequests_;
+    }
+
+    /**
+     * @returns The number of requests for given path which were answered.
+     */
+    [[nodiscard]] int getNumRequests (const juce::String& path) const
+    {
+        std::lock_guard lock (mutex_);
+        auto it = numRequestsPerPath_.find (path);
+        return it != numRequestsPerPath_.end() ? it->second : 0;
+    }
+
+    /**
+     * @returns The number of requests which carried device info.
+     */
+    [[nodiscard]] int getNumRequestsWithDeviceInfo() const
+    {
+        std::lock_guard lock (mutex_);
+        return numRequestsWithDeviceInfo_;
+    }
+
+    /**
+     * @param isSupported False to answer update requests by hash with 404, like servers which predate them.
+     */
+    void setSupportsUpdatesByHash (bool isSupported)
+    {
+        supportsUpdatesByHash_ = isSupported;
+    }
+
+    /**
+     * @returns An activation signed the way this server issues it at given time.
+     */
+    [[nodiscard]] Activation issue (
+        Activation::Hash hash,
+        std::string productUid,
+        std::vector<uint8_t> machineUid,
+        License::Type type,
+        juce::Time now) const
+    {
+        auto expiresAt = now + juce::RelativeTime::days (kActivationValidityDays);
+        std::optional<juce::Time> licenseExpiresAt;
+
+        if (type == License::Type::Trial)
+            licenseExpiresAt = expiresAt;
+        else if (type == License::Type::Subscription)
+            licenseExpiresAt = now + juce::RelativeTime::days (kSubscriptionPeriodDays);
+
+        {
+            std::lock_guard lock (mutex_);
+            issued_[encodeToBase64 (hash)] = { productUid, machineUid, type };
+        }
+
+        return signer_.sign (
+            std::move (hash),
+            std::move (productUid),
+            std::move (machineUid),
+            expiresAt,
+            licenseExpiresAt,
+            type);
+    }
+
+private:
+    static constexpr int kActivationValidityDays = 14;
+    static constexpr int kSubscriptionPeriodDays = 30;
+    static constexpr int kReadTimeoutMs = 5000;
+
+    ActivationSigner signer_;
+    juce::StreamingSocket listener_;
+    juce::ThreadPool pool_;
+    int processingDelayMs_ = 0;
+    std::atomic<juce::int64> numRequests_ { 0 };
+    std::atomic<bool> supportsUpdatesByHash_ { true };
+
+    struct IssuedActivation
+    {
+        std::string productUid;
+        std::vector<uint8_t> machineUid;
+        License::Type type = License::Type::Undefined;
+    };
+
+    mutable std::mutex mutex_;
+    mutable std::map<std::string, IssuedActivation> issued_; // By base64 encoded hash.
+    std::map<juce::String, int> numRequestsPerPath_;
+    int numRequestsWithDeviceInfo_ = 0;
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            auto* connection = listener_.waitForNextConnection();
+
+            if (connection == nullptr)
+                continue;
+
+            pool_.addJob ([this, connection] {
+                std::unique_ptr<juce::StreamingSocket> owner (connection);
+                handleConnection (*owner);
+            });
+        }
+    }
+
+    void handleConnection (juce::StreamingSocket& connection)
+    {
+        std::string request;
+        char buffer[4096];
+
+        auto read = [&] {
+            if (connection.waitUntilReady (true, kReadTimeoutMs) != 1)
+                return false;
+
+            auto numRead = connection.read (buffer, static_cast<int> (sizeof (buffer)), false);
+            if (numRead <= 0)
+                return false;
+
+            request.append (buffer, static_cast<size_t> (numRead));
+            return true;
+        };
+
+        size_t headerEnd;
+        while ((headerEnd = request.find ("\r\n\r\n")) == std::string::npos)
+            if (!read())
+                return;
+
+        auto headers = juce::String (request.substr (0, headerEnd));
+        auto path = headers.upToFirstOccurrenceOf ("\r\n", false, false)
+                        .fromFirstOccurrenceOf (" ", false, false)
+                        .upToFirstOccurrenceOf (" ", false, false)
+                        .upToFirstOccurrenceOf ("?", false, false);
+        auto contentLength = static_cast<size_t> (
+            headers.fromFirstOccurrenceOf ("content-length:", false, true).upToFirstOccurrenceOf ("\r\n", false, false)
+                .trim()
+                .getLargeIntValue());
+
+        while (request.size() - (headerEnd + 4) < contentLength)
+            if (!read())
+                return;
+
+        if (processingDelayMs_ > 0)
+            juce::Thread::sleep (processingDelayMs_);
+
+        auto [statusCode, body] = respond (path, request.substr (headerEnd + 4, contentLength));
+
+        auto response = "HTTP/1.1 " + std::to_string (statusCode) + (statusCode == 200 ? " OK" : " Error") +
+                        "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string (body.size()) +
+                        "\r\nConnection: close\r\n\r\n" + body;
+
+        connection.write (response.data(), static_cast<int> (response.size()));
+        numRequests_++;
+
+        std::lock_guard lock (mutex_);
+        numRequestsPerPath_[path]++;
+        if (statusCode == 200 && request.find ("\"device_info\"", headerEnd) != std::string::npos)
+            numRequestsWithDeviceInfo_++;
+    }
+
+    [[nodiscard]] std::pair<int, std::string> respond (const juce::String& path, const std::string& body) const
+    {
+        try
+        {
+            auto now = juce::Time::getCurrentTime();
+
+            if (path == "/ping")
+                return { 200, nlohmann::json { { "timestamp", 0 } }.dump() };
+
+            auto json = nlohmann::json::parse (body);
+
+            if (path == ENDPOINT_ACTIVATE || path == ENDPOINT_ACTIVATE_TRIAL)
+            {
+                auto trial = path == ENDPOINT_ACTIVATE_TRIAL;
+                auto emailAddress = json.at ("email_address").get<std::string>();
+                auto licenseKey = trial ? std::string ("trial") : json.at ("license_key").get<std::string>();
+
+                return { 200,
+                         issue (
+                             crypto::genericHash (emailAddress + licenseKey),
+                             json.at ("product_uid").get<std::string>(),
+                             decodeFromBase64 (json.at ("machine_uid").get<std::string>()),
+                             trial ? License::Type::Trial : License::Type::Subscription,
+                             now)
+                             .toJson()
+                             .dump() };
+            }
+
+            if (path == ENDPOINT_UPDATE_ACTIVATIONS)
+            {
+                auto response = nlohmann::json::array();
+
+                for (auto& activation : json.get<std::vector<Activation>>())
+                {
+                    response.push_back (issue (
+                                            activation.getHash(),
+                                            activation.getProductUid(),
+                                            activation.getMachineUid(),
+                                            activation.getLicenseType(),
+                                            now)
+                                            .toJson());
+                }
+
+                return { 200, response.dump() };
+            }
+
+            if (path == ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH && supportsUpdatesByHash_)
+            {
+                auto productUid = json.at ("product_uid").get<std::string>();
+                auto machineUid = decodeFromBase64 (json.at ("machine_uid").get<std::string>());
+                auto response = nlohmann::json::array();
+
+                for (const auto& hash : json.at ("activation_hashes").get<std::vector<std::string>>())
+                {
+                    std::optional<IssuedActivation> activation;
+
+                    {
+                        std::lock_guard lock (mutex_);
+                        if (auto it = issued_.find (hash); it != issued_.end())
+                            activation = it->second;
+                    }
+
+                    // Unknown activations are left out of the response, which makes the client delete them.
+                    if (!activation || activation->productUid != productUid || activation->machineUid != machineUid)
+                        continue;
+
+                    response.push_back (
+                        issue (decodeFromBase64 (hash), productUid, machineUid, activation->type, now).toJson());
+                }
+
+                return { 200, response.dump() };
+            }
+
+            return { 404, R"({"error":"Not found"})" };
+        }
+        catch (const std::exception& e)
+        {
+            return { 400, nlohmann::json { { "error", e.what() } }.dump() };
+        }
+    }
+};
+
+} // namespace indiekey::test
@@ -0,0 +1,130 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+// Measures the ActivationStore backends on the operations ActivationClient performs: opening an existing store, saving
+// activations, picking the most valuable one and finding the activations which need an update. Prints one line per
+// backend and operation with the average time per call.
+
+#include "ActivationSigner.h"
+#include "indiekey/FileActivationStore.h"
+#include "indiekey/MemoryActivationStore.h"
+#include "indiekey/SqliteActivationStore.h"
+
+#include <juce_core/juce_core.h>
+
+#include <functional>
+#include <iostream>
+
+namespace
+{
+
+const std::string kProductUid = "benchmark";
+const std::vector<uint8_t> kMachineUid { 1, 2, 3, 4 };
+
+void report (const char* backend, const char* operation, int numCalls, double seconds)
+{
+    std::cout << backend << " " << operation << ": " << seconds * 1e6 / numCalls << " us/call (" << numCalls
+              << " calls)" << std::endl;
+}
+
+template <typename Function>
+double measure (Function&& function)
+{
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    function();
+    return (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+    auto numActivations = args.containsOption ("--activations")
+                              ? args.getValueForOption ("--activations").getIntValue()
+                              : 20;
+    auto numIterations = args.containsOption ("--iterations") ? args.getValueForOption ("--iterations").getIntValue()
+                                                              : 1000;
+
+    struct Backend
+    {
+        const char* name;
+        std::function<std::unique_ptr<indiekey::ActivationStore> (const juce::File&)> open;
+    };
+
+    const Backend backends[] = {
+        { "sqlite",
+          [] (const juce::File& file) {
+              return std::make_unique<indiekey::SqliteActivationStore> (file);
+          } },
+        { "memory",
+          [] (const juce::File&) {
+              return std::make_unique<indiekey::MemoryActivationStore>();
+          } },
+        { "file",
+          [] (const juce::File& file) {
+              return std::make_unique<indiekey::FileActivationStore> (file);
+          } },
+    };
+
+    juce::Random random (1);
+    const auto now = juce::Time::getCurrentTime();
+
+    std::vector<indiekey::Activation> activations;
+    for (int i = 0; i < numActivations; ++i)
+    {
+        activations.emplace_back (
+            indiekey::test::ActivationSigner::randomBytes (random, 32),
+            kProductUid,
+            kMachineUid,
+            now + juce::RelativeTime::days (random.nextInt (60)),
+            std::nullopt,
+            i % 4 == 0 ? indiekey::License::Type::Trial : indiekey::License::Type::Subscription,
+            indiekey::test::ActivationSigner::randomBytes (random, 64));
+    }
+
+    for (const auto& backend : backends)
+    {
+        auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                        .getNonexistentChildFile ("indiekey_benchmark", ".db", false);
+
+        {
+            auto store = backend.open (file);
+
+            report (backend.name, "saveActivation", numIterations, measure ([&] {
+                        for (int i = 0; i < numIterations; ++i)
+                            store->saveActivation (activations[static_cast<size_t> (i % numActivations)], now);
+                    }));
+
+            report (backend.name, "saveActivations", numIterations / 10, measure ([&] {
+                        for (int i = 0; i < numIterations / 10; ++i)
+                            store->saveActivations (activations, now);
+                    }));
+
+            report (backend.name, "getMostValuableActivation", numIterations, measure ([&] {
+                        for (int i = 0; i < numIterations; ++i)
+                            (void)store->getMostValuableActivation (kProductUid, kMachineUid, now);
+                    }));
+
+            report (backend.name, "getActivationsWhichNeedUpdate", numIterations, measure ([&] {
+                        for (int i = 0; i < numIterations; ++i)
+                            (void)store->getActivationsWhichNeedUpdate (kProductUid, kMachineUid, false, now);
+                    }));
+
+            report (backend.name, "runMaintenance", 1, measure ([&] {
+                        store->runMaintenance (now, true);
+                    }));
+        }
+
+        report (backend.name, "open", 1, measure ([&] {
+                    auto store = backend.open (file);
+                    (void)store->getNextUpdateTime (kProductUid, kMachineUid);
+                }));
+
+        file.deleteFile();
+    }
+
+    return 0;
+}
@@ -0,0 +1,374 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+// Acts like a fleet of installations towards an activation server, to size the server before launch. Virtual machines
+// with synthetic machine ids issue activate, trial and update requests at the configured rates, through RestClient and
+// the same request messages and Activation parsing as ActivationClient.
+//
+// Requests follow an open-loop schedule (Poisson arrivals per request type) which is worked off by a small pool of
+// threads. Latency is measured from the scheduled moment of a request, so that a server which falls behind also shows
+// up as latency instead of just a lower request rate. By default a local stand-in server answers the requests, pass
+// --server to target a real one. Updates are sent by hash, pass --full-updates to send the activations themselves.
+
+#include "StandInServer.h"
+#include "indiekey/Crypto.h"
+#include "indiekey/Encoding.h"
+#include "indiekey/Endpoints.h"
+#include "indiekey/RestClient.h"
+#include "indiekey/messages/ActivationRequest.h"
+#include "indiekey/messages/TrialRequest.h"
+#include "indiekey/messages/UpdateRequest.h"
+
+#include <juce_core/juce_core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+constexpr auto kProductUid = "load-generator-product";
+
+struct Config
+{
+    int numMachines = 10000;
+    double durationSeconds = 30.0;
+    double activateRate = 20.0; // Requests per second.
+    double trialRate = 10.0;
+    double updateRate = 200.0;
+    int numThreads = 16;
+    int numServerThreads = 8;
+    int serverDelayMs = 0;
+    bool fullUpdates = false; // Send the activations instead of their hashes, like older clients.
+    juce::String serverAddress; // Empty to use the stand-in server.
+    juce::int64 seed = 1;
+};
+
+enum class RequestType
+{
+    Activate,
+    Trial,
+    Update,
+};
+
+constexpr RequestType kRequestTypes[] = { RequestType::Activate, RequestType::Trial, RequestType::Update };
+
+const char* requestTypeToString (RequestType type)
+{
+    switch (type)
+    {
+        case RequestType::Activate:
+            return "activate";
+        case RequestType::Trial:
+            return "trial";
+        case RequestType::Update:
+            return "update";
+    }
+
+    return "";
+}
+
+struct VirtualMachine
+{
+    std::vector<uint8_t> machineUid;
+    std::string machineUidBase64;
+    std::mutex mutex;
+    std::vector<indiekey::Activation> activations; // Guarded by mutex.
+
+    void store (std::vector<indiekey::Activation> received)
+    {
+        std::lock_guard lock (mutex);
+
+        for (auto& activation : received)
+        {
+            auto it = std::find_if (activations.begin(), activations.end(), [&activation] (const auto& existing) {
+                return existing.getHash() == activation.getHash();
+            });
+
+            if (it != activations.end())
+                *it = std::move (activation);
+            else
+                activations.push_back (std::move (activation));
+        }
+    }
+};
+
+struct ScheduledRequest
+{
+    double atMs = 0.0; // Relative to the start of the run.
+    RequestType type = RequestType::Activate;
+    size_t machineIndex = 0;
+};
+
+struct Result
+{
+    RequestType type = RequestType::Activate;
+    double latencyMs = 0.0; // From the scheduled moment until the response was parsed.
+    bool succeeded = false;
+    bool skipped = false; // Update for a machine without activations.
+};
+
+std::vector<ScheduledRequest> createSchedule (const Config& config, juce::Random& random)
+{
+    std::vector<ScheduledRequest> schedule;
+
+    const std::pair<RequestType, double> rates[] = {
+        { RequestType::Activate, config.activateRate },
+        { RequestType::Trial, config.trialRate },
+        { RequestType::Update, config.updateRate },
+    };
+
+    for (auto [type, rate] : rates)
+    {
+        if (rate <= 0.0)
+            continue;
+
+        // Exponentially distributed gaps give a Poisson process, like independent installations do.
+        for (auto atMs = 0.0;;)
+        {
+            atMs += -std::log (1.0 - random.nextDouble()) / rate * 1000.0;
+
+            if (atMs >= config.durationSeconds * 1000.0)
+                break;
+
+            schedule.push_back ({ atMs, type, static_cast<size_t> (random.nextInt (config.numMachines)) });
+        }
+    }
+
+    std::sort (schedule.begin(), schedule.end(), [] (const auto& a, const auto& b) {
+        return a.atMs < b.atMs;
+    });
+
+    return schedule;
+}
+
+/**
+ * Sends a single request like ActivationClient does.
+ * @returns False if the request was skipped.
+ */
+bool sendRequest (
+    indiekey::RestClient& restClient,
+    VirtualMachine& machine,
+    size_t machineIndex,
+    RequestType type,
+    bool fullUpdates)
+{
+    auto emailAddress = "machine-" + std::to_string (machineIndex) + "@example.com";
+    static const std::optional<std::string> deviceInfo ("IndieKey load generator");
+
+    if (type == RequestType::Activate)
+    {
+        indiekey::ActivationRequest request (
+            kProductUid,
+            machine.machineUidBase64,
+            emailAddress,
+            "LICENSE-" + std::to_string (machineIndex),
+            deviceInfo);
+
+        auto response = restClient.post (ENDPOINT_ACTIVATE, request);
+        response.throwIfNotSuccessful();
+        machine.store ({ nlohmann::json::parse (response.body.toRawUTF8()).get<indiekey::Activation>() });
+        return true;
+    }
+
+    if (type == RequestType::Trial)
+    {
+        indiekey::TrialRequest request (kProductUid, machine.machineUidBase64, emailAddress, deviceInfo);
+
+        auto response = restClient.post (ENDPOINT_ACTIVATE_TRIAL, request);
+        response.throwIfNotSuccessful();
+        machine.store ({ nlohmann::json::parse (response.body.toRawUTF8()).get<indiekey::Activation>() });
+        return true;
+    }
+
+    std::vector<indiekey::Activation> activations;
+
+    {
+        std::lock_guard lock (machine.mutex);
+        activations = machine.activations;
+    }
+
+    if (activations.empty())
+        return false;
+
+    std::vector<std::string> hashes;
+    for (const auto& activation : activations)
+        hashes.push_back (indiekey::encodeToBase64 (activation.getHash()));
+
+    indiekey::UpdateRequest const updateRequest (kProductUid, machine.machineUidBase64, std::move (hashes));
+
+    auto response = fullUpdates ? restClient.post (ENDPOINT_UPDATE_ACTIVATIONS, activations)
+                                : restClient.post (ENDPOINT_UPDATE_ACTIVATIONS_BY_HASH, updateRequest);
+    response.throwIfNotSuccessful();
+    machine.store (nlohmann::json::parse (response.body.toRawUTF8()).get<std::vector<indiekey::Activation>>());
+    return true;
+}
+
+double percentile (const std::vector<double>& sortedValues, double fraction)
+{
+    if (sortedValues.empty())
+        return 0.0;
+
+    auto index = static_cast<size_t> (fraction * static_cast<double> (sortedValues.size() - 1) + 0.5);
+    return sortedValues[std::min (index, sortedValues.size() - 1)];
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    indiekey::crypto::init();
+
+    juce::ArgumentList args (argc, argv);
+
+    auto getOption = [&args] (const char* option, auto defaultValue) {
+        return args.containsOption (option)
+                   ? static_cast<decltype (defaultValue)> (args.getValueForOption (option).getDoubleValue())
+                   : defaultValue;
+    };
+
+    Config config;
+    config.numMachines = std::max (1, getOption ("--machines", config.numMachines));
+    config.durationSeconds = getOption ("--duration", config.durationSeconds);
+    config.activateRate = getOption ("--activate-rate", config.activateRate);
+    config.trialRate = getOption ("--trial-rate", config.trialRate);
+    config.updateRate = getOption ("--update-rate", config.updateRate);
+    config.numThreads = std::max (1, getOption ("--threads", config.numThreads));
+    config.numServerThreads = std::max (1, getOption ("--server-threads", config.numServerThreads));
+    config.serverDelayMs = getOption ("--server-delay-ms", config.serverDelayMs);
+    config.seed = getOption ("--seed", config.seed);
+
+    config.fullUpdates = args.containsOption ("--full-updates");
+
+    if (args.containsOption ("--server"))
+        config.serverAddress = args.getValueForOption ("--server");
+
+    std::unique_ptr<indiekey::test::StandInServer> standInServer;
+
+    if (config.serverAddress.isEmpty())
+    {
+        standInServer = std::make_unique<indiekey::test::StandInServer> (config.numServerThreads, config.serverDelayMs);
+        config.serverAddress = standInServer->getAddress();
+    }
+
+    juce::Random random (config.seed);
+    auto now = juce::Time::getCurrentTime();
+
+    std::vector<std::unique_ptr<VirtualMachine>> machines;
+
+    for (int i = 0; i < config.numMachines; ++i)
+    {
+        auto& machine = machines.emplace_back (std::make_unique<VirtualMachine>());
+        machine->machineUid = indiekey::test::ActivationSigner::randomBytes (random, 32);
+        machine->machineUidBase64 = indiekey::encodeToBase64 (machine->machineUid);
+
+        // Installations which activated before the run, so that update traffic starts right away. Only possible when
+        // the stand-in server signs the activations.
+        if (standInServer != nullptr)
+        {
+            machine->activations.push_back (standInServer->issue (
+                indiekey::test::ActivationSigner::randomBytes (random, 32),
+                kProductUid,
+                machine->machineUid,
+                indiekey::License::Type::Subscription,
+                now));
+        }
+    }
+
+    auto schedule = createSchedule (config, random);
+
+    std::cout << "Sending " << schedule.size() << " requests from " << config.numMachines << " machines over "
+              << config.durationSeconds << " s to " << config.serverAddress << " using " << config.numThreads
+              << " threads" << std::endl;
+
+    std::atomic<size_t> nextRequest { 0 };
+    std::vector<std::vector<Result>> resultsPerThread (static_cast<size_t> (config.numThreads));
+    std::vector<std::thread> threads;
+
+    auto startedAt = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto& results : resultsPerThread)
+    {
+        threads.emplace_back ([&, &results = results] {
+            indiekey::RestClient restClient { juce::URL (config.serverAddress) };
+
+            for (auto index = nextRequest++; index < schedule.size(); index = nextRequest++)
+            {
+                const auto& request = schedule[index];
+                auto scheduledAt = startedAt + request.atMs;
+
+                if (auto waitMs = scheduledAt - juce::Time::getMillisecondCounterHiRes(); waitMs > 1.0)
+                    std::this_thread::sleep_for (std::chrono::duration<double, std::milli> (waitMs));
+
+                Result result;
+                result.type = request.type;
+
+                try
+                {
+                    result.skipped = !sendRequest (
+                        restClient,
+                        *machines[request.machineIndex],
+                        request.machineIndex,
+                        request.type,
+                        config.fullUpdates);
+                    result.succeeded = true;
+                }
+                catch (const std::exception&)
+                {
+                }
+
+                result.latencyMs = juce::Time::getMillisecondCounterHiRes() - scheduledAt;
+                results.push_back (result);
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startedAt) / 1000.0;
+
+    size_t numCompleted = 0;
+
+    for (auto type : kRequestTypes)
+    {
+        std::vector<double> latencies;
+        size_t numFailed = 0;
+        size_t numSkipped = 0;
+
+        for (auto& results : resultsPerThread)
+        {
+            for (auto& result : results)
+            {
+                if (result.type != type)
+                    continue;
+
+                if (!result.succeeded)
+                    numFailed++;
+                else if (result.skipped)
+                    numSkipped++;
+                else
+                    latencies.push_back (result.latencyMs);
+            }
+        }
+
+        std::sort (latencies.begin(), latencies.end());
+        numCompleted += latencies.size();
+
+        std::cout << requestTypeToString (type) << ": " << latencies.size() << " ok, " << numFailed << " failed, "
+                  << numSkipped << " skipped, " << static_cast<double> (latencies.size()) / elapsedSeconds
+                  << " req/s, latency (ms) p50 " << percentile (latencies, 0.5) << ", p99 "
+                  << percentile (latencies, 0.99) << ", p999 " << percentile (latencies, 0.999) << ", max "
+                  << percentile (latencies, 1.0) << std::endl;
+    }
+
+    std::cout << "Throughput: " << static_cast<double> (numCompleted) / elapsedSeconds << " req/s over "
+              << elapsedSeconds << " s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,318 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+// Replays months of activation, expiry and refresh cycles for a fleet of simulated machines against a virtual clock.
+// Every simulated launch runs the same database and activation logic as
+// ActivationClient::validate (ValidationStrategy::Online). The server side is a simple model which renews or lapses
+// subscriptions, ends trials and re-signs activations on every update request.
+//
+// Reported are the request volume towards the server and the time it takes for a change on the server (renewal,
+// lapse) to show up as the status on the machine (time-to-status).
+
+#include "ActivationSigner.h"
+#include "indiekey/ActivationsDatabase.h"
+#include "indiekey/Clock.h"
+#include "indiekey/Crypto.h"
+
+#include <juce_core/juce_core.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+
+constexpr auto kProductUid = "simulated-product";
+
+struct Config
+{
+    int numMachines = 2000;
+    int numDays = 180;
+    double launchesPerDay = 1.0;
+    double perpetualShare = 0.4;
+    double subscriptionShare = 0.4; // The rest are trials.
+    double renewalProbability = 0.9;
+    juce::int64 seed = 1;
+
+    juce::RelativeTime step = juce::RelativeTime::hours (1);
+    juce::RelativeTime subscriptionPeriod = juce::RelativeTime::days (30);
+    juce::RelativeTime trialPeriod = juce::RelativeTime::days (14);
+    juce::RelativeTime activationValidity = juce::RelativeTime::days (14);
+    juce::RelativeTime installWindow = juce::RelativeTime::days (30);
+    juce::RelativeTime renewalSpread = juce::RelativeTime::days (2);
+};
+
+/**
+ * The server side state of the license of a single machine.
+ */
+struct SimulatedLicense
+{
+    indiekey::License::Type type = indiekey::License::Type::Undefined;
+    std::optional<juce::Time> expiresAt;
+    std::optional<juce::Time> nextRenewalAt;
+};
+
+struct SimulatedMachine
+{
+    std::vector<uint8_t> machineUid;
+    indiekey::Activation::Hash activationHash;
+    juce::Time installAt;
+    bool installed = false;
+    SimulatedLicense license;
+    bool lastKnownServerValid = false;
+    std::optional<juce::Time> pendingChangeAt; // Set when the server changed and the machine didn't notice yet.
+};
+
+struct Metrics
+{
+    juce::int64 validations = 0;
+    juce::int64 updateRequests = 0;
+    juce::int64 activationsSent = 0;
+    juce::int64 staleValidations = 0;
+    std::vector<double> timeToStatusHours;
+};
+
+class Simulation
+{
+public:
+    explicit Simulation (Config config) : config_ (config), random_ (config.seed), clock_ (juce::Time (0))
+    {
+        database_.openDatabase (indiekey::ActivationsDatabase::Options { {}, false, true });
+
+        auto start = clock_.now();
+
+        for (int i = 0; i < config_.numMachines; ++i)
+        {
+            SimulatedMachine machine;
+            machine.machineUid = indiekey::test::ActivationSigner::randomBytes (random_, 32);
+            machine.activationHash = indiekey::test::ActivationSigner::randomBytes (random_, 32);
+            machine.installAt = start + juce::RelativeTime (config_.installWindow.inSeconds() * random_.nextDouble());
+
+            auto type = random_.nextDouble();
+            if (type < config_.perpetualShare)
+                machine.license.type = indiekey::License::Type::Perpetual;
+            else if (type < config_.perpetualShare + config_.subscriptionShare)
+                machine.license.type = indiekey::License::Type::Subscription;
+            else
+                machine.license.type = indiekey::License::Type::Trial;
+
+            machines_.push_back (std::move (machine));
+        }
+    }
+
+    Metrics run()
+    {
+        auto end = clock_.now() + juce::RelativeTime::days (config_.numDays);
+        auto launchProbability = config_.launchesPerDay * config_.step.inHours() / 24.0;
+
+        while (clock_.now() < end)
+        {
+            auto now = clock_.now();
+
+            for (auto& machine : machines_)
+            {
+                if (!machine.installed)
+                {
+                    if (machine.installAt <= now)
+                        install (machine, now);
+                    continue;
+                }
+
+                runServerEvents (machine, now);
+
+                if (random_.nextDouble() < launchProbability)
+                    launch (machine, now);
+            }
+
+            clock_.advance (config_.step);
+        }
+
+        return metrics_;
+    }
+
+private:
+    Config config_;
+    juce::Random random_;
+    indiekey::ManualClock clock_;
+    indiekey::test::ActivationSigner signer_;
+    indiekey::ActivationsDatabase database_;
+    std::vector<SimulatedMachine> machines_;
+    Metrics metrics_;
+
+    static bool isValidOnServer (const SimulatedLicense& license, juce::Time now)
+    {
+        return !license.expiresAt.has_value() || now <= *license.expiresAt;
+    }
+
+    [[nodiscard]] indiekey::Activation issueActivation (const SimulatedMachine& machine, juce::Time now) const
+    {
+        std::optional<juce::Time> expiresAt;
+
+        if (machine.license.type != indiekey::License::Type::Perpetual)
+        {
+            expiresAt = now + config_.activationValidity;
+            if (machine.license.expiresAt.has_value())
+                expiresAt = std::min (*expiresAt, *machine.license.expiresAt);
+        }
+
+        return signer_.sign (
+            machine.activationHash,
+            kProductUid,
+            machine.machineUid,
+            expiresAt,
+            machine.license.expiresAt,
+            machine.license.type);
+    }
+
+    void install (SimulatedMachine& machine, juce::Time now)
+    {
+        auto& license = machine.license;
+
+        if (license.type == indiekey::License::Type::Subscription)
+        {
+            license.expiresAt = now + config_.subscriptionPeriod;
+            scheduleRenewal (license);
+        }
+        else if (license.type == indiekey::License::Type::Trial)
+        {
+            license.expiresAt = now + config_.trialPeriod;
+        }
+
+        database_.saveActivation (issueActivation (machine, now), now);
+        machine.installed = true;
+        machine.lastKnownServerValid = true;
+    }
+
+    void scheduleRenewal (SimulatedLicense& license)
+    {
+        jassert (license.expiresAt.has_value());
+
+        if (random_.nextDouble() < config_.renewalProbability)
+        {
+            auto spread = config_.renewalSpread.inSeconds() * (random_.nextDouble() * 2.0 - 1.0);
+            license.nextRenewalAt = *license.expiresAt + juce::RelativeTime (spread);
+        }
+        else
+        {
+            license.nextRenewalAt.reset(); // Lapses
+        }
+    }
+
+    void runServerEvents (SimulatedMachine& machine, juce::Time now)
+    {
+        auto& license = machine.license;
+
+        if (license.nextRenewalAt.has_value() && *license.nextRenewalAt <= now)
+        {
+            license.expiresAt = std::max (*license.expiresAt, *license.nextRenewalAt) + config_.subscriptionPeriod;
+            scheduleRenewal (license);
+        }
+
+        auto serverValid = isValidOnServer (license, now);
+
+        if (serverValid != machine.lastKnownServerValid)
+        {
+            machine.lastKnownServerValid = serverValid;
+            if (!machine.pendingChangeAt.has_value())
+                machine.pendingChangeAt = now;
+        }
+    }
+
+    /**
+     * Mirrors ActivationClient::validate (ValidationStrategy::Online) against the simulated server.
+     */
+    void launch (SimulatedMachine& machine, juce::Time now)
+    {
+        auto requestActivations = database_.getActivationsWhichNeedUpdate (
+            kProductUid,
+            machine.machineUid,
+            false,
+            now);
+
+        if (!requestActivations.empty())
+        {
+            metrics_.updateRequests++;
+            metrics_.activationsSent += static_cast<juce::int64> (requestActivations.size());
+
+            // Every simulated machine holds a single activation, which the simulated server re-signs.
+            database_.saveActivation (issueActivation (machine, now), now);
+        }
+
+        auto mostValuable = database_.getMostValuableActivation (kProductUid, machine.machineUid, now);
+
+        auto clientValid = mostValuable.has_value() &&
+                           mostValuable->validate (kProductUid, machine.machineUid, signer_.getVerifyingKey(), now) ==
+                               indiekey::Activation::Status::Valid;
+
+        metrics_.validations++;
+
+        if (clientValid != isValidOnServer (machine.license, now))
+        {
+            metrics_.staleValidations++;
+        }
+        else if (machine.pendingChangeAt.has_value())
+        {
+            metrics_.timeToStatusHours.push_back ((now - *machine.pendingChangeAt).inHours());
+            machine.pendingChangeAt.reset();
+        }
+    }
+};
+
+double percentile (std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+
+    std::sort (values.begin(), values.end());
+    auto index = static_cast<size_t> (fraction * static_cast<double> (values.size() - 1) + 0.5);
+    return values[std::min (index, values.size() - 1)];
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    indiekey::crypto::init();
+
+    juce::ArgumentList args (argc, argv);
+
+    auto getOption = [&args] (const char* option, auto defaultValue) {
+        return args.containsOption (option)
+                   ? static_cast<decltype (defaultValue)> (args.getValueForOption (option).getDoubleValue())
+                   : defaultValue;
+    };
+
+    Config config;
+    config.numMachines = getOption ("--machines", config.numMachines);
+    config.numDays = getOption ("--days", config.numDays);
+    config.launchesPerDay = getOption ("--launches-per-day", config.launchesPerDay);
+    config.renewalProbability = getOption ("--renewal-probability", config.renewalProbability);
+    config.seed = getOption ("--seed", config.seed);
+
+    auto startedAt = juce::Time::getMillisecondCounterHiRes();
+
+    Simulation simulation (config);
+    auto metrics = simulation.run();
+
+    auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startedAt) / 1000.0;
+    auto machineDays = static_cast<double> (config.numMachines) * config.numDays;
+
+    std::cout << "Simulated " << config.numMachines << " machines over " << config.numDays << " days in "
+              << elapsedSeconds << " s" << std::endl;
+    std::cout << "Validations:            " << metrics.validations << std::endl;
+    std::cout << "Update requests:        " << metrics.updateRequests << " ("
+              << static_cast<double> (metrics.updateRequests) / machineDays << " per machine per day)" << std::endl;
+    std::cout << "Activations sent:       " << metrics.activationsSent << std::endl;
+    std::cout << "Stale validations:      " << metrics.staleValidations << " ("
+              << 100.0 * static_cast<double> (metrics.staleValidations) /
+                     static_cast<double> (std::max<juce::int64> (metrics.validations, 1))
+              << " %)" << std::endl;
+    std::cout << "Time-to-status (hours): p50 " << percentile (metrics.timeToStatusHours, 0.5) << ", p90 "
+              << percentile (metrics.timeToStatusHours, 0.9) << ", p99 " << percentile (metrics.timeToStatusHours, 0.99)
+              << ", max " << percentile (metrics.timeToStatusHours, 1.0) << " (" << metrics.timeToStatusHours.size()
+              << " changes)" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+// Hammers a single ActivationClient from many threads at once: validations, installs, reads, trial status queries and
+// subscriber changes, while the main thread runs the message loop which delivers notifications. Meant to be run as the
+// ThreadSanitizer build (indiekey_client_stress_tsan), which reports any data race. The server is never contacted.
+
+#include "ActivationSigner.h"
+#include "indiekey/ActivationClient.h"
+#include "indiekey/Crypto.h"
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <iostream>
+#include <thread>
+
+namespace
+{
+
+class Subscriber : public indiekey::ActivationClient::Subscriber
+{
+public:
+    std::atomic<int> numCalls { 0 };
+
+    void onActivationsUpdated (const indiekey::Activation* mostValuableActivation) override
+    {
+        if (mostValuableActivation != nullptr)
+            (void)mostValuableActivation->getStatus();
+        numCalls++;
+    }
+};
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    indiekey::crypto::init();
+
+    juce::ArgumentList args (argc, argv);
+    auto numThreads = args.containsOption ("--threads") ? args.getValueForOption ("--threads").getIntValue() : 8;
+    auto numIterations = args.containsOption ("--iterations") ? args.getValueForOption ("--iterations").getIntValue()
+                                                              : 2000;
+
+    indiekey::test::ActivationSigner signer;
+    auto machineUid = indiekey::crypto::genericHash (juce::SystemStats::getUniqueDeviceID().toStdString());
+
+    indiekey::ProductData productData;
+    productData.productUid = "stress";
+    productData.verifyingKey = signer.getVerifyingKey();
+    productData.primaryPublicServerAddress = "http://localhost:1"; // Must not be contacted.
+
+    indiekey::ActivationClient client;
+    client.setProductData (productData, indiekey::ActivationsDatabase::Options { {}, false, true });
+
+    std::atomic<int> numFinishedThreads { 0 };
+    std::atomic<int> numErrors { 0 };
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back ([&, t] {
+            juce::Random random (t);
+            Subscriber subscriber;
+
+            for (int i = 0; i < numIterations; ++i)
+            {
+                try
+                {
+                    switch (random.nextInt (8))
+                    {
+                    case 0:
+                        client.validate (indiekey::ActivationClient::ValidationStrategy::LocalOnly);
+                        break;
+                    case 1:
+                        // Activations are perpetual and were just saved, so nothing needs an update online.
+                        client.validate (indiekey::ActivationClient::ValidationStrategy::Online);
+                        break;
+                    case 2:
+                        client.installActivation (signer.sign (
+                            indiekey::test::ActivationSigner::randomBytes (random, 32),
+                            productData.productUid,
+                            machineUid,
+                            std::nullopt,
+                            std::nullopt,
+                            indiekey::License::Type::Perpetual));
+                        break;
+                    case 3:
+                        (void)client.getActivationStatus();
+                        break;
+                    case 4:
+                        if (auto activation = client.getLoadedActivation())
+                            (void)activation->getSummary();
+                        break;
+                    case 5:
+                        (void)client.getTrialStatus();
+                        break;
+                    case 6:
+                        client.addListener (&subscriber);
+                        client.removeListener (&subscriber);
+                        break;
+                    case 7:
+                        if (random.nextInt (50) == 0)
+                            client.destroyAllLocalActivations();
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Thread " << t << ": " << e.what() << std::endl;
+                    numErrors++;
+                }
+            }
+
+            client.removeListener (&subscriber);
+            numFinishedThreads++;
+        });
+    }
+
+    Subscriber mainSubscriber;
+    client.addListener (&mainSubscriber);
+
+    while (numFinishedThreads < numThreads)
+        juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+
+    for (auto& thread : threads)
+        thread.join();
+
+    juce::MessageManager::getInstance()->runDispatchLoopUntil (50);
+    client.removeListener (&mainSubscriber);
+
+    std::cout << numThreads << " threads x " << numIterations << " iterations, " << mainSubscriber.numCalls
+              << " notifications, " << numErrors << " errors" << std::endl;
+
+    return numErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+//
+// Created by Ruurd Adema on 18/10/2026.
+// Copyright (c) 2025 IndieKey LTD. All rights reserved.
+//
+
+// Mimics a DAW plugin scan: many ActivationClients are constructed at once, in this process and in a number of child
+// processes (like scanners running side by side), all against one activations database. Every client calls
+// setProductData followed by validate (LocalValidOnly), which is what a plugin does when it is instantiated.
+//
+// Reported are the time-to-first-status percentiles over all clients, the number of queries which gave up on a locked
+// database (SQLITE_BUSY, see SqliteActivationStore::getNumBusyErrors) and the peak resident memory per process. The
+// server is never contacted.
+
+#include "ActivationSigner.h"
+#include "indiekey/ActivationClient.h"
+#include "indiekey/Crypto.h"
+#include "indiekey/Encoding.h"
+#include "indiekey/SqliteActivationStore.h"
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#if JUCE_WINDOWS
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace
+{
+
+constexpr auto kProductUid = "plugin-scan";
+constexpr auto kResultPrefix = "RESULT ";
+
+/**
+ * The measurements of a single process.
+ */
+struct ProcessResult
+{
+    std::vector<double> timeToFirstStatusMs;
+    int numFailedClients = 0;
+    juce::int64 numBusyErrors = 0;
+    juce::int64 peakResidentBytes = 0;
+
+    [[nodiscard]] nlohmann::json toJson() const
+    {
+        return { { "time_to_first_status_ms", timeToFirstStatusMs },
+                 { "failed_clients", numFailedClients },
+                 { "busy_errors", numBusyErrors },
+                 { "peak_resident_bytes", peakResidentBytes } };
+    }
+
+    static ProcessResult fromJson (const nlohmann::json& json)
+    {
+        ProcessResult result;
+        result.timeToFirstStatusMs = json.at ("time_to_first_status_ms").get<std::vector<double>>();
+        result.numFailedClients = json.at ("failed_clients").get<int>();
+        result.numBusyErrors = json.at ("busy_errors").get<juce::int64>();
+        result.peakResidentBytes = json.at ("peak_resident_bytes").get<juce::int64>();
+        return result;
+    }
+};
+
+juce::int64 getPeakResidentBytes()
+{
+#if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (K32GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+        return static_cast<juce::int64> (counters.PeakWorkingSetSize);
+    return 0;
+#else
+    rusage usage {};
+    getrusage (RUSAGE_SELF, &usage);
+    #if JUCE_MAC
+    return static_cast<juce::int64> (usage.ru_maxrss); // Bytes on macOS.
+    #else
+    return static_cast<juce::int64> (usage.ru_maxrss) * 1024; // KiB on Linux.
+    #endif
+#endif
+}
+
+/**
+ * Instantiates given number of clients at once, each on its own thread, and keeps them alive until all measured their
+ * time-to-first-status, like a scan which holds many plugin instances.
+ */
+ProcessResult runClients (const indiekey::ProductData& productData, const juce::File& databaseFile, int numClients)
+{
+    std::vector<std::unique_ptr<indiekey::ActivationClient>> clients (static_cast<size_t> (numClients));
+    std::vector<double> timeToFirstStatusMs (clients.size(), -1.0);
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    bool go = false;
+
+    for (size_t i = 0; i < clients.size(); ++i)
+    {
+        threads.emplace_back ([&, i] {
+            {
+                std::unique_lock lock (mutex);
+                started.wait (lock, [&go] {
+                    return go;
+                });
+            }
+
+            auto startedAt = juce::Time::getMillisecondCounterHiRes();
+
+            try
+            {
+                clients[i] = std::make_unique<indiekey::ActivationClient>();
+                clients[i]->setProductData (productData, indiekey::ActivationsDatabase::Options { databaseFile });
+                clients[i]->validate (indiekey::ActivationClient::ValidationStrategy::LocalValidOnly);
+
+                if (clients[i]->getActivationStatus() == indiekey::Activation::Status::Valid)
+                    timeToFirstStatusMs[i] = juce::Time::getMillisecondCounterHiRes() - startedAt;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Client " << i << ": " << e.what() << std::endl;
+            }
+        });
+    }
+
+    {
+        std::lock_guard lock (mutex);
+        go = true;
+    }
+
+    started.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    ProcessResult result;
+
+    for (auto time : timeToFirstStatusMs)
+    {
+        if (time < 0.0)
+            result.numFailedClients++;
+        else
+            result.timeToFirstStatusMs.push_back (time);
+    }
+
+    result.numBusyErrors = indiekey::SqliteActivationStore::getNumBusyErrors();
+    result.peakResidentBytes = getPeakResidentBytes();
+
+    clients.clear();
+    juce::MessageManager::getInstance()->runDispatchLoopUntil (10); // Drops pending notifications.
+
+    return result;
+}
+
+double percentile (const std::vector<double>& sortedValues, double fraction)
+{
+    if (sortedValues.empty())
+        return 0.0;
+
+    auto index = static_cast<size_t> (fraction * static_cast<double> (sortedValues.size() - 1) + 0.5);
+    return sortedValues[std::min (index, sortedValues.size() - 1)];
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    indiekey::crypto::init();
+
+    juce::ArgumentList args (argc, argv);
+    auto numClients = args.containsOption ("--clients") ? args.getValueForOption ("--clients").getIntValue() : 64;
+    auto numProcesses = args.containsOption ("--processes") ? args.getValueForOption ("--processes").getIntValue()
+                                                            : 4;
+
+    indiekey::ProductData productData;
+    productData.productUid = kProductUid;
+    productData.primaryPublicServerAddress = "http://localhost:1"; // Must not be contacted.
+
+    // A child process, started by the parent below.
+    if (args.containsOption ("--child"))
+    {
+        productData.verifyingKey = indiekey::decodeFromBase64 (
+            args.getValueForOption ("--verifying-key").toStdString());
+
+        auto result = runClients (productData, juce::File (args.getValueForOption ("--database")), numClients);
+        std::cout << kResultPrefix << result.toJson().dump() << std::endl;
+        return 0;
+    }
+
+    indiekey::test::ActivationSigner signer;
+    productData.verifyingKey = signer.getVerifyingKey();
+
+    auto databaseFile = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                            .getNonexistentChildFile ("indiekey_plugin_scan", ".db", false);
+
+    {
+        indiekey::ActivationsDatabase database;
+        database.openDatabase ({ databaseFile });
+        database.saveActivation (
+            signer.sign (
+                indiekey::crypto::genericHash (std::string ("plugin-scan-license")),
+                kProductUid,
+                indiekey::crypto::genericHash (juce::SystemStats::getUniqueDeviceID().toStdString()),
+                std::nullopt,
+                std::nullopt,
+                indiekey::License::Type::Perpetual),
+            juce::Time::getCurrentTime());
+    }
+
+    std::cout << "Starting " << numClients << " clients in each of " << numProcesses + 1 << " processes against "
+              << databaseFile.getFullPathName() << std::endl;
+
+    juce::OwnedArray<juce::ChildProcess> children;
+
+    for (int i = 0; i < numProcesses; ++i)
+    {
+        juce::StringArray command {
+            juce::File::getSpecialLocation (juce::File::currentExecutableFile).getFullPathName(),
+            "--child",
+            "--clients=" + juce::String (numClients),
+            "--database=" + databaseFile.getFullPathName(),
+            "--verifying-key=" + juce::String (indiekey::encodeToBase64 (signer.getVerifyingKey())),
+        };
+
+        auto* child = children.add (new juce::ChildProcess());
+        if (!child->start (command, juce::ChildProcess::wantStdOut))
+            std::cerr << "Failed to start child process " << i << std::endl;
+    }
+
+    std::vector<ProcessResult> results { runClients (productData, databaseFile, numClients) };
+
+    for (auto* child : children)
+    {
+        auto output = child->readAllProcessOutput();
+        auto line = output.fromFirstOccurrenceOf (kResultPrefix, false, false)
+                        .upToFirstOccurrenceOf ("\n", false, false);
+
+        try
+        {
+            results.push_back (ProcessResult::fromJson (nlohmann::json::parse (line.toStdString())));
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Child process didn't report results: " << e.what() << std::endl;
+            results.push_back ({ {}, numClients });
+        }
+    }
+
+    std::vector<double> times;
+    int numFailedClients = 0;
+    juce::int64 numBusyErrors = 0;
+    juce::int64 maxPeakResidentBytes = 0;
+
+    for (const auto& result : results)
+    {
+        times.insert (times.end(), result.timeToFirstStatusMs.begin(), result.timeToFirstStatusMs.end());
+        numFailedClients += result.numFailedClients;
+        numBusyErrors += result.numBusyErrors;
+        maxPeakResidentBytes = std::max (maxPeakResidentBytes, result.peakResidentBytes);
+    }
+
+    std::sort (times.begin(), times.end());
+
+    std::cout << "Time-to-first-status (ms): p50 " << percentile (times, 0.5) << ", p99 " << percentile (times, 0.99)
+              << ", max " << percentile (times, 1.0) << " (" << times.size() << " clients)" << std::endl;
+    std::cout << "Failed clients:            " << numFailedClients << std::endl;
+    std::cout << "SQLITE_BUSY errors:        " << numBusyErrors << std::endl;
+    std::cout << "Peak RSS per process (MB): max " << static_cast<double> (maxPeakResidentBytes) / (1024.0 * 1024.0)
+              << ", this process " << static_cast<double> (results.front().peakResidentBytes) / (1024.0 * 1024.0)
+              << std::endl;
+
+    for (const auto& suffix : { "", "-wal", "-shm" })
+        juce::File (databaseFile.getFullPathName() + suffix).deleteFile();
+
+    return numFailedClients == 0 ? 0 : 1;
+}